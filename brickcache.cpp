@@ -0,0 +1,346 @@
+#include "brickcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+BrickResidency::BrickResidency(int brickCount, int slotCount)
+    : m_slotOfBrick(brickCount, NO_BRICK), m_brickOfSlot(slotCount, NO_BRICK),
+      m_lastUsed(slotCount, 0)
+{
+}
+
+std::vector<BrickResidency::Assignment>
+BrickResidency::update(std::span<const unsigned int> usage, int maxLoads)
+{
+    m_frame++;
+    std::vector<int> requests;
+    for (int brick = 0; brick < static_cast<int>(usage.size()); brick++)
+    {
+        if (!usage[brick])
+            continue;
+        if (m_slotOfBrick[brick] != NO_BRICK)
+            m_lastUsed[m_slotOfBrick[brick]] = m_frame;
+        else
+            requests.push_back(brick);
+    }
+
+    std::vector<Assignment> assignments;
+    for (int brick : requests)
+    {
+        if (static_cast<int>(assignments.size()) == maxLoads)
+            break;
+        int slot = leastRecentlyUsedSlot();
+        // Every slot holds a brick the last frame needed, the working set
+        // does not fit into the atlas.
+        if (slot == NO_BRICK)
+            break;
+        int evictedBrick = m_brickOfSlot[slot];
+        if (evictedBrick != NO_BRICK)
+            m_slotOfBrick[evictedBrick] = NO_BRICK;
+        m_brickOfSlot[slot] = brick;
+        m_slotOfBrick[brick] = slot;
+        m_lastUsed[slot] = m_frame;
+        assignments.push_back({brick, slot, evictedBrick});
+    }
+    m_requestsPending = assignments.size() < requests.size();
+    return assignments;
+}
+
+int BrickResidency::leastRecentlyUsedSlot() const
+{
+    auto slot = std::min_element(m_lastUsed.begin(), m_lastUsed.end());
+    if (*slot == m_frame)
+        return NO_BRICK;
+    return static_cast<int>(std::distance(m_lastUsed.begin(), slot));
+}
+
+BrickCache::BrickCache()
+    : m_atlas(QOpenGLTexture::Target3D), m_pageTable(QOpenGLTexture::Target3D)
+{
+}
+
+void BrickCache::allocate(std::shared_ptr<const VolumeData> volumeData)
+{
+    initializeOpenGLFunctions();
+    reset();
+    m_volumeData = std::move(volumeData);
+
+    const std::array<int, 3> dims{m_volumeData->width(), m_volumeData->height(),
+                                  m_volumeData->depth()};
+    for (int i = 0; i < 3; i++)
+    {
+        m_brickCount[i] = (dims[i] + BRICK_SIZE - 1) / BRICK_SIZE;
+    }
+    const int brickCount = m_brickCount[0] * m_brickCount[1] * m_brickCount[2];
+
+    // A cube of slots within the atlas budget, but never more slots along an
+    // axis than there are bricks, and no more than a page table entry holds.
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+    const qint64 slotBytes =
+        static_cast<qint64>(SLOT_SIZE) * SLOT_SIZE * SLOT_SIZE * 2;
+    const int slotsPerAxis = std::clamp(
+        static_cast<int>(std::cbrt(static_cast<double>(ATLAS_BYTES / slotBytes))),
+        1, std::min(255, maxTextureSize / SLOT_SIZE));
+    for (int i = 0; i < 3; i++)
+    {
+        m_slotCount[i] = std::min(slotsPerAxis, m_brickCount[i]);
+    }
+    const int slotCount = m_slotCount[0] * m_slotCount[1] * m_slotCount[2];
+    m_residency = std::make_unique<BrickResidency>(brickCount, slotCount);
+    m_brickBuffer.resize(static_cast<std::size_t>(SLOT_SIZE) * SLOT_SIZE *
+                         SLOT_SIZE);
+
+    m_atlas.setBorderColor(0, 0, 0, 0);
+    m_atlas.setWrapMode(QOpenGLTexture::ClampToBorder);
+    m_atlas.setFormat(QOpenGLTexture::R16F);
+    m_atlas.setMinificationFilter(QOpenGLTexture::Linear);
+    m_atlas.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_atlas.setAutoMipMapGenerationEnabled(false);
+    m_atlas.setSize(m_slotCount[0] * SLOT_SIZE, m_slotCount[1] * SLOT_SIZE,
+                    m_slotCount[2] * SLOT_SIZE);
+    m_atlas.allocateStorage();
+
+    // Entries hold the slot position and a residency flag, all zero at first.
+    m_pageTable.setFormat(QOpenGLTexture::RGBA8U);
+    m_pageTable.setMinificationFilter(QOpenGLTexture::Nearest);
+    m_pageTable.setMagnificationFilter(QOpenGLTexture::Nearest);
+    m_pageTable.setAutoMipMapGenerationEnabled(false);
+    m_pageTable.setSize(m_brickCount[0], m_brickCount[1], m_brickCount[2]);
+    m_pageTable.allocateStorage();
+    std::vector<unsigned char> emptyTable(static_cast<std::size_t>(brickCount) *
+                                          4);
+    m_pageTable.setData(QOpenGLTexture::RGBA_Integer, QOpenGLTexture::UInt8,
+                        emptyTable.data());
+
+    m_usageBufferBytes = static_cast<qint64>(brickCount) * sizeof(GLuint);
+    std::vector<GLuint> emptyUsage(brickCount, 0);
+    for (UsageBuffer& usageBuffer : m_usageBuffers)
+    {
+        glGenBuffers(1, &usageBuffer.buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, usageBuffer.buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_usageBufferBytes,
+                     emptyUsage.data(), GL_DYNAMIC_READ);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+qint64 BrickCache::gpuBytes() const
+{
+    if (!isAllocated())
+        return 0;
+    const qint64 atlasTexels = static_cast<qint64>(m_atlas.width()) *
+                               m_atlas.height() * m_atlas.depth();
+    const qint64 pageTableTexels = static_cast<qint64>(m_brickCount[0]) *
+                                   m_brickCount[1] * m_brickCount[2];
+    return atlasTexels * 2 + pageTableTexels * 4 +
+           m_usageBufferBytes * USAGE_BUFFER_COUNT;
+}
+
+void BrickCache::reset()
+{
+    if (m_atlas.isCreated())
+        m_atlas.destroy();
+    if (m_pageTable.isCreated())
+        m_pageTable.destroy();
+    for (UsageBuffer& usageBuffer : m_usageBuffers)
+    {
+        if (usageBuffer.fence)
+            glDeleteSync(usageBuffer.fence);
+        if (usageBuffer.buffer)
+            glDeleteBuffers(1, &usageBuffer.buffer);
+        usageBuffer = UsageBuffer{};
+    }
+    m_nextUsageBuffer = 0;
+    m_streaming = false;
+    m_drainNext = false;
+    m_residency.reset();
+    m_volumeData.reset();
+}
+
+bool BrickCache::update(int loadedSlices)
+{
+    if (!isAllocated())
+        return false;
+
+    // Oldest first. Frames before the last one have had a whole frame to
+    // finish and their buffers are about to be reused, so those are waited
+    // for; the last one is only read if it is already done.
+    std::vector<unsigned int> usage(m_usageBufferBytes / sizeof(GLuint), 0);
+    bool read = false;
+    bool lastFramePending = false;
+    for (int i = 0; i < USAGE_BUFFER_COUNT; i++)
+    {
+        UsageBuffer& usageBuffer =
+            m_usageBuffers[(m_nextUsageBuffer + i) % USAGE_BUFFER_COUNT];
+        if (!usageBuffer.fence)
+            continue;
+        const bool lastFrame = i == USAGE_BUFFER_COUNT - 1;
+        if (readUsage(usageBuffer, lastFrame ? 0 : FRAME_TIMEOUT, usage))
+            read = true;
+        else if (lastFrame && !usageBuffer.drain)
+            lastFramePending = true;
+    }
+
+    if (read)
+        m_streaming = streamBricks(usage, loadedSlices);
+    // Nothing else may ask for another frame, but the last one could still
+    // request bricks. One more frame waits for it, without asking again.
+    m_drainNext = !m_streaming && lastFramePending;
+    return m_streaming || m_drainNext;
+}
+
+bool BrickCache::readUsage(UsageBuffer& usageBuffer, GLuint64 timeout,
+                           std::vector<unsigned int>& usage)
+{
+    const GLenum status = glClientWaitSync(
+        usageBuffer.fence, timeout ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+    if (status == GL_TIMEOUT_EXPIRED)
+        return false;
+    glDeleteSync(usageBuffer.fence);
+    usageBuffer.fence = nullptr;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, usageBuffer.buffer);
+    auto* mapped = static_cast<GLuint*>(
+        glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_usageBufferBytes,
+                         GL_MAP_READ_BIT | GL_MAP_WRITE_BIT));
+    if (mapped)
+    {
+        for (std::size_t brick = 0; brick < usage.size(); brick++)
+            usage[brick] |= mapped[brick];
+        std::memset(mapped, 0, m_usageBufferBytes);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return mapped != nullptr;
+}
+
+bool BrickCache::streamBricks(std::vector<unsigned int>& usage, int loadedSlices)
+{
+    // Bricks reaching into slices that are still being loaded have to wait.
+    bool waitingForSlices = false;
+    for (int brick = 0; brick < static_cast<int>(usage.size()); brick++)
+    {
+        const int brickEnd = (brickPosition(brick)[2] + 1) * BRICK_SIZE;
+        if (usage[brick] && brickEnd > loadedSlices &&
+            loadedSlices < m_volumeData->depth())
+        {
+            usage[brick] = 0;
+            waitingForSlices = true;
+        }
+    }
+
+    bool loaded = false;
+    for (const auto& assignment :
+         m_residency->update(usage, MAX_LOADS_PER_FRAME))
+    {
+        if (assignment.evictedBrick != BrickResidency::NO_BRICK)
+            setPageTableEntry(assignment.evictedBrick, BrickResidency::NO_BRICK);
+        loadBrick(assignment.brick, assignment.slot);
+        setPageTableEntry(assignment.brick, assignment.slot);
+        loaded = true;
+    }
+    return waitingForSlices || loaded || m_residency->requestsPending();
+}
+
+void BrickCache::loadBrick(int brick, int slot)
+{
+    const auto [bx, by, bz] = brickPosition(brick);
+    const int width = m_volumeData->width();
+    const int height = m_volumeData->height();
+    const int depth = m_volumeData->depth();
+    const auto voxels = m_volumeData->voxels();
+
+    // The apron repeats the neighbouring voxels, and outside the volume it
+    // is zero like the border of the volume texture.
+    for (int z = 0; z < SLOT_SIZE; z++)
+    {
+        const int vz = bz * BRICK_SIZE + z - 1;
+        for (int y = 0; y < SLOT_SIZE; y++)
+        {
+            const int vy = by * BRICK_SIZE + y - 1;
+            unsigned short* row =
+                m_brickBuffer.data() +
+                (static_cast<std::size_t>(z) * SLOT_SIZE + y) * SLOT_SIZE;
+            if (vz < 0 || vz >= depth || vy < 0 || vy >= height)
+            {
+                std::fill(row, row + SLOT_SIZE, 0);
+                continue;
+            }
+            for (int x = 0; x < SLOT_SIZE; x++)
+            {
+                const int vx = bx * BRICK_SIZE + x - 1;
+                row[x] = vx < 0 || vx >= width
+                             ? 0
+                             : voxels[(static_cast<std::size_t>(vz) * height +
+                                       vy) *
+                                          width +
+                                      vx];
+            }
+        }
+    }
+
+    const auto [sx, sy, sz] = slotPosition(slot);
+    m_atlas.setData(sx * SLOT_SIZE, sy * SLOT_SIZE, sz * SLOT_SIZE, SLOT_SIZE,
+                    SLOT_SIZE, SLOT_SIZE, QOpenGLTexture::Red,
+                    QOpenGLTexture::UInt16, m_brickBuffer.data());
+}
+
+void BrickCache::setPageTableEntry(int brick, int slot)
+{
+    std::array<unsigned char, 4> entry{0, 0, 0, 0};
+    if (slot != BrickResidency::NO_BRICK)
+    {
+        const auto [sx, sy, sz] = slotPosition(slot);
+        entry = {static_cast<unsigned char>(sx), static_cast<unsigned char>(sy),
+                 static_cast<unsigned char>(sz), 1};
+    }
+    const auto [bx, by, bz] = brickPosition(brick);
+    m_pageTable.setData(bx, by, bz, 1, 1, 1, QOpenGLTexture::RGBA_Integer,
+                        QOpenGLTexture::UInt8, entry.data());
+}
+
+std::array<int, 3> BrickCache::brickPosition(int brick) const
+{
+    return {brick % m_brickCount[0], (brick / m_brickCount[0]) % m_brickCount[1],
+            brick / (m_brickCount[0] * m_brickCount[1])};
+}
+
+std::array<int, 3> BrickCache::slotPosition(int slot) const
+{
+    return {slot % m_slotCount[0], (slot / m_slotCount[0]) % m_slotCount[1],
+            slot / (m_slotCount[0] * m_slotCount[1])};
+}
+
+void BrickCache::bind(int atlasUnit, int pageTableUnit)
+{
+    if (!isAllocated())
+        return;
+    m_atlas.bind(atlasUnit);
+    m_pageTable.bind(pageTableUnit);
+
+    // A frame that outlasted the wait in update() shares its buffer with this
+    // one, its requests are read back together with the new ones.
+    UsageBuffer& usageBuffer = m_usageBuffers[m_nextUsageBuffer];
+    if (usageBuffer.fence)
+    {
+        glDeleteSync(usageBuffer.fence);
+        usageBuffer.fence = nullptr;
+    }
+    usageBuffer.drain = m_drainNext;
+    m_drainNext = false;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, USAGE_BUFFER_BINDING,
+                     usageBuffer.buffer);
+}
+
+void BrickCache::release()
+{
+    if (!isAllocated())
+        return;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, USAGE_BUFFER_BINDING, 0);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    m_usageBuffers[m_nextUsageBuffer].fence =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_nextUsageBuffer = (m_nextUsageBuffer + 1) % USAGE_BUFFER_COUNT;
+}
@@ -0,0 +1,122 @@
+#ifndef BRICKCACHE_H
+#define BRICKCACHE_H
+
+#include "volumedata.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLTexture>
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Decides which bricks occupy the slots of the brick atlas. Bricks that rays
+// touched in the last frame are requested, and each request takes a free slot
+// or the least recently used slot that the last frame did not touch.
+class BrickResidency
+{
+  public:
+    struct Assignment
+    {
+        int brick;
+        int slot;
+        int evictedBrick;
+    };
+    constexpr static int NO_BRICK = -1;
+
+    BrickResidency(int brickCount, int slotCount);
+
+    // usage holds one entry per brick, non-zero if a ray touched it. At most
+    // maxLoads bricks are made resident per call.
+    std::vector<Assignment> update(std::span<const unsigned int> usage,
+                                   int maxLoads);
+    int slotOf(int brick) const { return m_slotOfBrick[brick]; };
+    // True if the last update left requests unserved.
+    bool requestsPending() const { return m_requestsPending; };
+
+  private:
+    int leastRecentlyUsedSlot() const;
+
+    std::vector<int> m_slotOfBrick;
+    std::vector<int> m_brickOfSlot;
+    std::vector<unsigned long long> m_lastUsed;
+    unsigned long long m_frame{0};
+    bool m_requestsPending{false};
+};
+
+// Virtual texturing for volumes that exceed the texture budget. The volume is
+// split into bricks of BRICK_SIZE^3 voxels that are streamed on demand into a
+// fixed-size atlas texture, each with a one-voxel apron so that trilinear
+// filtering never reads a neighbouring slot. A page table texture maps every
+// brick to its atlas slot, and the raycaster marks the bricks it samples in a
+// shader storage buffer. Frames take turns on a ring of those buffers, each
+// read back once its fence shows the frame has finished, so the readback never
+// stalls on the frame just submitted.
+class BrickCache : protected QOpenGLExtraFunctions
+{
+  public:
+    constexpr static int BRICK_SIZE = 32;
+    constexpr static int SLOT_SIZE = BRICK_SIZE + 2;
+    constexpr static qint64 ATLAS_BYTES = 256 * 1024 * 1024;
+    constexpr static int MAX_LOADS_PER_FRAME = 64;
+    constexpr static int USAGE_BUFFER_BINDING = 0;
+    constexpr static int USAGE_BUFFER_COUNT = 3;
+    // Nanoseconds to wait for a frame whose buffer is about to be reused.
+    constexpr static GLuint64 FRAME_TIMEOUT = 1000000000;
+
+    BrickCache();
+    void allocate(std::shared_ptr<const VolumeData> volumeData);
+    void reset();
+    bool isAllocated() const { return m_residency != nullptr; };
+
+    // Streams in the bricks requested by the frames that have finished since
+    // the last call. Only the first loadedSlices z-slices may be read. Returns
+    // true if bricks are still missing, or requests are still on their way
+    // back, so another frame is worth drawing.
+    bool update(int loadedSlices);
+    void bind(int atlasUnit, int pageTableUnit);
+    // Fences the requests of the frame drawn since bind().
+    void release();
+    std::array<int, 3> brickCount() const { return m_brickCount; };
+    // Video memory taken by the atlas, the page table and the usage buffer.
+    qint64 gpuBytes() const;
+
+  private:
+    struct UsageBuffer
+    {
+        GLuint buffer{0};
+        GLsync fence{nullptr};
+        // Drawn only to read back the requests of the frame before.
+        bool drain{false};
+    };
+
+    // Adds the requests in buffer to usage and clears them, unless its frame
+    // is still running after timeout nanoseconds.
+    bool readUsage(UsageBuffer& buffer, GLuint64 timeout,
+                   std::vector<unsigned int>& usage);
+    // Loads the requested bricks, returning true if any were loaded or are
+    // still missing.
+    bool streamBricks(std::vector<unsigned int>& usage, int loadedSlices);
+    void loadBrick(int brick, int slot);
+    void setPageTableEntry(int brick, int slot);
+    std::array<int, 3> brickPosition(int brick) const;
+    std::array<int, 3> slotPosition(int slot) const;
+
+    std::shared_ptr<const VolumeData> m_volumeData;
+    std::unique_ptr<BrickResidency> m_residency;
+    QOpenGLTexture m_atlas;
+    QOpenGLTexture m_pageTable;
+    // QOpenGLBuffer has no shader storage buffer type.
+    std::array<UsageBuffer, USAGE_BUFFER_COUNT> m_usageBuffers;
+    // The buffer the next frame writes to, and the oldest one in flight.
+    int m_nextUsageBuffer{0};
+    qint64 m_usageBufferBytes{0};
+    // Whether the last requests read back loaded bricks or left some missing.
+    bool m_streaming{false};
+    bool m_drainNext{false};
+    std::array<int, 3> m_brickCount{0, 0, 0};
+    std::array<int, 3> m_slotCount{0, 0, 0};
+    std::vector<unsigned short> m_brickBuffer;
+};
+
+#endif // BRICKCACHE_H
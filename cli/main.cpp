@@ -0,0 +1,237 @@
+#include "../properties/cameraproperties.h"
+#include "../properties/rendersettings.h"
+#include "../renderers/cpuraycaster.h"
+#include "../transferfunction.h"
+#include "../transfertexture.h"
+#include "../volumedata.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMatrix4x4>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <future>
+#include <optional>
+
+// Renders thumbnails of .dat volumes without a display or a GPU, with the
+// CPU raycaster. Every volume is rendered from a number of views spread
+// evenly around its vertical axis, and written out as <name>_<view>.png.
+//
+//   strangevis-cli --views 8 --colormap Viridis --tfn bone.json
+//                  --set maxInt=true -o thumbnails *.dat
+
+namespace
+{
+// The distance of the 3D view's initial camera.
+const float CAMERA_DISTANCE = 2.0f * std::sqrt(3.0f);
+// PNG encoding of earlier views runs alongside the rendering of the next,
+// up to this many images at a time.
+constexpr int MAX_PENDING_WRITES = 4;
+
+// Parses name=value into the RenderSettings field called name.
+bool applyRenderSetting(RenderSettings& settings, const QString& assignment)
+{
+    const QStringList parts = assignment.split('=');
+    if (parts.size() != 2)
+        return false;
+    const QString& name = parts[0];
+    const QString& value = parts[1];
+    return std::apply(
+        [&](const auto&... keys) {
+            auto assign = [&](const auto& key) {
+                using T = typename std::decay_t<decltype(key)>::Type;
+                if (name != key.name)
+                    return false;
+                bool ok = true;
+                if constexpr (std::is_same_v<T, bool>)
+                {
+                    ok = value == "true" || value == "false";
+                    settings.*key.field = value == "true";
+                }
+                else if constexpr (std::is_same_v<T, int>)
+                    settings.*key.field = value.toInt(&ok);
+                else
+                    settings.*key.field = value.toFloat(&ok);
+                return ok;
+            };
+            return (assign(keys) || ...);
+        },
+        RenderSettingKeys::ALL);
+}
+
+std::optional<QSize> parseSize(const QString& size)
+{
+    const QStringList parts = size.split('x');
+    if (parts.size() != 2)
+        return std::nullopt;
+    bool widthOk = false;
+    bool heightOk = false;
+    const QSize parsed(parts[0].toInt(&widthOk), parts[1].toInt(&heightOk));
+    if (!widthOk || !heightOk || parsed.isEmpty())
+        return std::nullopt;
+    return parsed;
+}
+
+CameraProperties orbitCamera(int view, int views, float elevation)
+{
+    QMatrix4x4 rotation;
+    rotation.rotate(elevation, 1, 0, 0);
+    rotation.rotate(360.0f * view / views, 0, 1, 0);
+    CameraProperties camera;
+    camera.moveCamera(QVector3D(0, 0, -CAMERA_DISTANCE));
+    camera.rotateCamera(rotation);
+    return camera;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+    QCoreApplication::setApplicationName("strangevis-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Renders .dat volumes to PNG files without a display.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("volumes", "The .dat files to render.",
+                                 "volumes...");
+    const QCommandLineOption outputOption(
+        {"o", "output"}, "Directory the images are written to.", "directory",
+        ".");
+    const QCommandLineOption colorMapOption(
+        {"c", "colormap"}, "Colour map from cmaps.xml.", "name", "Ramp Grey");
+    const QCommandLineOption transferFunctionOption(
+        {"t", "tfn"}, "Transfer function control points, as JSON.", "file");
+    const QCommandLineOption viewsOption(
+        {"n", "views"}, "Views around the vertical axis.", "count", "1");
+    const QCommandLineOption elevationOption(
+        "elevation", "Angle the views look down at the volume from.",
+        "degrees", "0");
+    const QCommandLineOption sizeOption("size", "Image size.", "WxH",
+                                        "512x512");
+    const QCommandLineOption settingOption(
+        "set", "Sets a render setting, e.g. maxInt=true. Repeatable.",
+        "name=value");
+    const QCommandLineOption threadsOption(
+        "threads", "Render threads, one per core by default.", "count", "0");
+    const QCommandLineOption listColorMapsOption(
+        "list-colormaps", "Lists the available colour maps.");
+    parser.addOptions({outputOption, colorMapOption, transferFunctionOption,
+                       viewsOption, elevationOption, sizeOption, settingOption,
+                       threadsOption, listColorMapsOption});
+    parser.process(app);
+
+    tfn::ColorMapStore colorMapStore;
+    if (parser.isSet(listColorMapsOption))
+    {
+        for (const QString& name : colorMapStore.availableColorMaps())
+            qInfo().noquote() << name;
+        return 0;
+    }
+
+    const QStringList volumes = parser.positionalArguments();
+    if (volumes.isEmpty())
+        parser.showHelp(1);
+
+    const QString colorMapName = parser.value(colorMapOption);
+    const auto colorMaps = colorMapStore.availableColorMaps();
+    if (std::find(colorMaps.begin(), colorMaps.end(), colorMapName) ==
+        colorMaps.end())
+    {
+        qCritical() << "Unknown colour map" << colorMapName;
+        return 1;
+    }
+    tfn::TransferFunction transferFunction;
+    if (parser.isSet(transferFunctionOption))
+    {
+        auto loaded =
+            tfn::TransferFunction::fromFile(parser.value(transferFunctionOption));
+        if (!loaded)
+            return 1;
+        transferFunction = *loaded;
+    }
+    transferFunction.setColorMap(colorMapStore.colorMap(colorMapName));
+    transferFunction.updateTransferFunction();
+
+    // The light follows the camera unless told otherwise, which suits views
+    // from all sides.
+    RenderSettings settings;
+    settings.headLight = true;
+    for (const QString& assignment : parser.values(settingOption))
+    {
+        if (!applyRenderSetting(settings, assignment))
+        {
+            qCritical() << "Invalid render setting" << assignment;
+            return 1;
+        }
+    }
+
+    bool viewsOk = false;
+    bool elevationOk = false;
+    bool threadsOk = false;
+    const int views = parser.value(viewsOption).toInt(&viewsOk);
+    const float elevation = parser.value(elevationOption).toFloat(&elevationOk);
+    const int threads = parser.value(threadsOption).toInt(&threadsOk);
+    const auto size = parseSize(parser.value(sizeOption));
+    if (!viewsOk || views < 1 || !elevationOk || !threadsOk || threads < 0 ||
+        !size)
+    {
+        qCritical() << "Invalid view count, elevation, thread count or size";
+        return 1;
+    }
+
+    const QDir outputDir(parser.value(outputOption));
+    if (!outputDir.mkpath("."))
+    {
+        qCritical() << "Unable to create" << outputDir.path();
+        return 1;
+    }
+
+    int failures = 0;
+    std::deque<std::future<bool>> pendingWrites;
+    const auto finishWrite = [&pendingWrites, &failures]() {
+        if (!pendingWrites.front().get())
+            failures++;
+        pendingWrites.pop_front();
+    };
+    for (const QString& fileName : volumes)
+    {
+        auto volumeData =
+            VolumeData::fromFile(fileName, VolumeData::LoadMode::MemoryMapped);
+        if (!volumeData)
+        {
+            failures++;
+            continue;
+        }
+        CpuRaycaster raycaster(volumeData, VolumeData::gridSpacing(fileName));
+        raycaster.setTransferFunction(transferFunction.getColorMapData());
+        raycaster.setThreadCount(threads);
+
+        const QString baseName = QFileInfo(fileName).completeBaseName();
+        for (int view = 0; view < views; view++)
+        {
+            QImage image = raycaster.render(orbitCamera(view, views, elevation),
+                                            settings, *size);
+            const QString imageName = outputDir.filePath(
+                QString("%1_%2.png").arg(baseName).arg(view, 3, 10, QChar('0')));
+            if (pendingWrites.size() >= MAX_PENDING_WRITES)
+                finishWrite();
+            pendingWrites.push_back(std::async(
+                std::launch::async, [image = std::move(image), imageName]() {
+                    if (image.save(imageName))
+                        return true;
+                    qCritical() << "Unable to write" << imageName;
+                    return false;
+                }));
+        }
+        qInfo().noquote() << fileName << "->" << views << "images";
+    }
+    while (!pendingWrites.empty())
+        finishWrite();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "emptyspacegrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+
+std::shared_ptr<const EmptySpaceGrid>
+EmptySpaceGrid::build(const VolumeData& volume)
+{
+    auto grid = std::make_shared<EmptySpaceGrid>();
+    const int width = volume.width();
+    const int height = volume.height();
+    const int depth = volume.depth();
+    grid->m_width = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    grid->m_height = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    grid->m_depth = (depth + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const std::size_t blockCount =
+        static_cast<std::size_t>(grid->m_width) * grid->m_height * grid->m_depth;
+    grid->m_minimum.resize(blockCount);
+    grid->m_maximum.resize(blockCount);
+
+    const unsigned short* voxels = volume.voxels().data();
+    std::vector<int> blockSlices(grid->m_depth);
+    std::iota(blockSlices.begin(), blockSlices.end(), 0);
+    std::for_each(
+        std::execution::par, blockSlices.begin(), blockSlices.end(),
+        [&](int bz) {
+            const int z0 = std::max(0, bz * BLOCK_SIZE - 1);
+            const int z1 = std::min(depth, (bz + 1) * BLOCK_SIZE + 1);
+            for (int by = 0; by < grid->m_height; by++)
+            {
+                const int y0 = std::max(0, by * BLOCK_SIZE - 1);
+                const int y1 = std::min(height, (by + 1) * BLOCK_SIZE + 1);
+                for (int bx = 0; bx < grid->m_width; bx++)
+                {
+                    const int x0 = std::max(0, bx * BLOCK_SIZE - 1);
+                    const int x1 = std::min(width, (bx + 1) * BLOCK_SIZE + 1);
+                    unsigned short blockMinimum =
+                        std::numeric_limits<unsigned short>::max();
+                    unsigned short blockMaximum = 0;
+                    for (int z = z0; z < z1; z++)
+                    {
+                        for (int y = y0; y < y1; y++)
+                        {
+                            const unsigned short* row =
+                                voxels +
+                                (static_cast<std::size_t>(z) * height + y) *
+                                    width;
+                            const auto [rowMinimum, rowMaximum] =
+                                std::minmax_element(row + x0, row + x1);
+                            blockMinimum = std::min(blockMinimum, *rowMinimum);
+                            blockMaximum = std::max(blockMaximum, *rowMaximum);
+                        }
+                    }
+                    const std::size_t index =
+                        (static_cast<std::size_t>(bz) * grid->m_height + by) *
+                            grid->m_width +
+                        bx;
+                    grid->m_minimum[index] = blockMinimum;
+                    grid->m_maximum[index] = blockMaximum;
+                }
+            }
+        });
+    grid->dilate();
+    return grid;
+}
+
+void EmptySpaceGrid::dilate()
+{
+    m_dilatedMinimum.resize(m_minimum.size());
+    m_dilatedMaximum.resize(m_maximum.size());
+    for (int z = 0; z < m_depth; z++)
+    {
+        for (int y = 0; y < m_height; y++)
+        {
+            for (int x = 0; x < m_width; x++)
+            {
+                unsigned short minimum =
+                    std::numeric_limits<unsigned short>::max();
+                unsigned short maximum = 0;
+                for (int k = std::max(0, z - 1); k <= std::min(m_depth - 1, z + 1);
+                     k++)
+                {
+                    for (int j = std::max(0, y - 1);
+                         j <= std::min(m_height - 1, y + 1); j++)
+                    {
+                        for (int i = std::max(0, x - 1);
+                             i <= std::min(m_width - 1, x + 1); i++)
+                        {
+                            const std::size_t neighbour =
+                                (static_cast<std::size_t>(k) * m_height + j) *
+                                    m_width +
+                                i;
+                            minimum = std::min(minimum, m_minimum[neighbour]);
+                            maximum = std::max(maximum, m_maximum[neighbour]);
+                        }
+                    }
+                }
+                const std::size_t index =
+                    (static_cast<std::size_t>(z) * m_height + y) * m_width + x;
+                m_dilatedMinimum[index] = minimum;
+                m_dilatedMaximum[index] = maximum;
+            }
+        }
+    }
+}
+
+std::vector<unsigned char>
+EmptySpaceGrid::occupancy(std::span<const float> opacity,
+                          float intensityScale) const
+{
+    const int entries = static_cast<int>(opacity.size());
+    if (entries == 0)
+        return std::vector<unsigned char>(blockCount() * OCCUPANCY_CHANNELS, 1);
+    // Number of visible entries below each index, so that a block's range is
+    // checked in constant time.
+    std::vector<int> visibleBelow(entries + 1, 0);
+    for (int i = 0; i < entries; i++)
+    {
+        visibleBelow[i + 1] = visibleBelow[i] + (opacity[i] > 0.0f ? 1 : 0);
+    }
+    // The volume texture stores half floats, so the entry a voxel lands on
+    // may be off by one. Widening the range by an entry keeps it safe.
+    auto entry = [&](unsigned short voxel, int offset) {
+        const int index = static_cast<int>(std::floor(
+            voxel * intensityScale / std::numeric_limits<unsigned short>::max() *
+            entries));
+        return std::clamp(index + offset, 0, entries - 1);
+    };
+    auto visible = [&](unsigned short minimum, unsigned short maximum) {
+        return visibleBelow[entry(maximum, 1) + 1] -
+                   visibleBelow[entry(minimum, -1)] >
+               0;
+    };
+
+    std::vector<unsigned char> occupancy(blockCount() * OCCUPANCY_CHANNELS);
+    for (std::size_t i = 0; i < blockCount(); i++)
+    {
+        occupancy[i * OCCUPANCY_CHANNELS] =
+            visible(m_minimum[i], m_maximum[i]) ? 1 : 0;
+        occupancy[i * OCCUPANCY_CHANNELS + 1] =
+            visible(m_dilatedMinimum[i], m_dilatedMaximum[i]) ? 1 : 0;
+    }
+    return occupancy;
+}
@@ -0,0 +1,50 @@
+#ifndef EMPTYSPACEGRID_H
+#define EMPTYSPACEGRID_H
+
+#include "volumedata.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+// Minimum and maximum intensity of every BLOCK_SIZE^3 block of a volume,
+// built once after loading. Combined with the opacity of the transfer
+// function it tells which blocks are fully transparent, so that rays can
+// leap over them. The range of a block takes in a one-voxel border, as
+// trilinear filtering near a block's faces reads its neighbours.
+class EmptySpaceGrid
+{
+  public:
+    constexpr static int BLOCK_SIZE = 16;
+    // Occupancy entries per block: visible at the finest level, and visible
+    // when sampled from the coarser levels of the pyramid, whose filter
+    // reaches into the neighbouring blocks.
+    constexpr static int OCCUPANCY_CHANNELS = 2;
+
+    static std::shared_ptr<const EmptySpaceGrid> build(const VolumeData& volume);
+
+    // Derives the occupancy of every block from the opacity of evenly spaced
+    // transfer function entries over the normalized intensity range, where a
+    // voxel maps to voxel * intensityScale / 65535.
+    std::vector<unsigned char> occupancy(std::span<const float> opacity,
+                                         float intensityScale) const;
+
+    int width() const { return m_width; };
+    int height() const { return m_height; };
+    int depth() const { return m_depth; };
+    std::size_t blockCount() const { return m_minimum.size(); };
+
+  private:
+    void dilate();
+
+    int m_width{0};
+    int m_height{0};
+    int m_depth{0};
+    std::vector<unsigned short> m_minimum;
+    std::vector<unsigned short> m_maximum;
+    // Ranges over each block and its 26 neighbours.
+    std::vector<unsigned short> m_dilatedMinimum;
+    std::vector<unsigned short> m_dilatedMaximum;
+};
+
+#endif // EMPTYSPACEGRID_H
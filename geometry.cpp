@@ -1,6 +1,10 @@
 #include "geometry.h"
 
+#include "tracer.h"
+
 #include <QDebug>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
 #include <QVector3D>
 
 Geometry::Geometry()
@@ -54,6 +58,7 @@ void Geometry::allocateCube()
 
 void Geometry::allocateObliqueSlice(CubePlaneIntersection& intersection)
 {
+    TRACE_ZONE("Geometry::allocateObliqueSlice");
     auto cubeIntersectionCoords = intersection.getCubeIntersections();
     auto sortedOrder = intersection.getConvexHullIndexOrder();
     m_sliceIndices = static_cast<GLsizei>(sortedOrder.size());
@@ -97,7 +102,8 @@ void Geometry::bindQuad()
 
 void Geometry::drawQuad()
 {
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+    QOpenGLContext::currentContext()->functions()->glDrawElements(
+        GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
 }
 
 void Geometry::bindCube()
@@ -108,7 +114,8 @@ void Geometry::bindCube()
 
 void Geometry::drawCube()
 {
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, nullptr);
+    QOpenGLContext::currentContext()->functions()->glDrawElements(
+        GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, nullptr);
 }
 
 void Geometry::bindObliqueSliceIntersectionCoords()
@@ -125,7 +132,8 @@ void Geometry::releaseObliqueSliceIntersectionCoords()
 
 void Geometry::drawObliqueSlice()
 {
-    glDrawElements(GL_TRIANGLE_FAN, m_sliceIndices, GL_UNSIGNED_SHORT, nullptr);
+    QOpenGLContext::currentContext()->functions()->glDrawElements(
+        GL_TRIANGLE_FAN, m_sliceIndices, GL_UNSIGNED_SHORT, nullptr);
 }
 
 void Geometry::bindLightSource()
@@ -136,7 +144,8 @@ void Geometry::bindLightSource()
 
 void Geometry::drawLightSource()
 {
-    glDrawElements(GL_POINTS, 1, GL_UNSIGNED_INT, nullptr);
+    QOpenGLContext::currentContext()->functions()->glDrawElements(
+        GL_POINTS, 1, GL_UNSIGNED_INT, nullptr);
 }
 
 Geometry& Geometry::instance()
@@ -0,0 +1,338 @@
+#include "gradientvolume.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GRADIENTVOLUME_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+constexpr float MAXIMUM_INTENSITY = 4095.0f;
+constexpr int CHANNELS = GradientVolume::CHANNELS;
+
+void pack(float gx, float gy, float gz, float width, float height, float depth,
+          unsigned char* texel)
+{
+    // The direction is taken in texture space, as the raycaster samples it.
+    const float tx = gx * width;
+    const float ty = gy * height;
+    const float tz = gz * depth;
+    const float length = std::sqrt(tx * tx + ty * ty + tz * tz);
+    if (length == 0.0f)
+    {
+        texel[0] = texel[1] = texel[2] = 128;
+        texel[3] = 0;
+        return;
+    }
+    auto encode = [length](float component) {
+        return static_cast<unsigned char>(
+            std::lround((component / length * 0.5f + 0.5f) * 255.0f));
+    };
+    texel[0] = encode(tx);
+    texel[1] = encode(ty);
+    texel[2] = encode(tz);
+    const float magnitude =
+        std::min(1.0f, std::sqrt(gx * gx + gy * gy + gz * gz) /
+                           MAXIMUM_INTENSITY);
+    texel[3] = static_cast<unsigned char>(
+        std::max(1l, std::lround(std::sqrt(magnitude) * 255.0f)));
+}
+
+#ifdef GRADIENTVOLUME_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define GRADIENTVOLUME_AVX2 __attribute__((target("avx2")))
+#else
+#define GRADIENTVOLUME_AVX2
+#endif
+
+// The AVX2 code repeats the operations of the scalar code in the same order,
+// without fused multiply-adds, so that both give the same bytes.
+
+GRADIENTVOLUME_AVX2 inline __m256 loadAvx2(const unsigned short* voxels)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(voxels))));
+}
+
+// The voxels one stride after those at voxels minus the ones a stride before.
+GRADIENTVOLUME_AVX2 inline __m256 differenceAvx2(const unsigned short* voxels,
+                                                 std::ptrdiff_t stride)
+{
+    return _mm256_sub_ps(loadAvx2(voxels + stride), loadAvx2(voxels - stride));
+}
+
+// std::lround of values that are not negative, which rounds halves up
+// rather than to even.
+GRADIENTVOLUME_AVX2 inline __m256i roundAvx2(__m256 value)
+{
+    const __m256 whole =
+        _mm256_round_ps(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256 up = _mm256_cmp_ps(_mm256_sub_ps(value, whole),
+                                    _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+    return _mm256_cvttps_epi32(
+        _mm256_add_ps(whole, _mm256_and_ps(up, _mm256_set1_ps(1.0f))));
+}
+
+GRADIENTVOLUME_AVX2 inline __m256i encodeAvx2(__m256 component, __m256 length)
+{
+    return roundAvx2(_mm256_mul_ps(
+        _mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(component, length),
+                                    _mm256_set1_ps(0.5f)),
+                      _mm256_set1_ps(0.5f)),
+        _mm256_set1_ps(255.0f)));
+}
+
+GRADIENTVOLUME_AVX2 inline __m256 lengthAvx2(__m256 x, __m256 y, __m256 z)
+{
+    return _mm256_sqrt_ps(_mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+        _mm256_mul_ps(z, z)));
+}
+
+// pack() for eight consecutive voxels.
+GRADIENTVOLUME_AVX2 void packAvx2(__m256 gx, __m256 gy, __m256 gz, float width,
+                                  float height, float depth,
+                                  unsigned char* texels)
+{
+    const __m256 tx = _mm256_mul_ps(gx, _mm256_set1_ps(width));
+    const __m256 ty = _mm256_mul_ps(gy, _mm256_set1_ps(height));
+    const __m256 tz = _mm256_mul_ps(gz, _mm256_set1_ps(depth));
+    const __m256 length = lengthAvx2(tx, ty, tz);
+    const __m256 magnitude = _mm256_min_ps(
+        _mm256_div_ps(lengthAvx2(gx, gy, gz),
+                      _mm256_set1_ps(MAXIMUM_INTENSITY)),
+        _mm256_set1_ps(1.0f));
+    const __m256i alpha =
+        _mm256_max_epi32(roundAvx2(_mm256_mul_ps(_mm256_sqrt_ps(magnitude),
+                                                 _mm256_set1_ps(255.0f))),
+                         _mm256_set1_epi32(1));
+    // The RGBA bytes of a texel are one little-endian word.
+    const __m256i packed = _mm256_or_si256(
+        _mm256_or_si256(encodeAvx2(tx, length),
+                        _mm256_slli_epi32(encodeAvx2(ty, length), 8)),
+        _mm256_or_si256(_mm256_slli_epi32(encodeAvx2(tz, length), 16),
+                        _mm256_slli_epi32(alpha, 24)));
+    const __m256 vanishes =
+        _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(texels),
+        _mm256_blendv_epi8(packed, _mm256_set1_epi32(0x00808080),
+                           _mm256_castps_si256(vanishes)));
+}
+
+// The rows below take the voxel at x of an interior row, whose neighbours
+// all lie inside the volume. They pack voxels from x = 1 eight at a time and
+// return the first x they leave to the scalar code.
+
+GRADIENTVOLUME_AVX2 int centralDifferenceRowAvx2(const unsigned short* center,
+                                                 std::ptrdiff_t rowVoxels,
+                                                 std::ptrdiff_t sliceVoxels,
+                                                 int width, int height,
+                                                 int depth, unsigned char* row)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8)
+    {
+        const unsigned short* voxel = center + x;
+        packAvx2(_mm256_mul_ps(differenceAvx2(voxel, 1), half),
+                 _mm256_mul_ps(differenceAvx2(voxel, rowVoxels), half),
+                 _mm256_mul_ps(differenceAvx2(voxel, sliceVoxels), half),
+                 width, height, depth, row + x * CHANNELS);
+    }
+    return x;
+}
+
+GRADIENTVOLUME_AVX2 int sobelRowAvx2(const unsigned short* center,
+                                     std::ptrdiff_t rowVoxels,
+                                     std::ptrdiff_t sliceVoxels, int width,
+                                     int height, int depth, unsigned char* row)
+{
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8)
+    {
+        __m256 gx = _mm256_setzero_ps();
+        __m256 gy = _mm256_setzero_ps();
+        __m256 gz = _mm256_setzero_ps();
+        for (int k = -1; k <= 1; k++)
+        {
+            for (int j = -1; j <= 1; j++)
+            {
+                const __m256 weight = _mm256_set1_ps(
+                    static_cast<float>((2 - std::abs(j)) * (2 - std::abs(k))));
+                const unsigned short* alongX =
+                    center + x + j * rowVoxels + k * sliceVoxels;
+                const unsigned short* alongY = center + x + j + k * sliceVoxels;
+                const unsigned short* alongZ = center + x + j + k * rowVoxels;
+                gx = _mm256_add_ps(
+                    gx, _mm256_mul_ps(weight, differenceAvx2(alongX, 1)));
+                gy = _mm256_add_ps(
+                    gy,
+                    _mm256_mul_ps(weight, differenceAvx2(alongY, rowVoxels)));
+                gz = _mm256_add_ps(
+                    gz,
+                    _mm256_mul_ps(weight, differenceAvx2(alongZ, sliceVoxels)));
+            }
+        }
+        const __m256 scale = _mm256_set1_ps(32.0f);
+        packAvx2(_mm256_div_ps(gx, scale), _mm256_div_ps(gy, scale),
+                 _mm256_div_ps(gz, scale), width, height, depth,
+                 row + x * CHANNELS);
+    }
+    return x;
+}
+#endif
+} // namespace
+
+bool GradientVolume::avx2Supported()
+{
+#ifdef GRADIENTVOLUME_X86
+#ifdef _MSC_VER
+    int registers[4];
+    __cpuidex(registers, 7, 0);
+    return (registers[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+#else
+    return false;
+#endif
+}
+
+std::shared_ptr<const GradientVolume>
+GradientVolume::build(const VolumeData& volume, Kernel kernel,
+                      Instructions instructions)
+{
+    auto gradients = std::make_shared<GradientVolume>();
+    gradients->m_texels.resize(static_cast<std::size_t>(volume.voxelCount()) *
+                               CHANNELS);
+    std::vector<int> slices(volume.depth());
+    std::iota(slices.begin(), slices.end(), 0);
+    std::for_each(std::execution::par, slices.begin(), slices.end(),
+                  [&](int z) {
+                      computeSlice(volume, kernel, z,
+                                   gradients->m_texels.data() +
+                                       z * volume.sliceVoxelCount() * CHANNELS,
+                                   instructions);
+                  });
+    return gradients;
+}
+
+void GradientVolume::computeSlice(const VolumeData& volume, Kernel kernel,
+                                  int z, unsigned char* texels,
+                                  Instructions instructions)
+{
+    const int width = volume.width();
+    const int height = volume.height();
+    const int depth = volume.depth();
+    const unsigned short* voxels = volume.voxels().data();
+    auto voxel = [&](int vx, int vy, int vz) -> float {
+        if (vx < 0 || vy < 0 || vz < 0 || vx >= width || vy >= height ||
+            vz >= depth)
+            return 0.0f;
+        return voxels[(static_cast<std::size_t>(vz) * height + vy) * width +
+                      vx];
+    };
+#ifdef GRADIENTVOLUME_X86
+    const bool avx2 = instructions == Instructions::Avx2 && avx2Supported();
+#else
+    Q_UNUSED(instructions);
+#endif
+    const std::ptrdiff_t sliceVoxels =
+        static_cast<std::ptrdiff_t>(width) * height;
+
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char* row =
+            texels + static_cast<std::size_t>(y) * width * CHANNELS;
+        // Rows away from the faces of the volume read their neighbours
+        // without bounds checks.
+        const bool interior =
+            y > 0 && y < height - 1 && z > 0 && z < depth - 1 && width > 2;
+        const unsigned short* center =
+            voxels + (static_cast<std::size_t>(z) * height + y) * width;
+        if (kernel == Kernel::Sobel)
+        {
+            auto sobel = [&](int x) {
+                // Derivative along one axis, smoothed with 1-2-1 weights
+                // along the other two.
+                float gx = 0.0f, gy = 0.0f, gz = 0.0f;
+                for (int k = -1; k <= 1; k++)
+                {
+                    for (int j = -1; j <= 1; j++)
+                    {
+                        const float weight = (2 - std::abs(j)) * (2 - std::abs(k));
+                        gx += weight * (voxel(x + 1, y + j, z + k) -
+                                        voxel(x - 1, y + j, z + k));
+                        gy += weight * (voxel(x + j, y + 1, z + k) -
+                                        voxel(x + j, y - 1, z + k));
+                        gz += weight * (voxel(x + j, y + k, z + 1) -
+                                        voxel(x + j, y + k, z - 1));
+                    }
+                }
+                // The weights sum to 16, and central differences span two
+                // voxels.
+                pack(gx / 32.0f, gy / 32.0f, gz / 32.0f, width, height, depth,
+                     row + x * CHANNELS);
+            };
+            int x = 0;
+#ifdef GRADIENTVOLUME_X86
+            if (avx2 && interior)
+            {
+                sobel(0);
+                x = sobelRowAvx2(center, width, sliceVoxels, width, height,
+                                 depth, row);
+            }
+#endif
+            for (; x < width; x++)
+            {
+                sobel(x);
+            }
+            continue;
+        }
+
+        if (!interior)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                pack((voxel(x + 1, y, z) - voxel(x - 1, y, z)) * 0.5f,
+                     (voxel(x, y + 1, z) - voxel(x, y - 1, z)) * 0.5f,
+                     (voxel(x, y, z + 1) - voxel(x, y, z - 1)) * 0.5f, width,
+                     height, depth, row + x * CHANNELS);
+            }
+            continue;
+        }
+        const unsigned short* below = center - width;
+        const unsigned short* above = center + width;
+        const unsigned short* front = center - sliceVoxels;
+        const unsigned short* back = center + sliceVoxels;
+        pack(center[1] * 0.5f, (above[0] - below[0]) * 0.5f,
+             (back[0] - front[0]) * 0.5f, width, height, depth, row);
+        int x = 1;
+#ifdef GRADIENTVOLUME_X86
+        if (avx2)
+            x = centralDifferenceRowAvx2(center, width, sliceVoxels, width,
+                                         height, depth, row);
+#endif
+        // Without AVX2 the compiler vectorizes what it can of the
+        // differences.
+        for (; x < width - 1; x++)
+        {
+            pack((center[x + 1] - center[x - 1]) * 0.5f,
+                 (above[x] - below[x]) * 0.5f, (back[x] - front[x]) * 0.5f,
+                 width, height, depth, row + x * CHANNELS);
+        }
+        const int last = width - 1;
+        pack(-center[last - 1] * 0.5f, (above[last] - below[last]) * 0.5f,
+             (back[last] - front[last]) * 0.5f, width, height, depth,
+             row + last * CHANNELS);
+    }
+}
@@ -1,5 +1,6 @@
 #include "application.h"
 #include "mainwindow.h"
+#include "tracer.h"
 
 #include <QSurfaceFormat>
 
@@ -7,6 +8,7 @@ int main(int argc, char* argv[])
 {
 
     StrangevisVisualizerApplication app{argc, argv};
+    TRACE_THREAD_NAME("GUI");
 
     auto properties = app.properties();
     auto colorMapStore = app.colorMapStore();
@@ -15,5 +17,8 @@ int main(int argc, char* argv[])
     window.resize(768, 768);
     window.show();
 
-    return app.exec();
+    const int result = app.exec();
+    if constexpr (Tracer::ENABLED)
+        Tracer::write(Tracer::fileName());
+    return result;
 }
@@ -77,6 +77,8 @@ MainWindow::MainWindow(std::shared_ptr<ISharedProperties> properties,
     connect(&m_textureStore->volume(), &Volume::loadingStartedOrStopped,
             m_mainWidget,
             &MainWindowWidget::toggleFileLoadingInProgressOverlay);
+    connect(&m_textureStore->volume(), &Volume::loadingProgressChanged,
+            m_mainWidget, &MainWindowWidget::updateFileLoadingProgress);
 
 
     setCentralWidget(m_mainWidget);
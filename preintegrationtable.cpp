@@ -0,0 +1,109 @@
+#include "preintegrationtable.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <execution>
+#include <numeric>
+
+namespace
+{
+// Running integrals of the opacity and of the opacity weighted colour, with
+// entry i holding the integral up to the start of transfer function entry i.
+struct Integrals
+{
+    std::vector<std::array<double, 4>> sums;
+    std::span<const float> transferFunction;
+
+    // The integral from 0 up to position, measured in transfer function
+    // entries.
+    std::array<double, 4> at(double position) const
+    {
+        const int entries = static_cast<int>(sums.size()) - 1;
+        const int entry = std::clamp(static_cast<int>(position), 0, entries - 1);
+        const double fraction = std::clamp(position - entry, 0.0, 1.0);
+        const float* rgba = transferFunction.data() +
+                            static_cast<std::size_t>(entry) *
+                                PreIntegrationTable::CHANNELS;
+        const double opacity = rgba[3];
+        std::array<double, 4> result = sums[entry];
+        for (int c = 0; c < 3; c++)
+        {
+            result[c] += fraction * rgba[c] * opacity;
+        }
+        result[3] += fraction * opacity;
+        return result;
+    }
+};
+} // namespace
+
+std::vector<float>
+PreIntegrationTable::build(std::span<const float> transferFunction)
+{
+    std::vector<float> table(static_cast<std::size_t>(SIZE) * SIZE * CHANNELS,
+                             0.0f);
+    const int entries = static_cast<int>(transferFunction.size() / CHANNELS);
+    if (entries == 0)
+        return table;
+
+    Integrals integrals{std::vector<std::array<double, 4>>(entries + 1),
+                        transferFunction};
+    integrals.sums[0] = {0.0, 0.0, 0.0, 0.0};
+    for (int i = 0; i < entries; i++)
+    {
+        const float* rgba = transferFunction.data() +
+                            static_cast<std::size_t>(i) * CHANNELS;
+        auto& sum = integrals.sums[i + 1];
+        sum = integrals.sums[i];
+        for (int c = 0; c < 3; c++)
+        {
+            sum[c] += rgba[c] * rgba[3];
+        }
+        sum[3] += rgba[3];
+    }
+
+    // Texel centres, in transfer function entries.
+    std::vector<double> positions(SIZE);
+    for (int i = 0; i < SIZE; i++)
+    {
+        positions[i] = (i + 0.5) / SIZE * entries;
+    }
+    std::vector<std::array<double, 4>> integralAt(SIZE);
+    std::transform(positions.begin(), positions.end(), integralAt.begin(),
+                   [&](double position) { return integrals.at(position); });
+
+    std::vector<int> rows(SIZE);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::for_each(
+        std::execution::par, rows.begin(), rows.end(), [&](int back) {
+            float* row =
+                table.data() + static_cast<std::size_t>(back) * SIZE * CHANNELS;
+            for (int front = 0; front < SIZE; front++)
+            {
+                float* texel = row + static_cast<std::size_t>(front) * CHANNELS;
+                const double length = positions[back] - positions[front];
+                if (front == back)
+                {
+                    // A segment of no length is the sample itself.
+                    const int entry = std::min(
+                        static_cast<int>(positions[front]), entries - 1);
+                    const float* rgba = transferFunction.data() +
+                                        static_cast<std::size_t>(entry) *
+                                            CHANNELS;
+                    std::copy(rgba, rgba + CHANNELS, texel);
+                    continue;
+                }
+                const auto& a = integralAt[front];
+                const auto& b = integralAt[back];
+                const double opacity = b[3] - a[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    texel[c] = opacity != 0.0
+                                   ? static_cast<float>((b[c] - a[c]) / opacity)
+                                   : 0.0f;
+                }
+                texel[3] = static_cast<float>(opacity / length);
+            }
+        });
+    return table;
+}
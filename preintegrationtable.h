@@ -0,0 +1,27 @@
+#ifndef PREINTEGRATIONTABLE_H
+#define PREINTEGRATIONTABLE_H
+
+#include <span>
+#include <vector>
+
+// Colour and opacity of the transfer function integrated over every ray
+// segment between two intensities, so that a sharp peak between two samples
+// is not stepped over. Entry (front, back) holds the opacity weighted mean
+// colour over the segment in RGB and the mean opacity in A. Attenuation
+// within the segment is neglected, which keeps the table independent of the
+// step length: the raycaster turns the mean into the opacity of a segment of
+// any length.
+class PreIntegrationTable
+{
+  public:
+    // Entries along each axis, the front intensity runs along x.
+    constexpr static int SIZE = 512;
+    constexpr static int CHANNELS = 4;
+
+    // transferFunction holds RGBA entries spread evenly over the normalized
+    // intensity range, each covering an equal interval as the nearest
+    // filtered 1D texture does.
+    static std::vector<float> build(std::span<const float> transferFunction);
+};
+
+#endif // PREINTEGRATIONTABLE_H
@@ -1,4 +1,7 @@
 #include "clippingplaneproperties.h"
+
+#include "../tracer.h"
+
 #include <QDebug>
 
 ClippingPlaneProperties::ClippingPlaneProperties(Plane clippingPlane)
@@ -8,6 +11,7 @@ ClippingPlaneProperties::ClippingPlaneProperties(Plane clippingPlane)
 
 void ClippingPlaneProperties::updateClippingPlane(Plane clippingPlane)
 {
+    TRACE_ZONE("ClippingPlaneProperties::updateClippingPlane");
     qDebug() << "ClippingPlane Updated";
     m_clippingPlane = clippingPlane;
     emit clippingPlaneChanged(clippingPlane);
@@ -16,6 +20,35 @@ void ClippingPlaneProperties::updateClippingPlane(Plane clippingPlane)
 void ClippingPlaneProperties::reset()
 {
     updateClippingPlane(Plane{});
+    m_cutPlanes.clear();
+    emit cutPlanesChanged(m_cutPlanes);
+    updateCropBox(CropBox{});
+}
+
+bool ClippingPlaneProperties::addCutPlane(Plane cutPlane)
+{
+    TRACE_ZONE("ClippingPlaneProperties::addCutPlane");
+    if (static_cast<int>(m_cutPlanes.size()) >= MAX_CUT_PLANES)
+        return false;
+    m_cutPlanes.push_back(cutPlane);
+    emit cutPlanesChanged(m_cutPlanes);
+    return true;
+}
+
+void ClippingPlaneProperties::removeCutPlane(int index)
+{
+    TRACE_ZONE("ClippingPlaneProperties::removeCutPlane");
+    if (index < 0 || index >= static_cast<int>(m_cutPlanes.size()))
+        return;
+    m_cutPlanes.erase(m_cutPlanes.begin() + index);
+    emit cutPlanesChanged(m_cutPlanes);
+}
+
+void ClippingPlaneProperties::updateCropBox(CropBox cropBox)
+{
+    TRACE_ZONE("ClippingPlaneProperties::updateCropBox");
+    m_cropBox = cropBox;
+    emit cropBoxChanged(cropBox);
 }
 
 void ClippingPlaneProperties::updateSelectedPoint(QVector3D point)
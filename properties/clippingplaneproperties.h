@@ -4,27 +4,51 @@
 #include "../geometry/plane.h"
 
 #include <QObject>
+#include <vector>
 
+// Axis-aligned box the volume is cropped to, in the same [-1, 1] model
+// coordinates as the planes.
+struct CropBox
+{
+    QVector3D minimum{-1.0f, -1.0f, -1.0f};
+    QVector3D maximum{1.0f, 1.0f, 1.0f};
+};
+
+// The slicing plane, shared by the 2D view and the slice model option, and
+// the cut planes and crop box that clip the 3D view. A cut plane removes the
+// half-space its normal points away from.
 class ClippingPlaneProperties : public QObject
 {
     Q_OBJECT
   public:
+    constexpr static int MAX_CUT_PLANES = 4;
+
     ClippingPlaneProperties(){};
     ClippingPlaneProperties(Plane clippingPlane);
     const Plane& plane() const { return m_clippingPlane; };
     const QVector3D& selectedPoint() const { return m_selectedPoint;};
+    const std::vector<Plane>& cutPlanes() const { return m_cutPlanes; };
+    const CropBox& cropBox() const { return m_cropBox; };
   public slots:
     void updateClippingPlane(Plane clippingPlane);
     void updateSelectedPoint(QVector3D point);
+    // Returns false if there are MAX_CUT_PLANES already.
+    bool addCutPlane(Plane cutPlane);
+    void removeCutPlane(int index);
+    void updateCropBox(CropBox cropBox);
     void reset();
 
   signals:
     void clippingPlaneChanged(Plane clippingPlane);
     void selectedPointChanged(const QVector3D&);
+    void cutPlanesChanged(const std::vector<Plane>& cutPlanes);
+    void cropBoxChanged(const CropBox& cropBox);
 
   private:
     Plane m_clippingPlane;
     QVector3D m_selectedPoint;
+    std::vector<Plane> m_cutPlanes;
+    CropBox m_cropBox;
 };
 
 #endif // CLIPPINGPLANEPROPERTIES_H
@@ -0,0 +1,122 @@
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+#include <tuple>
+
+// The settings the renderers read, as plain fields. generation is advanced
+// by every change made through RenderSettingsProperties, so a renderer that
+// remembers it can tell when there is nothing new to pick up.
+struct RenderSettings
+{
+    bool maxInt{false};
+    bool showSlice{true};
+    bool sliceModel{false};
+    bool sliceSide{false};
+    bool defaultSliceNr{true};
+    int sliceNr{257};
+    bool preIntegration{false};
+    // Raycasts in a compute shader instead of over the rasterized cube.
+    bool computeRaycaster{false};
+    // Shows a counter of the work of every ray in the 3D view instead of the
+    // volume, one of the RayCostView values.
+    int rayCost{0};
+    bool headLight{false};
+    bool specOff{true};
+    float ambientInt{0.1f};
+    float diffuseInt{1.5f};
+    float specInt{1.0f};
+    float specCoeff{60.0f};
+
+    unsigned int generation{0};
+};
+
+// The debug views of RenderSettings::rayCost, matching the RAY_COST views of
+// cube-fs.glsl.
+namespace RayCostView
+{
+enum
+{
+    Off,
+    Samples,
+    ShadedSamples,
+    Fetches,
+    Exit
+};
+} // namespace RayCostView
+
+// One value per field of RenderSettings, carried by the change signal of
+// RenderSettingsProperties so that receivers compare enums, not names.
+enum class RenderSetting
+{
+    MaxInt,
+    ShowSlice,
+    SliceModel,
+    SliceSide,
+    DefaultSliceNr,
+    SliceNr,
+    PreIntegration,
+    ComputeRaycaster,
+    RayCost,
+    HeadLight,
+    SpecOff,
+    AmbientInt,
+    DiffuseInt,
+    SpecInt,
+    SpecCoeff
+};
+
+// Names a field of RenderSettings, for the settings widgets that bind to
+// fields by name and for the shader code that declares them by name.
+template <typename T> struct RenderSettingKey
+{
+    using Type = T;
+    const char* name;
+    T RenderSettings::*field;
+    RenderSetting setting;
+};
+
+namespace RenderSettingKeys
+{
+inline constexpr RenderSettingKey<bool> MAX_INT{
+    "maxInt", &RenderSettings::maxInt, RenderSetting::MaxInt};
+inline constexpr RenderSettingKey<bool> SHOW_SLICE{
+    "showSlice", &RenderSettings::showSlice, RenderSetting::ShowSlice};
+inline constexpr RenderSettingKey<bool> SLICE_MODEL{
+    "sliceModel", &RenderSettings::sliceModel, RenderSetting::SliceModel};
+inline constexpr RenderSettingKey<bool> SLICE_SIDE{
+    "sliceSide", &RenderSettings::sliceSide, RenderSetting::SliceSide};
+inline constexpr RenderSettingKey<bool> DEFAULT_SLICE_NR{
+    "defaultSliceNr", &RenderSettings::defaultSliceNr,
+    RenderSetting::DefaultSliceNr};
+inline constexpr RenderSettingKey<int> SLICE_NR{
+    "sliceNr", &RenderSettings::sliceNr, RenderSetting::SliceNr};
+inline constexpr RenderSettingKey<bool> PRE_INTEGRATION{
+    "preIntegration", &RenderSettings::preIntegration,
+    RenderSetting::PreIntegration};
+inline constexpr RenderSettingKey<bool> COMPUTE_RAYCASTER{
+    "computeRaycaster", &RenderSettings::computeRaycaster,
+    RenderSetting::ComputeRaycaster};
+inline constexpr RenderSettingKey<int> RAY_COST{
+    "rayCost", &RenderSettings::rayCost, RenderSetting::RayCost};
+inline constexpr RenderSettingKey<bool> HEAD_LIGHT{
+    "headLight", &RenderSettings::headLight, RenderSetting::HeadLight};
+inline constexpr RenderSettingKey<bool> SPEC_OFF{
+    "specOff", &RenderSettings::specOff, RenderSetting::SpecOff};
+inline constexpr RenderSettingKey<float> AMBIENT_INT{
+    "ambientInt", &RenderSettings::ambientInt, RenderSetting::AmbientInt};
+inline constexpr RenderSettingKey<float> DIFFUSE_INT{
+    "diffuseInt", &RenderSettings::diffuseInt, RenderSetting::DiffuseInt};
+inline constexpr RenderSettingKey<float> SPEC_INT{
+    "specInt", &RenderSettings::specInt, RenderSetting::SpecInt};
+inline constexpr RenderSettingKey<float> SPEC_COEFF{
+    "specCoeff", &RenderSettings::specCoeff, RenderSetting::SpecCoeff};
+
+// RAY_COST is left out, it is a debug view of the GPU raycaster only and set
+// from the performance panel.
+inline constexpr std::tuple ALL{
+    MAX_INT, SHOW_SLICE, SLICE_MODEL, SLICE_SIDE, DEFAULT_SLICE_NR, SLICE_NR,
+    PRE_INTEGRATION, COMPUTE_RAYCASTER, HEAD_LIGHT, SPEC_OFF, AMBIENT_INT,
+    DIFFUSE_INT, SPEC_INT, SPEC_COEFF};
+} // namespace RenderSettingKeys
+
+#endif // RENDERSETTINGS_H
@@ -1,20 +1,27 @@
 #include "rendersettingsproperties.h"
 
+#include "../tracer.h"
+
 RenderSettingsProperties::RenderSettingsProperties(
     RenderSettings renderSettings)
     : m_renderSettings{renderSettings}
 {
 }
 
-void RenderSettingsProperties::updateRenderSettings(
-    RenderSettings renderSettings)
-{
-    m_renderSettings = renderSettings;
-    emit renderSettingsChanged(m_renderSettings);
-}
-
-void RenderSettingsProperties::updateSingleRenderSetting(QString key, RenderTypes value)
+void RenderSettingsProperties::updateSingleRenderSetting(QString name,
+                                                         RenderTypes value)
 {
-    m_renderSettings[key] = value;
-    emit renderSettingsChanged(m_renderSettings);
+    TRACE_ZONE("RenderSettingsProperties::updateSingleRenderSetting");
+    std::apply(
+        [&](const auto&... keys) {
+            auto update = [&](const auto& key) {
+                using T = typename std::decay_t<decltype(key)>::Type;
+                if (name != key.name || !std::holds_alternative<T>(value))
+                    return false;
+                set(key, std::get<T>(value));
+                return true;
+            };
+            (update(keys) || ...);
+        },
+        RenderSettingKeys::ALL);
 }
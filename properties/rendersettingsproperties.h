@@ -1,11 +1,13 @@
 #ifndef RENDERSETTINGSPROPERTIES_H
 #define RENDERSETTINGSPROPERTIES_H
 
+#include "rendersettings.h"
+
 #include <QObject>
 #include <QString>
+#include <variant>
 
 using RenderTypes = std::variant<float, int, bool>;
-using RenderSettings = std::map<QString, RenderTypes>;
 
 class RenderSettingsProperties : public QObject
 {
@@ -13,12 +15,24 @@ class RenderSettingsProperties : public QObject
   public:
     RenderSettingsProperties(RenderSettings renderSettings);
     const RenderSettings& renderSettings() const { return m_renderSettings; };
+
+    template <typename T> void set(RenderSettingKey<T> key, T value)
+    {
+        if (m_renderSettings.*key.field == value)
+            return;
+        m_renderSettings.*key.field = value;
+        m_renderSettings.generation++;
+        emit renderSettingChanged(key.setting);
+        emit renderSettingsChanged(m_renderSettings);
+    };
+
   public slots:
-    void updateRenderSettings(RenderSettings renderSettings);
-    void updateSingleRenderSetting(QString, RenderTypes);
+    // Binds the settings widgets, which address the settings by name.
+    void updateSingleRenderSetting(QString name, RenderTypes value);
 
   signals:
-    void renderSettingsChanged(RenderSettings renderSettings);
+    void renderSettingChanged(RenderSetting setting);
+    void renderSettingsChanged(const RenderSettings& renderSettings);
 
   private:
     RenderSettings m_renderSettings;
@@ -1,4 +1,7 @@
 #include "transferproperties.h"
+
+#include "../tracer.h"
+
 namespace tfn
 {
 TransferProperties::TransferProperties(){};
@@ -7,11 +10,13 @@ TransferProperties::TransferProperties(QString cmap, TransferFunction tfn) : m_c
 
 void TransferProperties::updateColorMap(QString cmap)
 {
+    TRACE_ZONE("TransferProperties::updateColorMap");
     m_colorMap = cmap;
     emit colorMapChanged(cmap);
 };
 
 void TransferProperties::updateTransferFunction(TransferFunction tfn){
+    TRACE_ZONE("TransferProperties::updateTransferFunction");
     m_tfn = tfn;
     emit transferFunctionChanged(tfn);
 };
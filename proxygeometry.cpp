@@ -0,0 +1,80 @@
+#include "proxygeometry.h"
+
+#include <algorithm>
+#include <array>
+
+std::vector<QVector3D>
+ProxyGeometry::build(std::span<const unsigned char> occupancy, int channel,
+                     const EmptySpaceGrid& grid, const QVector3D& dimensions)
+{
+    const std::array<int, 3> blocks{grid.width(), grid.height(), grid.depth()};
+    if (occupancy.size() !=
+        grid.blockCount() * EmptySpaceGrid::OCCUPANCY_CHANNELS)
+        return {};
+
+    auto visible = [&](std::array<int, 3> block) {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (block[axis] < 0 || block[axis] >= blocks[axis])
+                return false;
+        }
+        const std::size_t index =
+            block[0] +
+            static_cast<std::size_t>(blocks[0]) *
+                (block[1] + static_cast<std::size_t>(blocks[1]) * block[2]);
+        return occupancy[index * EmptySpaceGrid::OCCUPANCY_CHANNELS +
+                         channel] != 0;
+    };
+    // Block boundary i along an axis, from voxels to [-1, 1].
+    auto boundary = [&](int axis, int i) {
+        const float voxel =
+            static_cast<float>(i * EmptySpaceGrid::BLOCK_SIZE);
+        return 2.0f * std::min(voxel / dimensions[axis], 1.0f) - 1.0f;
+    };
+
+    std::vector<QVector3D> vertices;
+    std::array<int, 3> block;
+    for (block[2] = 0; block[2] < blocks[2]; block[2]++)
+    {
+        for (block[1] = 0; block[1] < blocks[1]; block[1]++)
+        {
+            for (block[0] = 0; block[0] < blocks[0]; block[0]++)
+            {
+                if (!visible(block))
+                    continue;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    // u and v follow axis cyclically, so u x v points along
+                    // the axis and a face counter-clockwise in (u, v) faces
+                    // the positive side.
+                    const int u = (axis + 1) % 3;
+                    const int v = (axis + 2) % 3;
+                    for (int side : {0, 1})
+                    {
+                        std::array<int, 3> neighbour = block;
+                        neighbour[axis] += side == 0 ? -1 : 1;
+                        if (visible(neighbour))
+                            continue;
+
+                        std::array<QVector3D, 4> corners;
+                        for (int corner = 0; corner < 4; corner++)
+                        {
+                            const int du = corner == 1 || corner == 2 ? 1 : 0;
+                            const int dv = corner >= 2 ? 1 : 0;
+                            corners[corner][axis] =
+                                boundary(axis, block[axis] + side);
+                            corners[corner][u] = boundary(u, block[u] + du);
+                            corners[corner][v] = boundary(v, block[v] + dv);
+                        }
+                        if (side == 0)
+                            std::swap(corners[1], corners[3]);
+                        vertices.insert(vertices.end(),
+                                        {corners[0], corners[1], corners[2],
+                                         corners[2], corners[3], corners[0]});
+                    }
+                }
+            }
+        }
+    }
+    return vertices;
+}
@@ -0,0 +1,29 @@
+#ifndef PROXYGEOMETRY_H
+#define PROXYGEOMETRY_H
+
+#include "emptyspacegrid.h"
+
+#include <QVector3D>
+#include <span>
+#include <vector>
+
+// A mesh wrapped tightly around the visible blocks of the empty space grid,
+// in the model coordinates of the unit cube. Rasterizing its front and back
+// faces tells the raycaster where each ray first enters and last leaves
+// anything visible, so the empty corners of the bounding box are not
+// marched at all.
+class ProxyGeometry
+{
+  public:
+    // Emits two triangles for every face between a visible block and an
+    // invisible block or the outside of the grid, wound counter-clockwise
+    // seen from outside. Faces between visible blocks are left out, so the
+    // mesh is closed. Blocks are visible where channel of their occupancy
+    // entry is set, and are clamped to the voxels of a volume of the given
+    // dimensions.
+    static std::vector<QVector3D> build(std::span<const unsigned char> occupancy,
+                                        int channel, const EmptySpaceGrid& grid,
+                                        const QVector3D& dimensions);
+};
+
+#endif // PROXYGEOMETRY_H
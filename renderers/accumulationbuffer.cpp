@@ -0,0 +1,48 @@
+#include "accumulationbuffer.h"
+
+AccumulationBuffer::AccumulationBuffer(QOpenGLExtraFunctions& openGLExtra)
+    : m_openGLExtra{openGLExtra}
+{
+}
+
+void AccumulationBuffer::compileShader()
+{
+    if (!m_program.addShaderFromSourceFile(QOpenGLShader::Vertex,
+                                           ":shaders/accumulate-vs.glsl"))
+        qDebug() << "Could not load vertex shader!";
+
+    if (!m_program.addShaderFromSourceFile(QOpenGLShader::Fragment,
+                                           ":shaders/accumulate-fs.glsl"))
+        qDebug() << "Could not load fragment shader!";
+
+    if (!m_program.link())
+        qDebug() << "Could not link shader program!";
+}
+
+void AccumulationBuffer::add(GLuint texture, QSize size, int pass)
+{
+    if (!m_framebuffer || m_framebuffer->size() != size)
+    {
+        QOpenGLFramebufferObjectFormat format;
+        format.setInternalTextureFormat(GL_RGBA32F);
+        m_framebuffer = std::make_unique<QOpenGLFramebufferObject>(size, format);
+        pass = 0;
+    }
+
+    m_framebuffer->bind();
+    m_openGLExtra.glViewport(0, 0, size.width(), size.height());
+    m_openGLExtra.glEnable(GL_BLEND);
+    m_openGLExtra.glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    m_openGLExtra.glBlendColor(0.0f, 0.0f, 0.0f, 1.0f / (pass + 1));
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0);
+    m_openGLExtra.glBindTexture(GL_TEXTURE_2D, texture);
+
+    m_program.bind();
+    m_program.setUniformValue(0, 0);
+    m_openGLExtra.glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_program.release();
+
+    m_openGLExtra.glBindTexture(GL_TEXTURE_2D, 0);
+    m_openGLExtra.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_framebuffer->release();
+}
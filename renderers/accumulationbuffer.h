@@ -0,0 +1,27 @@
+#ifndef ACCUMULATIONBUFFER_H
+#define ACCUMULATIONBUFFER_H
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <memory>
+
+// Running mean of the passes of a progressively refined image, kept in a
+// float framebuffer so that many passes add up without banding.
+class AccumulationBuffer
+{
+  public:
+    explicit AccumulationBuffer(QOpenGLExtraFunctions& openGLExtra);
+    void compileShader();
+    // Adds a pass rendered into texture, of the given size. Pass 0 replaces
+    // the contents, pass n is weighted 1 / (n + 1).
+    void add(GLuint texture, QSize size, int pass);
+    QOpenGLFramebufferObject* framebuffer() { return m_framebuffer.get(); };
+
+  private:
+    QOpenGLExtraFunctions& m_openGLExtra;
+    QOpenGLShaderProgram m_program;
+    std::unique_ptr<QOpenGLFramebufferObject> m_framebuffer;
+};
+
+#endif // ACCUMULATIONBUFFER_H
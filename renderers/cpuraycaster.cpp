@@ -0,0 +1,595 @@
+#include "cpuraycaster.h"
+
+#include <QMatrix4x4>
+#include <QVector2D>
+#include <QVector4D>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPURAYCASTER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+constexpr int PACKET_SIZE = CpuRaycaster::PACKET_SIZE;
+using Lanes = std::array<float, PACKET_SIZE>;
+
+// The padded volume as the samplers see it.
+struct Grid
+{
+    const unsigned short* voxels;
+    int width;
+    int height;
+    int depth;
+};
+
+// Splits a texture coordinate into the padded index of the lower corner and
+// the weight of the upper one. Clamping to the border voxels on either side
+// gives the same result as the zero border colour of the texture.
+inline void corner(float coordinate, int size, int& index, float& weight)
+{
+    const float texel =
+        std::clamp(coordinate * size - 0.5f, -1.0f, static_cast<float>(size));
+    const int lower =
+        std::min(static_cast<int>(std::floor(texel)), size - 1);
+    weight = texel - lower;
+    index = lower + 1;
+}
+
+// One trilinear sample per lane, normalized as a texture fetch of the 16-bit
+// volume and scaled to the range of the transfer function.
+void sampleScalar(const Grid& grid, const Lanes& x, const Lanes& y,
+                  const Lanes& z, Lanes& values)
+{
+    const int rowSize = grid.width + 2;
+    const int sliceSize = rowSize * (grid.height + 2);
+    for (int lane = 0; lane < PACKET_SIZE; lane++)
+    {
+        int i, j, k;
+        float wx, wy, wz;
+        corner(x[lane], grid.width, i, wx);
+        corner(y[lane], grid.height, j, wy);
+        corner(z[lane], grid.depth, k, wz);
+        const unsigned short* v =
+            grid.voxels + i + static_cast<std::ptrdiff_t>(rowSize) * j +
+            static_cast<std::ptrdiff_t>(sliceSize) * k;
+        auto row = [&](const unsigned short* r) {
+            return r[0] + wx * (r[1] - r[0]);
+        };
+        const float front = row(v) + wy * (row(v + rowSize) - row(v));
+        const float back = row(v + sliceSize) +
+                           wy * (row(v + sliceSize + rowSize) -
+                                 row(v + sliceSize));
+        values[lane] = (front + wz * (back - front)) *
+                       (VolumeData::INTENSITY_SCALE /
+                        std::numeric_limits<unsigned short>::max());
+    }
+}
+
+#ifdef CPURAYCASTER_X86
+#if defined(__GNUC__) || defined(__clang__)
+#define CPURAYCASTER_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define CPURAYCASTER_AVX2
+#endif
+
+CPURAYCASTER_AVX2 inline __m256 cornerAvx2(__m256 coordinate, int size,
+                                            __m256i& index)
+{
+    const __m256 texel = _mm256_min_ps(
+        _mm256_max_ps(_mm256_fmsub_ps(coordinate,
+                                      _mm256_set1_ps(static_cast<float>(size)),
+                                      _mm256_set1_ps(0.5f)),
+                      _mm256_set1_ps(-1.0f)),
+        _mm256_set1_ps(static_cast<float>(size)));
+    const __m256 lower = _mm256_min_ps(
+        _mm256_floor_ps(texel), _mm256_set1_ps(static_cast<float>(size - 1)));
+    index = _mm256_add_epi32(_mm256_cvtps_epi32(lower), _mm256_set1_epi32(1));
+    return _mm256_sub_ps(texel, lower);
+}
+
+// The two voxels along x of each lane in one 32-bit gather, the lower one in
+// the low half.
+CPURAYCASTER_AVX2 inline __m256 rowAvx2(const unsigned short* voxels,
+                                         __m256i index, __m256 weight)
+{
+    const __m256i pair = _mm256_i32gather_epi32(
+        reinterpret_cast<const int*>(voxels), index, 2);
+    const __m256 lower =
+        _mm256_cvtepi32_ps(_mm256_and_si256(pair, _mm256_set1_epi32(0xffff)));
+    const __m256 upper = _mm256_cvtepi32_ps(_mm256_srli_epi32(pair, 16));
+    return _mm256_fmadd_ps(weight, _mm256_sub_ps(upper, lower), lower);
+}
+
+CPURAYCASTER_AVX2 void sampleAvx2(const Grid& grid, const Lanes& x,
+                                  const Lanes& y, const Lanes& z,
+                                  Lanes& values)
+{
+    const int rowSize = grid.width + 2;
+    const int sliceSize = rowSize * (grid.height + 2);
+    __m256i i, j, k;
+    const __m256 wx = cornerAvx2(_mm256_loadu_ps(x.data()), grid.width, i);
+    const __m256 wy = cornerAvx2(_mm256_loadu_ps(y.data()), grid.height, j);
+    const __m256 wz = cornerAvx2(_mm256_loadu_ps(z.data()), grid.depth, k);
+    const __m256i index = _mm256_add_epi32(
+        i, _mm256_add_epi32(_mm256_mullo_epi32(j, _mm256_set1_epi32(rowSize)),
+                            _mm256_mullo_epi32(k, _mm256_set1_epi32(sliceSize))));
+    const __m256i nextRow = _mm256_set1_epi32(rowSize);
+    const __m256i nextSlice = _mm256_set1_epi32(sliceSize);
+
+    const __m256 frontLower = rowAvx2(grid.voxels, index, wx);
+    const __m256 frontUpper =
+        rowAvx2(grid.voxels, _mm256_add_epi32(index, nextRow), wx);
+    const __m256i backIndex = _mm256_add_epi32(index, nextSlice);
+    const __m256 backLower = rowAvx2(grid.voxels, backIndex, wx);
+    const __m256 backUpper =
+        rowAvx2(grid.voxels, _mm256_add_epi32(backIndex, nextRow), wx);
+    const __m256 front = _mm256_fmadd_ps(
+        wy, _mm256_sub_ps(frontUpper, frontLower), frontLower);
+    const __m256 back =
+        _mm256_fmadd_ps(wy, _mm256_sub_ps(backUpper, backLower), backLower);
+    const __m256 value =
+        _mm256_fmadd_ps(wz, _mm256_sub_ps(back, front), front);
+    _mm256_storeu_ps(
+        values.data(),
+        _mm256_mul_ps(value,
+                      _mm256_set1_ps(VolumeData::INTENSITY_SCALE /
+                                     std::numeric_limits<unsigned short>::max())));
+}
+#endif
+
+using SampleFunction = void (*)(const Grid&, const Lanes&, const Lanes&,
+                                const Lanes&, Lanes&);
+
+// Shortens [interval.x, interval.y] of origin + s * direction to the kept
+// side of the plane, as clipToPlane in cube-fs.glsl.
+QVector2D clipToPlane(QVector2D interval, const QVector3D& origin,
+                      const QVector3D& direction, const QVector4D& plane)
+{
+    const float distance =
+        QVector3D::dotProduct(plane.toVector3D(), origin) + plane.w();
+    const float rate = QVector3D::dotProduct(plane.toVector3D(), direction);
+    if (rate == 0.0f)
+        return distance >= 0.0f ? interval : QVector2D(interval.x(), interval.x());
+    const float s = -distance / rate;
+    return rate > 0.0f ? QVector2D(std::max(interval.x(), s), interval.y())
+                       : QVector2D(interval.x(), std::min(interval.y(), s));
+}
+
+QVector2D clipToBox(QVector2D interval, const QVector3D& origin,
+                    const QVector3D& direction, const QVector3D& minimum,
+                    const QVector3D& maximum)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float a = (minimum[axis] - origin[axis]) / direction[axis];
+        const float b = (maximum[axis] - origin[axis]) / direction[axis];
+        // A ray parallel to the slabs gives NaN in the first or second
+        // place, which std::max and std::min then pass over.
+        interval.setX(std::max(interval.x(), std::min(a, b)));
+        interval.setY(std::min(interval.y(), std::max(a, b)));
+    }
+    return interval;
+}
+
+// Hands out tiles to a pool of threads. Every thread starts on its own
+// contiguous share, and once that runs out takes the remaining tiles of the
+// others one by one, so a thread stuck on expensive tiles is helped out.
+template <typename Function>
+void forEachTile(int tileCount, int threadCount, const Function& function)
+{
+    threadCount = std::clamp(threadCount, 1, std::max(tileCount, 1));
+    struct alignas(64) Share
+    {
+        std::atomic<int> next;
+        int end;
+    };
+    std::vector<Share> shares(threadCount);
+    for (int thread = 0; thread < threadCount; thread++)
+    {
+        shares[thread].next = tileCount * thread / threadCount;
+        shares[thread].end = tileCount * (thread + 1) / threadCount;
+    }
+
+    auto work = [&](int thread) {
+        for (int offset = 0; offset < threadCount; offset++)
+        {
+            Share& share = shares[(thread + offset) % threadCount];
+            for (int tile = share.next++; tile < share.end;
+                 tile = share.next++)
+            {
+                function(tile);
+            }
+        }
+    };
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount - 1);
+    for (int thread = 1; thread < threadCount; thread++)
+    {
+        threads.emplace_back(work, thread);
+    }
+    work(0);
+}
+} // namespace
+
+// Everything that stays the same over a frame, in the spaces cube-fs.glsl
+// uses: rays in world space, and positions along them in texture space.
+struct CpuRaycaster::Frame
+{
+    Grid grid;
+    SampleFunction sample;
+    const RenderSettings* settings;
+    QSize size;
+    QMatrix4x4 inverseView;
+    QVector3D rayOrigin;
+    float aspectRatio;
+    float focalLength;
+    QVector3D top;
+    QVector3D bottom;
+    float stepLength;
+    float sliceCount;
+    std::vector<QVector4D> planes;
+    QVector3D cropMinimum;
+    QVector3D cropMaximum;
+    QVector3D background;
+    // Taken once up front, as QImage::scanLine() is not safe to call from
+    // several threads.
+    uchar* pixels;
+    qsizetype bytesPerLine;
+};
+
+CpuRaycaster::CpuRaycaster(std::shared_ptr<const VolumeData> volume,
+                           QVector3D spacing)
+    : m_width{volume->width()}, m_height{volume->height()},
+      m_depth{volume->depth()}
+{
+    const int rowSize = m_width + 2;
+    const std::size_t sliceSize =
+        static_cast<std::size_t>(rowSize) * (m_height + 2);
+    m_voxels.assign(sliceSize * (m_depth + 2), 0);
+    const auto voxels = volume->voxels();
+    std::vector<int> slices(m_depth);
+    std::iota(slices.begin(), slices.end(), 0);
+    std::for_each(std::execution::par, slices.begin(), slices.end(),
+                  [&](int z) {
+                      for (int y = 0; y < m_height; y++)
+                      {
+                          const auto source = voxels.begin() +
+                                              (static_cast<std::size_t>(z) *
+                                                   m_height +
+                                               y) *
+                                                  m_width;
+                          std::copy(source, source + m_width,
+                                    m_voxels.begin() + (z + 1) * sliceSize +
+                                        (y + 1) * rowSize + 1);
+                      }
+                  });
+
+    m_scaleFactor = volume->dimensions() * spacing;
+    m_scaleFactor /= std::max(
+        {m_scaleFactor.x(), m_scaleFactor.y(), m_scaleFactor.z()});
+}
+
+void CpuRaycaster::setTransferFunction(std::span<const float> transferFunction)
+{
+    m_transferFunction.assign(transferFunction.begin(), transferFunction.end());
+}
+
+bool CpuRaycaster::avx2Supported()
+{
+#ifdef CPURAYCASTER_X86
+#ifdef _MSC_VER
+    int registers[4];
+    __cpuidex(registers, 7, 0);
+    const bool avx2 = (registers[1] & (1 << 5)) != 0;
+    __cpuid(registers, 1);
+    const bool fma = (registers[2] & (1 << 12)) != 0;
+    return avx2 && fma;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#else
+    return false;
+#endif
+}
+
+QImage CpuRaycaster::render(const CameraProperties& camera,
+                            const RenderSettings& settings, QSize size,
+                            QColor background) const
+{
+    QImage image(size, QImage::Format_RGBA8888);
+    if (size.isEmpty())
+        return image;
+
+    Frame frame{};
+    frame.grid = Grid{m_voxels.data(), m_width, m_height, m_depth};
+    frame.sample = sampleScalar;
+#ifdef CPURAYCASTER_X86
+    // The gathers address voxels with 32-bit indices.
+    if (m_instructions == Instructions::Avx2 && avx2Supported() &&
+        m_voxels.size() < static_cast<std::size_t>(
+                              std::numeric_limits<int>::max()))
+        frame.sample = sampleAvx2;
+#endif
+    frame.settings = &settings;
+    frame.size = size;
+    const QMatrix4x4 viewMatrix = camera.viewMatrix();
+    // Directions are multiplied from the left in the shader, which applies
+    // the transpose.
+    frame.inverseView = viewMatrix.transposed();
+    frame.rayOrigin = viewMatrix.inverted().map(QVector3D(0, 0, 0));
+    frame.aspectRatio = static_cast<float>(size.width()) / size.height();
+    frame.focalLength = camera.focalLength();
+    frame.top = m_scaleFactor;
+    frame.bottom = -m_scaleFactor;
+    frame.sliceCount = static_cast<float>(m_width);
+    frame.stepLength = settings.defaultSliceNr
+                           ? 1.0f / frame.sliceCount
+                           : 1.0f / static_cast<float>(settings.sliceNr);
+
+    // Clipping in texture space.
+    if (settings.sliceModel)
+    {
+        const QVector3D normal = settings.sliceSide ? -m_slicingPlane.normal()
+                                                    : m_slicingPlane.normal();
+        const QVector3D point =
+            (m_slicingPlane.point() + QVector3D(1, 1, 1)) * 0.5f;
+        frame.planes.emplace_back(normal, -QVector3D::dotProduct(normal, point));
+    }
+    for (const Plane& plane : m_cutPlanes)
+    {
+        const QVector3D point = (plane.point() + QVector3D(1, 1, 1)) * 0.5f;
+        frame.planes.emplace_back(plane.normal(),
+                                  -QVector3D::dotProduct(plane.normal(), point));
+    }
+    frame.cropMinimum = (m_cropBox.minimum + QVector3D(1, 1, 1)) * 0.5f;
+    frame.cropMaximum = (m_cropBox.maximum + QVector3D(1, 1, 1)) * 0.5f;
+    frame.background = QVector3D(background.redF(), background.greenF(),
+                                 background.blueF());
+    frame.pixels = image.bits();
+    frame.bytesPerLine = image.bytesPerLine();
+
+    const int tilesAcross = (size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    const int tilesDown = (size.height() + TILE_SIZE - 1) / TILE_SIZE;
+    const int threadCount =
+        m_threadCount > 0
+            ? m_threadCount
+            : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    forEachTile(tilesAcross * tilesDown, threadCount, [&](int tile) {
+        const int x0 = (tile % tilesAcross) * TILE_SIZE;
+        const int y0 = (tile / tilesAcross) * TILE_SIZE;
+        const int x1 = std::min(x0 + TILE_SIZE, size.width());
+        const int y1 = std::min(y0 + TILE_SIZE, size.height());
+        for (int y = y0; y < y1; y++)
+        {
+            for (int x = x0; x < x1; x += PACKET_SIZE)
+            {
+                renderPacket(frame, x, y, std::min(PACKET_SIZE, x1 - x));
+            }
+        }
+    });
+    return image;
+}
+
+// Marches the rays through count pixels of a row in lockstep, y counting up
+// from the bottom as gl_FragCoord does. Lanes whose ray has ended keep
+// sampling their last position until the whole packet is done.
+void CpuRaycaster::renderPacket(const Frame& frame, int x, int y,
+                                int count) const
+{
+    const RenderSettings& settings = *frame.settings;
+    const QVector3D boxSize = frame.top - frame.bottom;
+
+    Lanes px{}, py{}, pz{}, remaining{};
+    std::array<QVector3D, PACKET_SIZE> step{};
+    std::array<QVector4D, PACKET_SIZE> color{};
+    Lanes maxIntensity{};
+    std::array<bool, PACKET_SIZE> active{};
+    int activeCount = 0;
+
+    for (int lane = 0; lane < count; lane++)
+    {
+        QVector3D direction(
+            2.0f * (x + lane + 0.5f) / frame.size.width() - 1.0f,
+            2.0f * (y + 0.5f) / frame.size.height() - 1.0f, -frame.focalLength);
+        direction.setX(direction.x() * frame.aspectRatio);
+        direction = frame.inverseView.mapVector(direction);
+
+        // Slab intersection with the box the volume is drawn in.
+        float tmin = 0.0f;
+        float tmax = std::numeric_limits<float>::max();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const float a =
+                (frame.top[axis] - frame.rayOrigin[axis]) / direction[axis];
+            const float b =
+                (frame.bottom[axis] - frame.rayOrigin[axis]) / direction[axis];
+            tmin = std::max(tmin, std::min(a, b));
+            tmax = std::min(tmax, std::max(a, b));
+        }
+        if (!(tmin < tmax))
+            continue;
+
+        QVector3D rayStart =
+            (frame.rayOrigin + direction * tmin - frame.bottom) / boxSize;
+        const QVector3D rayEnd =
+            (frame.rayOrigin + direction * tmax - frame.bottom) / boxSize;
+        const float rayLength = (rayEnd - rayStart).length();
+        const QVector3D unit = (rayEnd - rayStart) / rayLength;
+
+        QVector2D interval(0.0f, rayLength);
+        for (const QVector4D& plane : frame.planes)
+        {
+            interval = clipToPlane(interval, rayStart, unit, plane);
+        }
+        interval = clipToBox(interval, rayStart, unit, frame.cropMinimum,
+                             frame.cropMaximum);
+
+        step[lane] = unit * frame.stepLength;
+        // The first sample lies a step into the ray.
+        rayStart += unit * interval.x() + step[lane];
+        px[lane] = rayStart.x();
+        py[lane] = rayStart.y();
+        pz[lane] = rayStart.z();
+        remaining[lane] = interval.y() - interval.x();
+        active[lane] = remaining[lane] > 0.0f;
+        activeCount += active[lane] ? 1 : 0;
+    }
+
+    const auto& transferFunction = m_transferFunction;
+    const int entries =
+        static_cast<int>(transferFunction.size()) / 4;
+    auto lookup = [&](float intensity) {
+        if (entries == 0)
+            return QVector4D();
+        const int entry = std::clamp(
+            static_cast<int>(std::floor(intensity * entries)), 0, entries - 1);
+        const float* rgba = transferFunction.data() + 4 * entry;
+        return QVector4D(rgba[0], rgba[1], rgba[2], rgba[3]);
+    };
+    const float dx = 1.0f / frame.grid.width;
+    const float dy = 1.0f / frame.grid.height;
+    const float dz = 1.0f / frame.grid.depth;
+
+    Lanes intensity{};
+    std::array<QVector4D, PACKET_SIZE> source{};
+    std::array<bool, PACKET_SIZE> shade{};
+    while (activeCount > 0)
+    {
+        frame.sample(frame.grid, px, py, pz, intensity);
+
+        bool anyShaded = false;
+        for (int lane = 0; lane < count; lane++)
+        {
+            shade[lane] = false;
+            if (!active[lane])
+                continue;
+            if (settings.maxInt)
+            {
+                maxIntensity[lane] = std::max(maxIntensity[lane],
+                                              intensity[lane]);
+                continue;
+            }
+            source[lane] = lookup(intensity[lane]);
+            shade[lane] = source[lane].w() > 0.0f;
+            anyShaded = anyShaded || shade[lane];
+        }
+
+        if (anyShaded)
+        {
+            // Central differences at all lanes, six samples a packet.
+            Lanes offset, lower, upper;
+            std::array<QVector3D, PACKET_SIZE> gradient{};
+            auto difference = [&](Lanes& coordinate, float delta, int axis) {
+                offset = coordinate;
+                for (int lane = 0; lane < PACKET_SIZE; lane++)
+                    coordinate[lane] = offset[lane] + delta;
+                frame.sample(frame.grid, px, py, pz, upper);
+                for (int lane = 0; lane < PACKET_SIZE; lane++)
+                    coordinate[lane] = offset[lane] - delta;
+                frame.sample(frame.grid, px, py, pz, lower);
+                coordinate = offset;
+                for (int lane = 0; lane < PACKET_SIZE; lane++)
+                    gradient[lane][axis] =
+                        1.0f / (2 * delta) * (upper[lane] - lower[lane]);
+            };
+            difference(px, dx, 0);
+            difference(py, dy, 1);
+            difference(pz, dz, 2);
+
+            for (int lane = 0; lane < count; lane++)
+            {
+                if (!shade[lane])
+                    continue;
+                const QVector3D position(px[lane], py[lane], pz[lane]);
+                QVector4D& src = source[lane];
+                QVector3D rgb = src.toVector3D();
+
+                // Blinn-Phong as ShadeBlinnPhong, where specOff enables the
+                // specular term.
+                QVector3D normal = gradient[lane];
+                if (!normal.isNull())
+                {
+                    normal.normalize();
+                    const QVector3D lightDir =
+                        -(settings.headLight ? frame.rayOrigin
+                                             : m_lightPosition - position)
+                             .normalized();
+                    const QVector3D eyeDir =
+                        (frame.rayOrigin - position).normalized();
+                    const float dotDiff =
+                        std::max(0.0f, QVector3D::dotProduct(lightDir, normal));
+                    float specularValue = 0.0f;
+                    if (dotDiff > 0.0f && settings.specOff)
+                    {
+                        QVector3D halfway = lightDir + eyeDir;
+                        halfway = halfway.isNull() ? -lightDir
+                                                   : halfway.normalized();
+                        const float specAngle = std::max(
+                            0.0f, QVector3D::dotProduct(normal, halfway));
+                        specularValue = std::pow(specAngle, settings.specCoeff);
+                    }
+                    rgb = rgb * (settings.ambientInt +
+                                 settings.diffuseInt * dotDiff) +
+                          QVector3D(1, 1, 1) * settings.specInt * specularValue;
+                }
+
+                // Corrected for the step length, as in cube-fs.glsl.
+                const float alpha = 1.0f - std::exp(-src.w() * frame.stepLength *
+                                                    frame.sliceCount);
+                const QVector4D premultiplied(rgb * alpha, alpha);
+                color[lane] += (1.0f - color[lane].w()) * premultiplied;
+                if (color[lane].w() > 0.99f)
+                {
+                    active[lane] = false;
+                    activeCount--;
+                }
+            }
+        }
+
+        for (int lane = 0; lane < count; lane++)
+        {
+            if (!active[lane])
+                continue;
+            remaining[lane] -= frame.stepLength;
+            px[lane] += step[lane].x();
+            py[lane] += step[lane].y();
+            pz[lane] += step[lane].z();
+            if (remaining[lane] <= 0.0f)
+            {
+                active[lane] = false;
+                activeCount--;
+            }
+        }
+    }
+
+    // Blended over the background as glBlendFunc(GL_SRC_ALPHA,
+    // GL_ONE_MINUS_SRC_ALPHA) does.
+    uchar* row = frame.pixels +
+                 (frame.size.height() - 1 - y) * frame.bytesPerLine + 4 * x;
+    for (int lane = 0; lane < count; lane++)
+    {
+        const QVector4D rayColor =
+            settings.maxInt ? lookup(maxIntensity[lane]) : color[lane];
+        const QVector3D pixel =
+            rayColor.toVector3D() * rayColor.w() +
+            frame.background * (1.0f - rayColor.w());
+        for (int channel = 0; channel < 3; channel++)
+        {
+            row[4 * lane + channel] = static_cast<uchar>(
+                std::lround(std::clamp(pixel[channel], 0.0f, 1.0f) * 255.0f));
+        }
+        row[4 * lane + 3] = 255;
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef CPURAYCASTER_H
+#define CPURAYCASTER_H
+
+#include "../geometry/plane.h"
+#include "../properties/cameraproperties.h"
+#include "../properties/clippingplaneproperties.h"
+#include "../properties/rendersettings.h"
+#include "../volumedata.h"
+
+#include <QColor>
+#include <QImage>
+#include <QSize>
+#include <QVector3D>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Raycasts a volume on the CPU following the model of cube-fs.glsl: trilinear
+// samples from level 0, a nearest lookup in the transfer function,
+// Blinn-Phong shading with central difference gradients, maximum intensity
+// projection, the slicing plane, cut planes and crop box, and early ray
+// termination. It renders where there is no GPU, and is the reference the
+// GPU paths are compared against. Pre-integration, empty space skipping,
+// level of detail and the sampling jitter are GPU optimizations it leaves
+// out.
+//
+// The image is split into tiles that all cores take from, taking over the
+// tiles of slower threads once their own run out. Rays are marched in
+// packets of PACKET_SIZE, whose samples are taken with AVX2 where the CPU
+// supports it.
+class CpuRaycaster
+{
+  public:
+    constexpr static int TILE_SIZE = 16;
+    constexpr static int PACKET_SIZE = 8;
+
+    enum class Instructions
+    {
+        Scalar,
+        Avx2
+    };
+
+    // spacing is the grid spacing of the .ini file, which gives the box the
+    // volume is drawn in its proportions.
+    explicit CpuRaycaster(std::shared_ptr<const VolumeData> volume,
+                          QVector3D spacing = QVector3D(1, 1, 1));
+
+    // RGBA entries spread evenly over the normalized intensity range, as
+    // held by TransferTexture.
+    void setTransferFunction(std::span<const float> transferFunction);
+    // Planes and the crop box are in the [-1, 1] model coordinates of
+    // ClippingPlaneProperties.
+    void setSlicingPlane(const Plane& plane) { m_slicingPlane = plane; };
+    void setCutPlanes(const std::vector<Plane>& cutPlanes)
+    {
+        m_cutPlanes = cutPlanes;
+    };
+    void setCropBox(const CropBox& cropBox) { m_cropBox = cropBox; };
+    void setLightPosition(QVector3D position) { m_lightPosition = position; };
+    // Avx2 falls back to Scalar on CPUs without it.
+    void setInstructions(Instructions instructions)
+    {
+        m_instructions = instructions;
+    };
+    static bool avx2Supported();
+    // Defaults to one thread per core.
+    void setThreadCount(int threads) { m_threadCount = threads; };
+
+    // Renders an image of the given size, blended over background the way
+    // the 3D view blends the volume over its clear colour.
+    QImage render(const CameraProperties& camera,
+                  const RenderSettings& settings, QSize size,
+                  QColor background = QColor::fromRgbF(0.95f, 0.95f,
+                                                       0.95f)) const;
+
+  private:
+    struct Frame;
+    void renderPacket(const Frame& frame, int x, int y, int count) const;
+
+    // The voxels with a border of zeros on every side, which stands in for
+    // the zero border colour of the volume texture. Every corner of a
+    // trilinear sample is then within the array.
+    std::vector<unsigned short> m_voxels;
+    int m_width{0};
+    int m_height{0};
+    int m_depth{0};
+    QVector3D m_scaleFactor;
+    std::vector<float> m_transferFunction;
+    Plane m_slicingPlane;
+    std::vector<Plane> m_cutPlanes;
+    CropBox m_cropBox;
+    QVector3D m_lightPosition;
+    Instructions m_instructions{Instructions::Avx2};
+    int m_threadCount{0};
+};
+
+#endif // CPURAYCASTER_H
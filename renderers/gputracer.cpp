@@ -0,0 +1,85 @@
+#include "gputracer.h"
+
+void GpuTracer::create()
+{
+    if constexpr (!Tracer::ENABLED)
+        return;
+    m_created = true;
+    calibrate();
+}
+
+void GpuTracer::begin(const char* name)
+{
+    if (!m_created || static_cast<int>(m_spans.size()) >= MAX_PENDING_SPANS)
+    {
+        // Still pushed so that the matching end() has a span to close.
+        m_spans.push_back({name, nullptr, nullptr});
+        return;
+    }
+    Span span{name, takeQuery(), nullptr};
+    span.start->recordTimestamp();
+    m_spans.push_back(std::move(span));
+}
+
+void GpuTracer::end()
+{
+    for (auto span = m_spans.rbegin(); span != m_spans.rend(); span++)
+    {
+        if (span->end)
+            continue;
+        if (!span->start)
+        {
+            m_spans.erase(std::next(span).base());
+            return;
+        }
+        span->end = takeQuery();
+        span->end->recordTimestamp();
+        return;
+    }
+}
+
+void GpuTracer::collect()
+{
+    if (!m_created)
+        return;
+    if (Tracer::now() - m_calibrated > CALIBRATION_INTERVAL_NS)
+        calibrate();
+    // Results arrive in the order the queries were issued.
+    while (!m_spans.empty() && m_spans.front().end &&
+           m_spans.front().end->isResultAvailable())
+    {
+        Span& span = m_spans.front();
+        Tracer::gpuSpan(span.name,
+                        static_cast<qint64>(span.start->waitForResult()) +
+                            m_offset,
+                        static_cast<qint64>(span.end->waitForResult()) +
+                            m_offset);
+        m_freeQueries.push_back(std::move(span.start));
+        m_freeQueries.push_back(std::move(span.end));
+        m_spans.pop_front();
+    }
+}
+
+std::unique_ptr<QOpenGLTimerQuery> GpuTracer::takeQuery()
+{
+    if (m_freeQueries.empty())
+    {
+        auto query = std::make_unique<QOpenGLTimerQuery>();
+        query->create();
+        return query;
+    }
+    auto query = std::move(m_freeQueries.back());
+    m_freeQueries.pop_back();
+    return query;
+}
+
+void GpuTracer::calibrate()
+{
+    // The GPU clock drifts against the CPU clock, so the offset is measured
+    // again every so often.
+    QOpenGLTimerQuery clock;
+    clock.create();
+    const qint64 gpu = static_cast<qint64>(clock.waitForTimestamp());
+    m_calibrated = Tracer::now();
+    m_offset = m_calibrated - gpu;
+}
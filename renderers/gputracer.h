@@ -0,0 +1,72 @@
+#ifndef GPUTRACER_H
+#define GPUTRACER_H
+
+#include "../tracer.h"
+
+#include <QOpenGLTimerQuery>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Times passes on the GPU with timestamp queries and hands them to the
+// Tracer once their results are in, a frame or two later, without waiting
+// for them. Does nothing unless built with tracing.
+class GpuTracer
+{
+  public:
+    // Records the GPU time from its construction to its destruction.
+    class Zone
+    {
+      public:
+        Zone(GpuTracer& tracer, const char* name) : m_tracer{tracer}
+        {
+            m_tracer.begin(name);
+        };
+        ~Zone() { m_tracer.end(); };
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+      private:
+        GpuTracer& m_tracer;
+    };
+
+    // Needs a current context.
+    void create();
+    // Spans nest, end() closes the latest span still open.
+    void begin(const char* name);
+    void end();
+    // Passes the spans whose results have arrived to the Tracer. Call once
+    // per frame.
+    void collect();
+
+  private:
+    struct Span
+    {
+        const char* name;
+        std::unique_ptr<QOpenGLTimerQuery> start;
+        std::unique_ptr<QOpenGLTimerQuery> end;
+    };
+    // Spans begun while this many are waiting for results are dropped.
+    constexpr static int MAX_PENDING_SPANS = 256;
+    constexpr static qint64 CALIBRATION_INTERVAL_NS = 1000000000;
+
+    std::unique_ptr<QOpenGLTimerQuery> takeQuery();
+    void calibrate();
+
+    bool m_created{false};
+    // In the order they were begun.
+    std::deque<Span> m_spans;
+    std::vector<std::unique_ptr<QOpenGLTimerQuery>> m_freeQueries;
+    // GPU timestamps plus the offset give the Tracer's clock.
+    qint64 m_offset{0};
+    qint64 m_calibrated{0};
+};
+
+#ifdef STRANGEVIS_TRACING
+#define TRACE_GPU_ZONE(tracer, name)                                           \
+    GpuTracer::Zone TRACE_CONCAT(gpuTraceZone, __LINE__)(tracer, name)
+#else
+#define TRACE_GPU_ZONE(tracer, name)
+#endif
+
+#endif // GPUTRACER_H
@@ -1,6 +1,10 @@
 #include "imguizmorenderer.h"
 
+#include "../tracer.h"
+#include "performancestats.h"
+
 #include <QHBoxLayout>
+#include <QShortcut>
 #include <QVBoxLayout>
 
 // clang-format off
@@ -11,7 +15,8 @@ ImguizmoWidget::ImguizmoWidget(std::shared_ptr<ISharedProperties> properties,
                                CameraProperties& camera, QWidget* renderSettingsWidget, QWidget* lightSettingsWidget, QWidget* parent,
                                Qt::WindowFlags f)
     : QOpenGLWidget{parent, f}, m_camera{camera}, m_imGuiReference{nullptr},
-      m_slicingPlaneControls{properties, m_camera}
+      m_slicingPlaneControls{properties, m_camera},
+      m_performancePanel{properties}
 
 {
     setMouseTracking(true);
@@ -20,6 +25,11 @@ ImguizmoWidget::ImguizmoWidget(std::shared_ptr<ISharedProperties> properties,
     connect(m_refreshTimer, &QTimer::timeout, [this](){update();});
     m_refreshTimer->start();
 
+    auto* performanceShortcut =
+        new QShortcut(QKeySequence(Qt::Key_F3), this,
+                      [this]() { m_performancePanel.toggle(); });
+    performanceShortcut->setContext(Qt::ApplicationShortcut);
+
     auto* hLayout = new QHBoxLayout(this);
     auto* leftColumn = new QVBoxLayout();
     leftColumn->addSpacing(256);
@@ -42,6 +52,8 @@ void ImguizmoWidget::initializeGL()
 
 void ImguizmoWidget::paintGL()
 {
+    TRACE_ZONE("ImguizmoWidget::paintGL");
+    PerformanceStats::countRedraw("Overlay");
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -63,6 +75,7 @@ void ImguizmoWidget::renderImGuizmo()
         emit updateScene();
     }
     m_slicingPlaneControls.paint();
+    m_performancePanel.paint();
     ImGui::Render();
     QtImGui::render(m_imGuiReference);
 }
@@ -3,6 +3,7 @@
 
 #include "../properties/cameraproperties.h"
 #include "../properties/sharedproperties.h"
+#include "performancepanel.h"
 #include "slicingplanecontrols.h"
 
 #include <QOpenGLWidget>
@@ -17,6 +18,11 @@ class ImguizmoWidget : public QOpenGLWidget
                    QWidget* parent = nullptr,
                    Qt::WindowFlags f = Qt::WindowFlags());
 
+    void setResolutionScaler(ResolutionScaler* scaler)
+    {
+        m_performancePanel.setResolutionScaler(scaler);
+    };
+
   signals:
     void updateScene();
 
@@ -29,6 +35,7 @@ class ImguizmoWidget : public QOpenGLWidget
     QtImGui::RenderRef m_imGuiReference;
     CameraProperties& m_camera;
     SlicingPlaneControls m_slicingPlaneControls;
+    PerformancePanel m_performancePanel;
     QTimer* m_refreshTimer;
 };
 #endif // IMGUIZMORENDERER_H
@@ -1,7 +1,12 @@
 #include "lightrenderer.h"
 
+#include "../tracer.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
 LightRenderer::LightRenderer(const CameraProperties& camera,
-                             RenderSettings& renderSettings)
+                             const RenderSettings& renderSettings)
     : m_camera{camera}, m_renderSettings{renderSettings}
 {
 }
@@ -18,48 +23,44 @@ void LightRenderer::compileShader()
 
     if (!m_lightProgram.link())
         qDebug() << "Could not link shader program!";
+
+    m_modelViewProjectionLocation =
+        m_lightProgram.uniformLocation("modelViewProjectionMatrix");
+    m_headLightLocation = m_lightProgram.uniformLocation("headLight");
+    m_positionLocation = m_lightProgram.attributeLocation("position");
 }
 
 void LightRenderer::paint()
 {
-    if (m_renderSettings.contains("maxInt") &&
-        m_renderSettings.contains("headLight"))
-    {
-        if (std::get<bool>(m_renderSettings["maxInt"]) ||
-            std::get<bool>(m_renderSettings["headLight"]))
-            return;
-    }
-    int location;
+    TRACE_ZONE("LightRenderer::paint");
+    if (m_renderSettings.maxInt || m_renderSettings.headLight)
+        return;
     m_lightProgram.bind();
 
     QMatrix4x4 modelViewProjectionMatrix = m_camera.projectionMatrix() *
                                            m_camera.viewMatrix() *
                                            m_ligthTransform.inverted();
 
-    location = m_lightProgram.uniformLocation("modelViewProjectionMatrix");
-    m_lightProgram.setUniformValue(location, modelViewProjectionMatrix);
+    m_lightProgram.setUniformValue(m_modelViewProjectionLocation,
+                                   modelViewProjectionMatrix);
 
-    location = m_lightProgram.uniformLocation("headLight");
-    std::visit(
-        [this, location](const auto& arg) {
-            m_lightProgram.setUniformValue(location, arg);
-        },
-        m_renderSettings["headLight"]);
+    m_lightProgram.setUniformValue(m_headLightLocation,
+                                   m_renderSettings.headLight);
 
-    glEnable(GL_PROGRAM_POINT_SIZE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
+    QOpenGLFunctions* functions = QOpenGLContext::currentContext()->functions();
+    functions->glEnable(GL_PROGRAM_POINT_SIZE);
+    functions->glEnable(GL_BLEND);
+    functions->glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    functions->glDepthMask(GL_FALSE);
 
     Geometry::instance().bindLightSource();
-    location = m_lightProgram.attributeLocation("position");
-    m_lightProgram.enableAttributeArray(location);
-    m_lightProgram.setAttributeBuffer(location, GL_FLOAT, 0, 3,
+    m_lightProgram.enableAttributeArray(m_positionLocation);
+    m_lightProgram.setAttributeBuffer(m_positionLocation, GL_FLOAT, 0, 3,
                                       sizeof(QVector3D));
     Geometry::instance().drawLightSource();
     m_lightProgram.release();
 
-    glDisable(GL_PROGRAM_POINT_SIZE);
-    glDisable(GL_BLEND);
-    glDepthMask(GL_TRUE);
+    functions->glDisable(GL_PROGRAM_POINT_SIZE);
+    functions->glDisable(GL_BLEND);
+    functions->glDepthMask(GL_TRUE);
 }
@@ -12,7 +12,7 @@ class LightRenderer
 {
   public:
     LightRenderer(const CameraProperties& camera,
-                  RenderSettings& renderSettings);
+                  const RenderSettings& renderSettings);
     void paint();
     void compileShader();
     void setLightTransform(QMatrix4x4 transform)
@@ -23,8 +23,12 @@ class LightRenderer
 
   private:
     const CameraProperties& m_camera;
-    RenderSettings& m_renderSettings;
+    const RenderSettings& m_renderSettings;
     QOpenGLShaderProgram m_lightProgram;
+    // Resolved once after linking.
+    int m_modelViewProjectionLocation{-1};
+    int m_headLightLocation{-1};
+    int m_positionLocation{-1};
     QMatrix4x4 m_ligthTransform;
 };
 
@@ -1,6 +1,8 @@
 #include "obliqueslicewidget.h"
 
 #include "../geometry.h"
+#include "../tracer.h"
+#include "performancestats.h"
 
 #include <QPainter>
 #include <QVector3D>
@@ -39,7 +41,7 @@ void ObliqueSliceRenderWidget::initializeGL()
     auto updateObliqueSlice = [this]() {
         Geometry::instance().allocateObliqueSlice(m_cubePlaneIntersection);
     };
-    connect(&m_textureStore->volume(), &Volume::volumeLoaded, this,
+    connect(&m_textureStore->volume(), &Volume::volumeUpdated, this,
             [this]() { update(); });
     connect(&m_properties.get()->clippingPlane(),
             &ClippingPlaneProperties::clippingPlaneChanged,
@@ -53,17 +55,19 @@ void ObliqueSliceRenderWidget::initializeGL()
             [this]() { update(); });
     updateObliqueSlice();
     moveSelection(QPointF{width() / 2.f, height() / 2.f});
+    m_gpuTracer.create();
 }
 
 void ObliqueSliceRenderWidget::paintGL()
 {
+    TRACE_ZONE("ObliqueSliceRenderWidget::paintGL");
+    m_gpuTracer.collect();
+    TRACE_GPU_ZONE(m_gpuTracer, "ObliqueSliceRenderWidget::paintGL");
+    PerformanceStats::countRedraw("Slice view");
     m_sliceProgram.bind();
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (m_textureStore->volume().loadingInProgress())
-        return;
-
     paintSlice();
     m_sliceProgram.release();
     paintSelection();
@@ -98,6 +102,10 @@ void ObliqueSliceRenderWidget::paintSlice()
         m_cubePlaneIntersection.getModelRotationMatrix() *
         m_textureStore->volume().modelMatrix();
     m_sliceProgram.setUniformValue("modelViewMatrix", modelViewMatrix);
+    m_sliceProgram.setUniformValue("intensityScale",
+                                   m_textureStore->volume().intensityScale());
+    m_sliceProgram.setUniformValue("loadedDepth",
+                                   m_textureStore->volume().loadedDepth());
 
     glActiveTexture(GL_TEXTURE0);
     m_sliceProgram.setUniformValue("volumeTexture", 0);
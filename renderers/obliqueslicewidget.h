@@ -5,6 +5,7 @@
 #include "../properties/clippingplaneproperties.h"
 #include "../properties/sharedproperties.h"
 #include "../texturestore.h"
+#include "gputracer.h"
 
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
@@ -51,6 +52,7 @@ class ObliqueSliceRenderWidget : public QOpenGLWidget,
     QPointF m_selectedPoint;
     QRectF m_selectedBox;
     QVector3D m_selectedVolumePoint;
+    GpuTracer m_gpuTracer;
 };
 
 #endif // OBLIQUESLICEWIDGET_H
@@ -0,0 +1,191 @@
+#include "performancepanel.h"
+
+#include "performancestats.h"
+
+#include <QString>
+#include <algorithm>
+
+// clang-format off
+#include <imgui.h>
+// clang-format on
+
+namespace
+{
+constexpr float GRAPH_HEIGHT = 40.f;
+// In the order of the RayCostView values.
+constexpr const char* RAY_COST_VIEWS[]{"Off", "Samples", "Shaded samples",
+                                       "Texture fetches", "Exit reason"};
+
+double percentage(qint64 part, qint64 whole)
+{
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+double megabytes(qint64 bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+void plotFrameTimes(const char* label, const PerformanceStats::History& times)
+{
+    const auto maximum = *std::max_element(times.values.begin(),
+                                           times.values.end());
+    const QString overlay =
+        QString("%1 ms, max %2 ms")
+            .arg(times.latest(), 0, 'f', 2)
+            .arg(maximum, 0, 'f', 2);
+    ImGui::PlotLines(label, times.values.data(), PerformanceStats::HISTORY,
+                     times.next, overlay.toUtf8().constData(), 0.f,
+                     std::max(maximum, 1.f), ImVec2(0, GRAPH_HEIGHT));
+}
+} // namespace
+
+void PerformancePanel::setVisible(bool visible)
+{
+    m_visible = visible;
+    PerformanceStats::setEnabled(visible);
+    if (!visible)
+        setRayCostView(RayCostView::Off);
+}
+
+void PerformancePanel::setRayCostView(int view)
+{
+    auto& settings = m_properties->renderSettings();
+    if (view == settings.renderSettings().rayCost)
+        return;
+    // The export covers the frames since the view was last switched on.
+    if (settings.renderSettings().rayCost == RayCostView::Off)
+        PerformanceStats::clearRayCost();
+    settings.set(RenderSettingKeys::RAY_COST, view);
+}
+
+void PerformancePanel::paint()
+{
+    if (!m_visible)
+        return;
+    // Clear of the view manipulator in the top left corner.
+    ImGui::SetNextWindowPos(ImVec2(136, 8), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    bool open = true;
+    if (!ImGui::Begin("Performance", &open,
+                      ImGuiWindowFlags_AlwaysAutoResize |
+                          ImGuiWindowFlags_NoFocusOnAppearing))
+    {
+        ImGui::End();
+        setVisible(open);
+        return;
+    }
+
+    plotFrameTimes("CPU", PerformanceStats::cpuFrameTimes());
+    // Measured around the volume pass, refinement passes and the frames
+    // counting their rays are left out.
+    plotFrameTimes("GPU", PerformanceStats::gpuFrameTimes());
+    paintResolution();
+
+    ImGui::Separator();
+    // Counted on one frame in every few, see RayCastingWidget.
+    const auto& rays = PerformanceStats::rayStatistics();
+    if (rays.rays > 0 && rays.pixels > 0)
+    {
+        ImGui::Text("Samples per pixel: %.1f",
+                    static_cast<double>(rays.samples) / rays.pixels);
+        ImGui::Text("Samples per ray: %.1f",
+                    static_cast<double>(rays.samples) / rays.rays);
+        ImGui::Text("Early terminated rays: %.1f%%",
+                    100.0 * rays.terminatedRays / rays.rays);
+    }
+    else
+    {
+        ImGui::TextUnformatted("No rays cast yet");
+    }
+
+    ImGui::Separator();
+    const auto& memory = PerformanceStats::volumeMemory();
+    ImGui::Text("Volume memory: %.1f MB CPU, %.1f MB GPU",
+                megabytes(memory.cpuBytes), megabytes(memory.gpuBytes));
+    const auto& upload = PerformanceStats::volumeUpload();
+    if (upload.nanoseconds > 0)
+        ImGui::Text("Last load: %.1f MB uploaded at %.0f MB/s",
+                    megabytes(upload.bytes),
+                    megabytes(upload.bytes) / (upload.nanoseconds * 1.0e-9));
+    ImGui::Text("Transfer function uploads: %.1f KB",
+                upload.transferFunctionBytes / 1024.0);
+
+    ImGui::Separator();
+    for (const auto& [widget, rate] : PerformanceStats::redrawsPerSecond())
+        ImGui::Text("%s: %d redraws/s", widget.toUtf8().constData(), rate);
+
+    ImGui::Separator();
+    paintRayCost();
+
+    ImGui::End();
+    if (!open)
+        setVisible(false);
+}
+
+void PerformancePanel::paintResolution()
+{
+    if (!m_resolutionScaler)
+        return;
+    ResolutionScaler& scaler = *m_resolutionScaler;
+    ImGui::Text("Interaction: %.0f%% resolution, %.2f ms of %.1f ms",
+                100.0 * scaler.scale(), scaler.lastFrameTime(),
+                scaler.frameTimeBudget());
+    ImGui::Text("Refinement pass: %.2f ms at full resolution",
+                PerformanceStats::refinementPassTime());
+    bool pinned = scaler.pinned();
+    if (ImGui::Checkbox("Pin scale", &pinned))
+    {
+        if (pinned)
+            scaler.pin(scaler.scale());
+        else
+            scaler.unpin();
+    }
+    if (!pinned)
+        return;
+    float scale = scaler.scale();
+    if (ImGui::SliderFloat("Scale", &scale, ResolutionScaler::MINIMUM_SCALE,
+                           1.0f, "%.3f"))
+        scaler.pin(scale);
+}
+
+void PerformancePanel::paintRayCost()
+{
+    int view = m_properties->renderSettings().renderSettings().rayCost;
+    if (ImGui::Combo("Ray cost", &view, RAY_COST_VIEWS,
+                     IM_ARRAYSIZE(RAY_COST_VIEWS)))
+        setRayCostView(view);
+    if (view == RayCostView::Off)
+        return;
+
+    if (view == RayCostView::Exit)
+        ImGui::TextUnformatted(
+            "Red: opaque, green: left the volume, blue: clipped");
+    else
+        ImGui::TextUnformatted(
+            "Blue to red: none to a ray along the volume's diagonal");
+
+    const auto& frames = PerformanceStats::rayCostFrames();
+    if (!frames.empty())
+    {
+        const auto& cost = frames.back();
+        ImGui::Text("Rays: %lld of %lld pixels", cost.rays, cost.pixels);
+        ImGui::Text("Samples per ray: %.1f, %.1f%% shaded",
+                    cost.rays > 0 ? static_cast<double>(cost.samples) /
+                                        cost.rays
+                                  : 0.0,
+                    percentage(cost.shadedSamples, cost.samples));
+        ImGui::Text("Fetches per sample: %.2f",
+                    cost.samples > 0 ? static_cast<double>(cost.fetches) /
+                                           cost.samples
+                                     : 0.0);
+        ImGui::Text("Exits: %.1f%% opaque, %.1f%% volume, %.1f%% clipped",
+                    percentage(cost.opacityExits, cost.rays),
+                    percentage(cost.boxExits, cost.rays),
+                    percentage(cost.clipExits, cost.rays));
+    }
+    if (ImGui::Button("Save CSV"))
+        PerformanceStats::writeRayCost(PerformanceStats::rayCostFileName());
+    ImGui::SameLine();
+    ImGui::Text("%d frames", static_cast<int>(frames.size()));
+}
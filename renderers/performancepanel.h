@@ -0,0 +1,38 @@
+#ifndef PERFORMANCEPANEL_H
+#define PERFORMANCEPANEL_H
+
+#include "../properties/sharedproperties.h"
+#include "resolutionscaler.h"
+
+#include <memory>
+
+// ImGui window over the 3D view showing the PerformanceStats. Toggled with
+// F3, the ray statistics are only collected while it is shown. It also
+// switches the ray cost views of the 3D view, which are turned off again
+// along with the panel, and shows and pins the resolution scale of the
+// interaction frames.
+class PerformancePanel
+{
+  public:
+    explicit PerformancePanel(std::shared_ptr<ISharedProperties> properties)
+        : m_properties{properties} {};
+    void paint();
+    bool visible() const { return m_visible; };
+    void setVisible(bool visible);
+    void toggle() { setVisible(!m_visible); };
+    void setResolutionScaler(ResolutionScaler* scaler)
+    {
+        m_resolutionScaler = scaler;
+    };
+
+  private:
+    void paintResolution();
+    void paintRayCost();
+    void setRayCostView(int view);
+
+    std::shared_ptr<ISharedProperties> m_properties;
+    ResolutionScaler* m_resolutionScaler{nullptr};
+    bool m_visible{false};
+};
+
+#endif // PERFORMANCEPANEL_H
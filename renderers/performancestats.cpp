@@ -0,0 +1,67 @@
+#include "performancestats.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QtGlobal>
+
+PerformanceStats::History PerformanceStats::s_cpuFrameTimes{};
+PerformanceStats::History PerformanceStats::s_gpuFrameTimes{};
+PerformanceStats::RayStatistics PerformanceStats::s_rayStatistics{};
+PerformanceStats::Memory PerformanceStats::s_volumeMemory{};
+PerformanceStats::Upload PerformanceStats::s_volumeUpload{};
+std::vector<PerformanceStats::RayCost> PerformanceStats::s_rayCostFrames{};
+
+void PerformanceStats::countRedraw(const QString& widget)
+{
+    if (!s_redrawTimer.isValid())
+        s_redrawTimer.start();
+    // Rolled over by whichever widget paints first after a second is up,
+    // widgets that did not paint in it drop to zero.
+    const qint64 elapsed = s_redrawTimer.elapsed();
+    if (elapsed >= 1000)
+    {
+        for (auto& [name, rate] : s_redrawRates)
+            rate = 0;
+        for (const auto& [name, count] : s_redraws)
+            s_redrawRates[name] = static_cast<int>(count * 1000 / elapsed);
+        s_redraws.clear();
+        s_redrawTimer.restart();
+    }
+    s_redraws[widget]++;
+}
+
+void PerformanceStats::addRayCost(const RayCost& cost)
+{
+    if (static_cast<int>(s_rayCostFrames.size()) < MAX_RAY_COST_FRAMES)
+        s_rayCostFrames.push_back(cost);
+}
+
+QString PerformanceStats::rayCostFileName()
+{
+    return qEnvironmentVariable("STRANGEVIS_RAY_COST",
+                                "strangevis.raycost.csv");
+}
+
+bool PerformanceStats::writeRayCost(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "Unable to write" << fileName;
+        return false;
+    }
+    QTextStream out(&file);
+    out << "frame,pixels,rays,samples,shadedSamples,fetches,opacityExits,"
+           "boxExits,clipExits\n";
+    for (int frame = 0; frame < static_cast<int>(s_rayCostFrames.size());
+         frame++)
+    {
+        const RayCost& cost = s_rayCostFrames[frame];
+        out << frame << ',' << cost.pixels << ',' << cost.rays << ','
+            << cost.samples << ',' << cost.shadedSamples << ','
+            << cost.fetches << ',' << cost.opacityExits << ','
+            << cost.boxExits << ',' << cost.clipExits << '\n';
+    }
+    return out.status() == QTextStream::Ok;
+}
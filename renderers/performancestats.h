@@ -0,0 +1,140 @@
+#ifndef PERFORMANCESTATS_H
+#define PERFORMANCESTATS_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <array>
+#include <map>
+#include <vector>
+
+// Counters the GL widgets report into every frame, shown by the performance
+// panel of the 3D view. The counters are global, and they are only ever
+// touched from the GUI thread.
+//
+// The more expensive counters, the ray statistics, are only collected while
+// the panel is shown.
+class PerformanceStats
+{
+  public:
+    constexpr static int HISTORY = 120;
+
+    // The last HISTORY values of a series, oldest first from next on.
+    struct History
+    {
+        std::array<float, HISTORY> values{};
+        int next{0};
+        void add(float value)
+        {
+            values[next] = value;
+            next = (next + 1) % HISTORY;
+        };
+        float latest() const { return values[(next + HISTORY - 1) % HISTORY]; };
+    };
+    struct RayStatistics
+    {
+        qint64 rays{0};
+        qint64 samples{0};
+        // Rays that stopped at full opacity before leaving the volume.
+        qint64 terminatedRays{0};
+        qint64 pixels{0};
+    };
+    struct Memory
+    {
+        qint64 cpuBytes{0};
+        qint64 gpuBytes{0};
+    };
+    // Bytes uploaded since the last volume started loading, and the time
+    // spent in the calls uploading them.
+    struct Upload
+    {
+        qint64 bytes{0};
+        qint64 nanoseconds{0};
+        // Uploaded by every transfer function change since startup.
+        qint64 transferFunctionBytes{0};
+    };
+
+    // Totals of a frame rendered with a ray cost view.
+    struct RayCost
+    {
+        qint64 pixels{0};
+        qint64 rays{0};
+        qint64 samples{0};
+        qint64 shadedSamples{0};
+        qint64 fetches{0};
+        qint64 opacityExits{0};
+        qint64 boxExits{0};
+        qint64 clipExits{0};
+    };
+    // Frames kept for the ray cost export, later frames are dropped.
+    constexpr static int MAX_RAY_COST_FRAMES = 100000;
+
+    static bool enabled() { return s_enabled; };
+    static void setEnabled(bool enabled) { s_enabled = enabled; };
+
+    static void addCpuFrameTime(float milliseconds)
+    {
+        s_cpuFrameTimes.add(milliseconds);
+    };
+    static void addGpuFrameTime(float milliseconds)
+    {
+        s_gpuFrameTimes.add(milliseconds);
+    };
+    // A refinement pass of the idle 3D view, at full resolution.
+    static void setRefinementPassTime(float milliseconds)
+    {
+        s_refinementPassTime = milliseconds;
+    };
+    static void setRayStatistics(const RayStatistics& statistics)
+    {
+        s_rayStatistics = statistics;
+    };
+    static void setVolumeMemory(const Memory& memory)
+    {
+        s_volumeMemory = memory;
+    };
+    static void setVolumeUpload(const Upload& upload)
+    {
+        s_volumeUpload = upload;
+    };
+    // Counts a paint of the named widget.
+    static void countRedraw(const QString& widget);
+    static void addRayCost(const RayCost& cost);
+    static void clearRayCost() { s_rayCostFrames.clear(); };
+    // Writes the ray cost of every frame since the last clear as CSV, one
+    // row per frame.
+    static bool writeRayCost(const QString& fileName);
+    // The file named by STRANGEVIS_RAY_COST, or strangevis.raycost.csv.
+    static QString rayCostFileName();
+
+    static const History& cpuFrameTimes() { return s_cpuFrameTimes; };
+    static const History& gpuFrameTimes() { return s_gpuFrameTimes; };
+    static float refinementPassTime() { return s_refinementPassTime; };
+    static const RayStatistics& rayStatistics() { return s_rayStatistics; };
+    static const Memory& volumeMemory() { return s_volumeMemory; };
+    static const Upload& volumeUpload() { return s_volumeUpload; };
+    static const std::vector<RayCost>& rayCostFrames()
+    {
+        return s_rayCostFrames;
+    };
+    // Paints per second of every widget, averaged over the last second.
+    static const std::map<QString, int>& redrawsPerSecond()
+    {
+        return s_redrawRates;
+    };
+
+  private:
+    inline static bool s_enabled{false};
+    // Defined in the source file, the nested types are incomplete here.
+    static History s_cpuFrameTimes;
+    static History s_gpuFrameTimes;
+    inline static float s_refinementPassTime{0.0f};
+    static RayStatistics s_rayStatistics;
+    static Memory s_volumeMemory;
+    static Upload s_volumeUpload;
+    static std::vector<RayCost> s_rayCostFrames;
+    inline static std::map<QString, int> s_redraws{};
+    inline static std::map<QString, int> s_redrawRates{};
+    inline static QElapsedTimer s_redrawTimer{};
+};
+
+#endif // PERFORMANCESTATS_H
@@ -1,11 +1,12 @@
 #include "planerenderer.h"
 
+#include "../tracer.h"
 #include "../geometry.h"
 
 PlaneRenderer::PlaneRenderer(
     const std::unique_ptr<ITextureStore>& textureStore,
     const std::shared_ptr<const ISharedProperties> properties,
-    const CameraProperties& camera, RenderSettings& renderSettings)
+    const CameraProperties& camera, const RenderSettings& renderSettings)
     : m_textureStore{textureStore}, m_camera{camera},
       m_renderSettings{renderSettings}, m_properties{properties}
 {
@@ -23,39 +24,44 @@ void PlaneRenderer::compileShader()
 
     if (!m_planeProgram.link())
         qDebug() << "Could not link shader program!";
+
+    m_modelViewProjectionLocation =
+        m_planeProgram.uniformLocation("modelViewProjectionMatrix");
+    m_modelMatrixLocation = m_planeProgram.uniformLocation("modelMatrix");
+    m_selectedPointLocation = m_planeProgram.uniformLocation("selectedPoint");
+    m_planeCorrectionLocation =
+        m_planeProgram.uniformLocation("planeCorrection");
+    m_vertexPositionLocation =
+        m_planeProgram.attributeLocation("vertexPosition");
 }
 
 void PlaneRenderer::paint()
 {
-    if (!std::get<bool>(m_renderSettings["showSlice"]))
+    TRACE_ZONE("PlaneRenderer::paint");
+    if (!m_renderSettings.showSlice)
         return;
-    int location;
     m_planeProgram.bind();
 
+    const QMatrix4x4 modelMatrix = planeModelMatrix();
     QMatrix4x4 modelViewProjectionMatrix = m_camera.projectionMatrix() *
                                            m_camera.viewMatrix() *
-                                           planeModelMatrix();
-
-    location = m_planeProgram.uniformLocation("modelViewProjectionMatrix");
-    m_planeProgram.setUniformValue(location, modelViewProjectionMatrix);
+                                           modelMatrix;
 
-    location = m_planeProgram.uniformLocation("modelMatrix");
-    m_planeProgram.setUniformValue(location, planeModelMatrix());
+    m_planeProgram.setUniformValue(m_modelViewProjectionLocation,
+                                   modelViewProjectionMatrix);
+    m_planeProgram.setUniformValue(m_modelMatrixLocation, modelMatrix);
 
-    location = m_planeProgram.uniformLocation("selectedPoint");
     auto point = m_properties->clippingPlane().selectedPoint();
-    m_planeProgram.setUniformValue(location, point);
+    m_planeProgram.setUniformValue(m_selectedPointLocation, point);
 
-    location = m_planeProgram.uniformLocation("planeCorrection");
     auto f = m_textureStore->volume().scaleFactor();
     float correction = std::max({f.x(), f.y(), f.z()})/ std::min({f.x(), f.y(), f.z()});
-    m_planeProgram.setUniformValue(location, correction);
+    m_planeProgram.setUniformValue(m_planeCorrectionLocation, correction);
 
 
     Geometry::instance().bindObliqueSliceIntersectionCoords();
-    location = m_planeProgram.attributeLocation("vertexPosition");
-    m_planeProgram.enableAttributeArray(location);
-    m_planeProgram.setAttributeBuffer(location, GL_FLOAT, 0, 3,
+    m_planeProgram.enableAttributeArray(m_vertexPositionLocation);
+    m_planeProgram.setAttributeBuffer(m_vertexPositionLocation, GL_FLOAT, 0, 3,
                                       sizeof(QVector3D));
     Geometry::instance().drawObliqueSlice();
     m_planeProgram.release();
@@ -11,7 +11,7 @@
 class PlaneRenderer
 {
   public:
-    PlaneRenderer(const std::unique_ptr<ITextureStore>& textureStore, const std::shared_ptr<const ISharedProperties> properties, const CameraProperties& camera, RenderSettings& renderSettings);
+    PlaneRenderer(const std::unique_ptr<ITextureStore>& textureStore, const std::shared_ptr<const ISharedProperties> properties, const CameraProperties& camera, const RenderSettings& renderSettings);
     void paint();
     void compileShader();
 
@@ -20,7 +20,13 @@ class PlaneRenderer
     const std::unique_ptr<ITextureStore>& m_textureStore;
     const CameraProperties& m_camera;
     QOpenGLShaderProgram m_planeProgram;
-    RenderSettings& m_renderSettings;
+    // Resolved once after linking.
+    int m_modelViewProjectionLocation{-1};
+    int m_modelMatrixLocation{-1};
+    int m_selectedPointLocation{-1};
+    int m_planeCorrectionLocation{-1};
+    int m_vertexPositionLocation{-1};
+    const RenderSettings& m_renderSettings;
     const std::shared_ptr<const ISharedProperties> m_properties;
 };
 
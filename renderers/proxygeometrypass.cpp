@@ -0,0 +1,115 @@
+#include "proxygeometrypass.h"
+
+#include "../tracer.h"
+
+#include <algorithm>
+
+ProxyGeometryPass::ProxyGeometryPass(QOpenGLExtraFunctions& openGLExtra)
+    : m_openGLExtra{openGLExtra}
+{
+}
+
+void ProxyGeometryPass::compileShader()
+{
+    if (!m_program.addShaderFromSourceFile(QOpenGLShader::Vertex,
+                                           ":shaders/proxy-vs.glsl"))
+        qDebug() << "Could not load vertex shader!";
+
+    if (!m_program.addShaderFromSourceFile(QOpenGLShader::Fragment,
+                                           ":shaders/proxy-fs.glsl"))
+        qDebug() << "Could not load fragment shader!";
+
+    if (!m_program.link())
+        qDebug() << "Could not link shader program!";
+    m_vertexPosition = m_program.attributeLocation("vertexPosition");
+}
+
+void ProxyGeometryPass::setMesh(const std::vector<QVector3D>& vertices,
+                                unsigned int revision)
+{
+    if (m_uploaded && revision == m_revision)
+        return;
+    m_uploaded = true;
+    m_revision = revision;
+    m_vertexCount = static_cast<int>(vertices.size());
+    if (vertices.empty())
+        return;
+    m_minimum = m_maximum = vertices.front();
+    for (const auto& vertex : vertices)
+    {
+        m_minimum = QVector3D(std::min(m_minimum.x(), vertex.x()),
+                              std::min(m_minimum.y(), vertex.y()),
+                              std::min(m_minimum.z(), vertex.z()));
+        m_maximum = QVector3D(std::max(m_maximum.x(), vertex.x()),
+                              std::max(m_maximum.y(), vertex.y()),
+                              std::max(m_maximum.z(), vertex.z()));
+    }
+
+    if (!m_vertexBuffer.isCreated())
+        m_vertexBuffer.create();
+    m_vertexBuffer.bind();
+    m_vertexBuffer.allocate(
+        vertices.data(),
+        static_cast<int>(vertices.size() * sizeof(vertices[0])));
+    m_vertexBuffer.release();
+}
+
+void ProxyGeometryPass::render(QSize size)
+{
+    TRACE_ZONE("ProxyGeometryPass::render");
+    if (empty())
+        return;
+    if (!m_entry || m_entry->size() != size)
+    {
+        QOpenGLFramebufferObjectFormat format;
+        format.setInternalTextureFormat(GL_RGBA32F);
+        format.setAttachment(QOpenGLFramebufferObject::Depth);
+        m_entry = std::make_unique<QOpenGLFramebufferObject>(size, format);
+        m_exit = std::make_unique<QOpenGLFramebufferObject>(size, format);
+    }
+
+    GLint framebuffer = 0;
+    m_openGLExtra.glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    GLfloat clearColor[4];
+    m_openGLExtra.glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    m_openGLExtra.glDisable(GL_BLEND);
+    m_openGLExtra.glEnable(GL_DEPTH_TEST);
+    m_openGLExtra.glEnable(GL_CULL_FACE);
+
+    m_program.bind();
+    m_vertexBuffer.bind();
+    m_program.enableAttributeArray(m_vertexPosition);
+    m_program.setAttributeBuffer(m_vertexPosition, GL_FLOAT, 0, 3,
+                                 sizeof(QVector3D));
+    // The nearest front face, and the farthest back face.
+    renderFaces(*m_entry, GL_BACK, GL_LESS, 1.0f);
+    renderFaces(*m_exit, GL_FRONT, GL_GREATER, 0.0f);
+    m_program.disableAttributeArray(m_vertexPosition);
+    m_vertexBuffer.release();
+    m_program.release();
+
+    m_openGLExtra.glDepthFunc(GL_LESS);
+    m_openGLExtra.glClearDepthf(1.0f);
+    m_openGLExtra.glClearColor(clearColor[0], clearColor[1], clearColor[2],
+                               clearColor[3]);
+    m_openGLExtra.glDisable(GL_CULL_FACE);
+    m_openGLExtra.glDisable(GL_DEPTH_TEST);
+    m_openGLExtra.glEnable(GL_BLEND);
+    m_openGLExtra.glBindFramebuffer(GL_FRAMEBUFFER,
+                                    static_cast<GLuint>(framebuffer));
+    m_openGLExtra.glViewport(0, 0, size.width(), size.height());
+}
+
+void ProxyGeometryPass::renderFaces(QOpenGLFramebufferObject& framebuffer,
+                                    GLenum cullFace, GLenum depthFunction,
+                                    float clearDepth)
+{
+    framebuffer.bind();
+    m_openGLExtra.glViewport(0, 0, framebuffer.width(), framebuffer.height());
+    m_openGLExtra.glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    m_openGLExtra.glClearDepthf(clearDepth);
+    m_openGLExtra.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_openGLExtra.glCullFace(cullFace);
+    m_openGLExtra.glDepthFunc(depthFunction);
+    m_openGLExtra.glDrawArrays(GL_TRIANGLES, 0, m_vertexCount);
+}
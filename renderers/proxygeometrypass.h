@@ -0,0 +1,51 @@
+#ifndef PROXYGEOMETRYPASS_H
+#define PROXYGEOMETRYPASS_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLShaderProgram>
+#include <QVector3D>
+#include <memory>
+#include <vector>
+
+// Rasterizes the proxy geometry of the volume into two float render targets,
+// holding the texture coordinates of the nearest front face and of the
+// farthest back face under every pixel. The raycaster marches only between
+// the two, and not at all where no back face was drawn. Uses the Camera
+// uniform block, which has to be up to date when render() is called.
+class ProxyGeometryPass
+{
+  public:
+    explicit ProxyGeometryPass(QOpenGLExtraFunctions& openGLExtra);
+    void compileShader();
+    // Uploads the mesh unless revision is the one already uploaded.
+    void setMesh(const std::vector<QVector3D>& vertices, unsigned int revision);
+    bool empty() const { return m_vertexCount == 0; };
+    // Corners of the box around the mesh, in model coordinates.
+    QVector3D minimum() const { return m_minimum; };
+    QVector3D maximum() const { return m_maximum; };
+    // Renders both faces at the given size, and binds back the framebuffer
+    // that was bound before.
+    void render(QSize size);
+    GLuint entryTexture() const { return m_entry ? m_entry->texture() : 0; };
+    GLuint exitTexture() const { return m_exit ? m_exit->texture() : 0; };
+
+  private:
+    void renderFaces(QOpenGLFramebufferObject& framebuffer, GLenum cullFace,
+                     GLenum depthFunction, float clearDepth);
+
+    QOpenGLExtraFunctions& m_openGLExtra;
+    QOpenGLShaderProgram m_program;
+    QOpenGLBuffer m_vertexBuffer{QOpenGLBuffer::VertexBuffer};
+    int m_vertexCount{0};
+    unsigned int m_revision{0};
+    bool m_uploaded{false};
+    QVector3D m_minimum{-1.0f, -1.0f, -1.0f};
+    QVector3D m_maximum{1.0f, 1.0f, 1.0f};
+    int m_vertexPosition{-1};
+    std::unique_ptr<QOpenGLFramebufferObject> m_entry;
+    std::unique_ptr<QOpenGLFramebufferObject> m_exit;
+};
+
+#endif // PROXYGEOMETRYPASS_H
@@ -1,6 +1,11 @@
 #include "raycastingwidget.h"
 
 #include "../geometry.h"
+#include "../tracer.h"
+#include "performancestats.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
 
 RayCastingWidget::RayCastingWidget(
     RenderProperties initialRenderProperties,
@@ -12,34 +17,61 @@ RayCastingWidget::RayCastingWidget(
       m_transferFunctionName{initialRenderProperties.transferFunction},
       m_clippingPlane{initialRenderProperties.clippingPlane},
       m_cubePlaneIntersection{initialRenderProperties.clippingPlane},
-      m_viewPort{width(), height()}, m_camera{camera},
+      m_viewPort{width(), height()}, m_volumeViewPort{width(), height()},
+      m_camera{camera},
       m_volumeRenderer{textureStore,
                        m_renderSettings,
                        m_camera,
                        m_openGLExtra,
-                       m_viewPort,
+                       m_volumeViewPort,
                        m_lightRenderer,
                        m_cubePlaneIntersection.plane()},
       m_lightRenderer{m_camera, m_renderSettings}, m_planeRenderer{
                                                        textureStore, properties, m_camera,
-                                                       m_renderSettings}
+                                                       m_renderSettings},
+      m_accumulationBuffer{m_openGLExtra}
 {
+    m_volumeRenderer.setCutPlanes(properties->clippingPlane().cutPlanes());
+    m_volumeRenderer.setCropBox(properties->clippingPlane().cropBox());
     m_camera.moveCamera(initialRenderProperties.cameraPosition);
     m_camera.zoomCamera(initialRenderProperties.zoomFactor);
 
-    connect(&m_textureStore->volume(), &Volume::volumeLoaded, this,
+    connect(&m_textureStore->volume(), &Volume::volumeUpdated, this,
             [this]() { update(); });
+
+    m_interactionTimer.setSingleShot(true);
+    m_interactionTimer.setInterval(INTERACTION_TIMEOUT_MS);
+    connect(&m_interactionTimer, &QTimer::timeout, this, [this]() {
+        m_volumeRenderer.setInteracting(false);
+        update();
+    });
+
+    m_refinementTimer.setSingleShot(true);
+    m_refinementTimer.setInterval(0);
+    connect(&m_refinementTimer, &QTimer::timeout, this, [this]() {
+        m_refinementRequested = true;
+        update();
+    });
+}
+
+void RayCastingWidget::startInteraction()
+{
+    m_volumeRenderer.setInteracting(true);
+    m_interactionTimer.start();
+    m_refinementTimer.stop();
 }
 
 void RayCastingWidget::rotateCamera(qreal angle, QVector3D axis)
 {
     m_camera.rotateCamera(qRadiansToDegrees(angle), axis);
+    startInteraction();
     updateLightTransformMatrix();
     update();
 }
 void RayCastingWidget::zoomCamera(float zoomFactor)
 {
     m_camera.zoomCamera(zoomFactor);
+    startInteraction();
     updateLightTransformMatrix();
     update();
 }
@@ -70,6 +102,9 @@ void RayCastingWidget::initializeGL()
     m_volumeRenderer.compileShader();
     m_planeRenderer.compileShader();
     m_lightRenderer.compileShader();
+    m_accumulationBuffer.compileShader();
+    m_volumeTimer.create();
+    m_gpuTracer.create();
 }
 
 void RayCastingWidget::resizeGL(int w, int h)
@@ -82,14 +117,156 @@ void RayCastingWidget::resizeGL(int w, int h)
 
 void RayCastingWidget::paintGL()
 {
+    TRACE_ZONE("RayCastingWidget::paintGL");
+    m_gpuTracer.collect();
+    TRACE_GPU_ZONE(m_gpuTracer, "RayCastingWidget::paintGL");
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    PerformanceStats::countRedraw("3D view");
+    m_countingRays = PerformanceStats::enabled() &&
+                     m_frame++ % RAY_STATISTICS_INTERVAL == 0;
+    m_volumeRenderer.setCollectRayStatistics(m_countingRays);
     glClearColor(0.95f, 0.95f, 0.95f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (m_textureStore->volume().loadingInProgress())
+    if (m_interactionTimer.isActive())
+    {
+        m_refinementPass = -1;
+        m_volumeRenderer.setRaySampling(INTERACTION_STEP_SCALE, 0.0f,
+                                        m_interactionFrame++);
+    }
+    else
+    {
+        m_refinementPass = m_refinementRequested ? m_refinementPass + 1 : 0;
+        m_volumeRenderer.setRaySampling(
+            INTERACTION_STEP_SCALE,
+            static_cast<float>(m_refinementPass) / REFINEMENT_PASSES, -1);
+    }
+    m_refinementRequested = false;
+
+    paintVolume();
+    {
+        TRACE_GPU_ZONE(m_gpuTracer, "PlaneRenderer::paint");
+        m_planeRenderer.paint();
+    }
+    {
+        TRACE_GPU_ZONE(m_gpuTracer, "LightRenderer::paint");
+        m_lightRenderer.paint();
+    }
+
+    reportStatistics();
+    PerformanceStats::addCpuFrameTime(frameTimer.nsecsElapsed() / 1.0e6f);
+
+    if (m_volumeRenderer.bricksPending())
+        update();
+    else if (m_refinementPass >= 0 && m_refinementPass + 1 < REFINEMENT_PASSES)
+        m_refinementTimer.start();
+}
+
+void RayCastingWidget::paintVolume()
+{
+    collectVolumeTime();
+    const qreal ratio = devicePixelRatio();
+    const QSize widgetSize(qRound(width() * ratio), qRound(height() * ratio));
+    const bool refining = m_refinementPass >= 0;
+    const float scale = refining ? 1.0f : m_resolutionScaler.scale();
+    const bool offscreen = scale < 1.0f || refining;
+
+    QSize size = widgetSize;
+    if (offscreen)
+    {
+        size = QSize(std::max(1, qRound(widgetSize.width() * scale)),
+                     std::max(1, qRound(widgetSize.height() * scale)));
+        if (!m_volumeFramebuffer || m_volumeFramebuffer->size() != size)
+            m_volumeFramebuffer =
+                std::make_unique<QOpenGLFramebufferObject>(size);
+        m_volumeFramebuffer->bind();
+        glViewport(0, 0, size.width(), size.height());
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    else
+    {
+        m_volumeFramebuffer.reset();
+    }
+    m_volumeViewPort.updateViewPort(size.width(), size.height());
+
+    // One query in flight at a time, frames rendered while it is pending
+    // are not measured. Neither are frames counting their rays.
+    const bool timing = m_volumeTimer.isCreated() && !m_volumeTimerPending &&
+                        !m_countingRays;
+    if (timing)
+    {
+        m_volumeTimer.begin();
+        m_timingRefinement = refining;
+    }
+    {
+        TRACE_GPU_ZONE(m_gpuTracer, "VolumeRenderer::paint");
+        m_volumeRenderer.paint();
+    }
+    if (timing)
+    {
+        m_volumeTimer.end();
+        m_volumeTimerPending = true;
+    }
+
+    if (offscreen)
+    {
+        m_volumeFramebuffer->release();
+        QOpenGLFramebufferObject* image = m_volumeFramebuffer.get();
+        if (refining)
+        {
+            m_accumulationBuffer.add(m_volumeFramebuffer->texture(), size,
+                                     m_refinementPass);
+            image = m_accumulationBuffer.framebuffer();
+        }
+        // Bilinear upscale into the widget.
+        QOpenGLFramebufferObject::blitFramebuffer(
+            nullptr, QRect(QPoint(0, 0), widgetSize), image,
+            QRect(QPoint(0, 0), size), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glViewport(0, 0, widgetSize.width(), widgetSize.height());
+    }
+}
+
+void RayCastingWidget::collectVolumeTime()
+{
+    if (!m_volumeTimerPending || !m_volumeTimer.isResultAvailable())
+        return;
+    m_volumeTimerPending = false;
+    const float milliseconds = m_volumeTimer.waitForResult() / 1.0e6f;
+    // Refinement passes render at full resolution whatever the scale, so
+    // only interaction frames train the scaler the scale is used for.
+    if (m_timingRefinement)
+    {
+        PerformanceStats::setRefinementPassTime(milliseconds);
+        return;
+    }
+    PerformanceStats::addGpuFrameTime(milliseconds);
+    const float scale = m_resolutionScaler.scale();
+    m_resolutionScaler.addFrameTime(milliseconds);
+    // Render again at the new scale rather than waiting for the next event.
+    if (m_resolutionScaler.scale() != scale && m_interactionTimer.isActive())
+        update();
+}
+
+void RayCastingWidget::reportStatistics()
+{
+    const auto& cost = m_volumeRenderer.rayCost();
+    if (m_renderSettings.rayCost != RayCostView::Off && cost.pixels > 0)
+        PerformanceStats::addRayCost(
+            {cost.pixels, cost.rays, cost.samples, cost.shadedSamples,
+             cost.fetches, cost.opacityExits, cost.boxExits, cost.clipExits});
+    if (!PerformanceStats::enabled())
         return;
-    m_volumeRenderer.paint();
-    m_planeRenderer.paint();
-    m_lightRenderer.paint();
+    // The ray counts are those of the last frame that counted them, read
+    // back by the frame after it.
+    const auto& rays = m_volumeRenderer.rayStatistics();
+    PerformanceStats::setRayStatistics(
+        {rays.rays, rays.samples, rays.terminatedRays, rays.pixels});
+    const Volume& volume = m_textureStore->volume();
+    PerformanceStats::setVolumeMemory({volume.cpuBytes(), volume.gpuBytes()});
+    PerformanceStats::setVolumeUpload(
+        {volume.uploadedBytes(), volume.uploadNanoseconds(),
+         m_textureStore->transferFunction().totalUploadBytes()});
 }
 
 void RayCastingWidget::updateClippingPlane(Plane clippingPlane)
@@ -99,14 +276,30 @@ void RayCastingWidget::updateClippingPlane(Plane clippingPlane)
     update();
 }
 
+void RayCastingWidget::updateCutPlanes(const std::vector<Plane>& cutPlanes)
+{
+    m_volumeRenderer.setCutPlanes(cutPlanes);
+    update();
+}
+
+void RayCastingWidget::updateCropBox(const CropBox& cropBox)
+{
+    m_volumeRenderer.setCropBox(cropBox);
+    update();
+}
+
 void RayCastingWidget::changeTransferFunction(QString transferFunction)
 {
     m_transferFunctionName = transferFunction;
     update();
 }
 
-void RayCastingWidget::changeRenderSettings(RenderSettings renderSettings)
+void RayCastingWidget::changeRenderSetting(
+    const RenderSettings& renderSettings, RenderSetting setting)
 {
+    if (renderSettings.generation == m_renderSettings.generation)
+        return;
     m_renderSettings = renderSettings;
+    m_volumeRenderer.renderSettingChanged(setting);
     update();
 }
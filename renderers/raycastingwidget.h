@@ -6,14 +6,21 @@
 #include "../properties/sharedproperties.h"
 #include "../properties/viewport.h"
 #include "../texturestore.h"
+#include "accumulationbuffer.h"
+#include "gputracer.h"
 #include "planerenderer.h"
+#include "resolutionscaler.h"
 #include "slicingplanecontrols.h"
 #include "volumerenderer.h"
 
 #include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLShaderProgram>
+#include <QOpenGLTimerQuery>
 #include <QOpenGLWidget>
+#include <QTimer>
 #include <QtImGui.h>
+#include <memory>
 
 class LightRenderer;
 
@@ -38,6 +45,14 @@ class RayCastingWidget : public QOpenGLWidget
                      QWidget* parent = nullptr,
                      Qt::WindowFlags f = Qt::WindowFlags());
 
+    // The volume is raycast at a fraction of the widget resolution chosen
+    // to fit the frame time budget, and scaled up to the widget.
+    ResolutionScaler& resolutionScaler() { return m_resolutionScaler; };
+    const ResolutionScaler& resolutionScaler() const
+    {
+        return m_resolutionScaler;
+    };
+
   protected:
     virtual void initializeGL();
     virtual void resizeGL(int w, int h);
@@ -48,10 +63,22 @@ class RayCastingWidget : public QOpenGLWidget
     void updateLightTransformMatrix();
     void zoomCamera(float zoomFactor);
     void updateClippingPlane(Plane clippingPlane);
+    void updateCutPlanes(const std::vector<Plane>& cutPlanes);
+    void updateCropBox(const CropBox& cropBox);
     void changeTransferFunction(QString transferFunctionName);
-    void changeRenderSettings(RenderSettings renderSettings);
+    // Takes a copy of the settings after the given one changed in them.
+    void changeRenderSetting(const RenderSettings& renderSettings,
+                             RenderSetting setting);
 
   private:
+    void startInteraction();
+    void paintVolume();
+    // Feeds the GPU time of the previous volume pass to the scaler once the
+    // query has a result, without waiting for it.
+    void collectVolumeTime();
+    // Hands the counters of the frame to the PerformanceStats.
+    void reportStatistics();
+
     QOpenGLExtraFunctions m_openGLExtra;
     std::unique_ptr<ITextureStore>& m_textureStore;
     QOpenGLShaderProgram m_cubeProgram;
@@ -59,6 +86,8 @@ class RayCastingWidget : public QOpenGLWidget
     QMatrix4x4 m_viewMatrix;
     QMatrix4x4 m_lightTranslation;
     ViewPort m_viewPort;
+    // Pixel size of the target the volume is raycast into.
+    ViewPort m_volumeViewPort;
 
     RenderSettings m_renderSettings;
     QString m_transferFunctionName;
@@ -69,6 +98,44 @@ class RayCastingWidget : public QOpenGLWidget
     VolumeRenderer m_volumeRenderer;
     PlaneRenderer m_planeRenderer;
     LightRenderer m_lightRenderer;
+    // Restarted by every camera change, the view renders at full detail
+    // again once it runs out.
+    QTimer m_interactionTimer;
+    constexpr static int INTERACTION_TIMEOUT_MS = 200;
+
+    // Camera changes render a single frame with a coarse, jittered step, at
+    // the resolution the scaler picks. Once the view is idle, the coarse step
+    // is rendered again at full resolution once for each full step in it,
+    // the samples of every pass moved back by another full step, and the
+    // passes are added into a running mean. Together they take the samples
+    // of the full step. Each pass is scheduled by m_refinementTimer after the
+    // previous one is shown.
+    constexpr static float INTERACTION_STEP_SCALE = 2.0f;
+    constexpr static int REFINEMENT_PASSES =
+        static_cast<int>(INTERACTION_STEP_SCALE);
+    AccumulationBuffer m_accumulationBuffer;
+    QTimer m_refinementTimer;
+    // The pass being rendered, or -1 while interacting.
+    int m_refinementPass{-1};
+    // Set when a repaint was asked for by the refinement timer, any other
+    // repaint means the view changed and starts the passes over.
+    bool m_refinementRequested{false};
+    int m_interactionFrame{0};
+
+    // While the statistics are shown, every RAY_STATISTICS_INTERVAL-th frame
+    // counts its rays. The counters slow the shader down, so those frames
+    // are not timed.
+    constexpr static int RAY_STATISTICS_INTERVAL = 16;
+    int m_frame{0};
+    bool m_countingRays{false};
+
+    ResolutionScaler m_resolutionScaler;
+    std::unique_ptr<QOpenGLFramebufferObject> m_volumeFramebuffer;
+    QOpenGLTimerQuery m_volumeTimer;
+    bool m_volumeTimerPending{false};
+    // Whether the query in flight times a refinement pass.
+    bool m_timingRefinement{false};
+    GpuTracer m_gpuTracer;
 
     qreal m_nearPlane = 0.5;
     qreal m_farPlane = 32.0;
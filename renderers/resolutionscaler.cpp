@@ -0,0 +1,46 @@
+#include "resolutionscaler.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+ResolutionScaler::ResolutionScaler()
+{
+    bool ok = false;
+    const float budget =
+        qEnvironmentVariable("STRANGEVIS_FRAME_BUDGET_MS").toFloat(&ok);
+    if (ok)
+        setFrameTimeBudget(budget);
+    const float scale =
+        qEnvironmentVariable("STRANGEVIS_RESOLUTION_SCALE").toFloat(&ok);
+    if (ok)
+        pin(scale);
+}
+
+void ResolutionScaler::setFrameTimeBudget(float milliseconds)
+{
+    if (milliseconds > 0.0f)
+        m_budget = milliseconds;
+}
+
+void ResolutionScaler::pin(float scale)
+{
+    m_scale = snap(scale);
+    m_pinned = true;
+}
+
+void ResolutionScaler::addFrameTime(float milliseconds)
+{
+    m_lastFrameTime = milliseconds;
+    if (m_pinned || milliseconds <= 0.0f)
+        return;
+    const float ratio = m_budget / milliseconds;
+    if (std::abs(ratio - 1.0f) < TOLERANCE)
+        return;
+    m_scale = snap(m_scale * std::sqrt(ratio));
+}
+
+float ResolutionScaler::snap(float scale)
+{
+    return std::clamp(std::round(scale * STEPS) / STEPS, MINIMUM_SCALE, 1.0f);
+}
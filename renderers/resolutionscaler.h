@@ -0,0 +1,46 @@
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+// Chooses the fraction of the widget resolution the volume is raycast at,
+// so that the volume pass stays within a frame time budget. The cost of the
+// pass grows with the pixel count, the square of the scale, so each measured
+// frame moves the scale by the square root of the ratio between the budget
+// and the measurement. Scales snap to steps of 1/STEPS and only move when
+// the frame time is well off the budget, so the offscreen target is not
+// reallocated every frame.
+//
+// STRANGEVIS_FRAME_BUDGET_MS sets the budget, and STRANGEVIS_RESOLUTION_SCALE
+// pins the scale, which can also be pinned from the performance panel.
+class ResolutionScaler
+{
+  public:
+    constexpr static float MINIMUM_SCALE = 0.25f;
+    constexpr static float DEFAULT_BUDGET_MS = 16.0f;
+    constexpr static int STEPS = 16;
+    // Frame times within this fraction of the budget leave the scale as is.
+    constexpr static float TOLERANCE = 0.15f;
+
+    ResolutionScaler();
+
+    void setFrameTimeBudget(float milliseconds);
+    float frameTimeBudget() const { return m_budget; };
+    // A pinned scale ignores the measurements until unpinned.
+    void pin(float scale);
+    void unpin() { m_pinned = false; };
+    bool pinned() const { return m_pinned; };
+
+    // Reports how long the last pass at the current scale took.
+    void addFrameTime(float milliseconds);
+    float lastFrameTime() const { return m_lastFrameTime; };
+    float scale() const { return m_scale; };
+
+  private:
+    static float snap(float scale);
+
+    float m_budget{DEFAULT_BUDGET_MS};
+    float m_scale{1.0f};
+    float m_lastFrameTime{0.0f};
+    bool m_pinned{false};
+};
+
+#endif // RESOLUTIONSCALER_H
@@ -1,5 +1,7 @@
 #include "slicingplanecontrols.h"
 
+#include "../tracer.h"
+
 namespace
 {
 constexpr float G_SIZE = 4.f; // Scales the size of the gizmo
@@ -8,12 +10,15 @@ constexpr float SNAP_ANGLE = 15.f;
 constexpr float SNAP_T = 0.02f;
 constexpr float SNAP_TRANSLATION[3]{SNAP_T, SNAP_T, SNAP_T};
 constexpr ImGuizmo::MODE MODE{ImGuizmo::WORLD};
+constexpr const char* AXES[]{"X", "Y", "Z"};
 } // namespace
 
 void SlicingPlaneControls::paint()
 {
+    TRACE_ZONE("SlicingPlaneControls::paint");
     manipulateRotation();
     manipulateTranslation();
+    paintClipping();
 }
 
 void SlicingPlaneControls::manipulateRotation()
@@ -78,3 +83,64 @@ void SlicingPlaneControls::manipulateTranslation()
         m_resetTranslationMatrixTimer.start();
     }
 }
+
+// Cut planes are taken from the slicing plane, so they are placed with the
+// gizmos above and kept when the slicing plane moves on.
+void SlicingPlaneControls::paintClipping()
+{
+    auto io = ImGui::GetIO();
+    auto [w, h] = io.DisplaySize;
+    // Left of the gizmos, collapsed until it is needed.
+    ImGui::SetNextWindowPos(ImVec2(w - G_AREA, h - 2 * G_AREA),
+                            ImGuiCond_FirstUseEver, ImVec2(1, 0));
+    ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.75f);
+    if (!ImGui::Begin("Clipping", nullptr,
+                      ImGuiWindowFlags_AlwaysAutoResize |
+                          ImGuiWindowFlags_NoFocusOnAppearing))
+    {
+        ImGui::End();
+        return;
+    }
+
+    auto& clipping = m_properties->clippingPlane();
+    const auto& cutPlanes = clipping.cutPlanes();
+    ImGui::Text("Cut planes: %d of %d", static_cast<int>(cutPlanes.size()),
+                ClippingPlaneProperties::MAX_CUT_PLANES);
+    // A cut removes the half its normal points away from, the flipped cut
+    // the other half.
+    if (ImGui::Button("Cut at slicing plane"))
+        clipping.addCutPlane(clipping.plane());
+    ImGui::SameLine();
+    if (ImGui::Button("Flipped"))
+        clipping.addCutPlane(Plane{-clipping.plane().equation()});
+
+    int removed = -1;
+    for (int i = 0; i < static_cast<int>(cutPlanes.size()); ++i)
+    {
+        const QVector3D normal = cutPlanes[i].normal().normalized();
+        ImGui::PushID(i);
+        ImGui::Text("Normal (%.2f, %.2f, %.2f), d %.2f", normal.x(),
+                    normal.y(), normal.z(), cutPlanes[i].d());
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Remove"))
+            removed = i;
+        ImGui::PopID();
+    }
+    if (removed >= 0)
+        clipping.removeCutPlane(removed);
+
+    ImGui::Separator();
+    CropBox cropBox = clipping.cropBox();
+    bool cropped = false;
+    for (int axis = 0; axis < 3; ++axis)
+        cropped |= ImGui::DragFloatRange2(AXES[axis], &cropBox.minimum[axis],
+                                          &cropBox.maximum[axis], 0.01f, -1.f,
+                                          1.f, "%.2f");
+    if (cropped)
+        clipping.updateCropBox(cropBox);
+    if (ImGui::Button("Reset crop box"))
+        clipping.updateCropBox(CropBox{});
+
+    ImGui::End();
+}
@@ -27,6 +27,7 @@ class SlicingPlaneControls
   private:
     void manipulateRotation();
     void manipulateTranslation();
+    void paintClipping();
     std::shared_ptr<ISharedProperties> m_properties;
     QMatrix4x4 m_rotationMatrix;
     QMatrix4x4 m_translationMatrix;
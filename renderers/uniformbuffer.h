@@ -0,0 +1,52 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <QOpenGLExtraFunctions>
+#include <cstring>
+#include <type_traits>
+
+// A std140 uniform block backed by a buffer that stays attached to its
+// binding point, so every program declaring the block sees it without any
+// per-program setup. Block mirrors the std140 layout of the GLSL block, and
+// update() only uploads it when its contents changed.
+template <typename Block> class UniformBuffer
+{
+    static_assert(std::is_trivially_copyable_v<Block>);
+    static_assert(sizeof(Block) % 16 == 0,
+                  "std140 blocks are padded to a multiple of 16 bytes");
+
+  public:
+    explicit UniformBuffer(GLuint binding) : m_binding{binding} {};
+
+    void create(QOpenGLExtraFunctions& gl)
+    {
+        m_gl = &gl;
+        if (m_buffer)
+            gl.glDeleteBuffers(1, &m_buffer);
+        gl.glGenBuffers(1, &m_buffer);
+        gl.glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        gl.glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr,
+                        GL_DYNAMIC_DRAW);
+        gl.glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_buffer);
+        m_uploaded = false;
+    };
+
+    void update(const Block& block)
+    {
+        if (m_uploaded && std::memcmp(&block, &m_block, sizeof(Block)) == 0)
+            return;
+        m_block = block;
+        m_uploaded = true;
+        m_gl->glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        m_gl->glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &m_block);
+    };
+
+  private:
+    GLuint m_binding;
+    GLuint m_buffer{0};
+    QOpenGLExtraFunctions* m_gl{nullptr};
+    Block m_block{};
+    bool m_uploaded{false};
+};
+
+#endif // UNIFORMBUFFER_H
@@ -1,121 +1,622 @@
 #include "volumerenderer.h"
 
+#include "../tracer.h"
 #include "../geometry.h"
 
+#include <QFile>
+#include <QVector4D>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+void copyMatrix(const QMatrix4x4& matrix, GLfloat* target)
+{
+    std::copy(matrix.constData(), matrix.constData() + 16, target);
+}
+
+void copyVector(const QVector3D& vector, GLfloat* target)
+{
+    target[0] = vector.x();
+    target[1] = vector.y();
+    target[2] = vector.z();
+}
+} // namespace
+
 VolumeRenderer::VolumeRenderer(
     const std::unique_ptr<ITextureStore>& textureStore,
-    RenderSettings& settings, const CameraProperties& camera,
+    const RenderSettings& settings, const CameraProperties& camera,
     QOpenGLExtraFunctions& openGLExtra, const ViewPort& viewPort,
     LightRenderer& lightRenderer, const Plane& plane)
     : m_textureStore{textureStore}, m_renderSettings{settings},
       m_lightRenderer{lightRenderer}, m_camera{camera},
-      m_openGLExtra{openGLExtra}, m_viewPort{viewPort}, m_plane{plane}
+      m_openGLExtra{openGLExtra}, m_proxyGeometryPass{openGLExtra},
+      m_viewPort{viewPort}, m_plane{plane}
 {
 }
 
 void VolumeRenderer::paint()
 {
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    TRACE_ZONE("VolumeRenderer::paint");
+    m_openGLExtra.glEnable(GL_BLEND);
+    m_openGLExtra.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    if (m_renderSettings.generation != m_renderSettingsGeneration)
+    {
+        m_programChanged = true;
+        m_settingsBlockChanged = true;
+        m_renderSettingsGeneration = m_renderSettings.generation;
+    }
+    if (m_programChanged)
+    {
+        m_cubeProgram = &cubeProgram();
+        m_programChanged = false;
+    }
+    if (m_settingsBlockChanged)
+    {
+        updateSettingsBlock();
+        m_settingsBlockChanged = false;
+    }
+    updateProxyGeometry();
     setUniforms();
+    // Reads the camera block just uploaded.
+    if (m_useProxyGeometry)
+    {
+        const QVector2D size = m_viewPort.viewPort();
+        m_proxyGeometryPass.render(QSize(static_cast<int>(size.x()),
+                                         static_cast<int>(size.y())));
+    }
+
+    m_cubeProgram->program->bind();
     bindTextures();
+    readRayStatistics();
+    if (m_collectRayStatistics)
+    {
+        m_openGLExtra.glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       RAY_STATISTICS_BINDING,
+                                       m_rayStatisticsBuffer);
+    }
+    const bool rayCost = m_renderSettings.rayCost != RayCostView::Off;
+    if (rayCost)
+    {
+        readRayCost();
+        m_openGLExtra.glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       RAY_COST_BINDING, m_rayCostBuffer);
+    }
+    else if (m_rayCostBuffer)
+    {
+        releaseRayCost();
+    }
 
-    Geometry::instance().bindCube();
+    if (m_renderSettings.computeRaycaster)
+    {
+        dispatchRays();
+    }
+    else
+    {
+        Geometry::instance().bindCube();
 
-    setAttributes();
+        setAttributes();
 
-    Geometry::instance().drawCube();
+        // Only the back faces, one ray per pixel wherever the camera is.
+        m_openGLExtra.glEnable(GL_CULL_FACE);
+        m_openGLExtra.glCullFace(GL_FRONT);
+        Geometry::instance().drawCube();
+        m_openGLExtra.glDisable(GL_CULL_FACE);
+    }
 
-    m_textureStore->transferFunction().release();
-    m_textureStore->volume().release();
-    m_cubeProgram.release();
+    if (m_collectRayStatistics)
+    {
+        m_openGLExtra.glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       RAY_STATISTICS_BINDING, 0);
+        m_rayStatisticsPending = true;
+        const QVector2D size = m_viewPort.viewPort();
+        m_rayStatisticsPixels =
+            static_cast<qint64>(size.x()) * static_cast<qint64>(size.y());
+    }
+    if (rayCost)
+    {
+        m_openGLExtra.glBindBufferBase(GL_SHADER_STORAGE_BUFFER,
+                                       RAY_COST_BINDING, 0);
+        m_rayCostPending = true;
+    }
+    releaseTextures();
+    m_cubeProgram->program->release();
+}
+
+void VolumeRenderer::setCollectRayStatistics(bool collect)
+{
+    if (collect == m_collectRayStatistics)
+        return;
+    m_collectRayStatistics = collect;
+    // Selects the program variant with or without the counters. The counts
+    // of the last frame that had them are still read back.
+    m_programChanged = true;
+}
+
+void VolumeRenderer::renderSettingChanged(RenderSetting setting)
+{
+    const bool permutation =
+        setting == RenderSetting::ComputeRaycaster ||
+        setting == RenderSetting::RayCost ||
+        std::any_of(PERMUTATION_SETTINGS.begin(), PERMUTATION_SETTINGS.end(),
+                    [setting](const auto& key) {
+                        return key.setting == setting;
+                    });
+    if (permutation)
+        m_programChanged = true;
+    else
+        m_settingsBlockChanged = true;
+    m_renderSettingsGeneration = m_renderSettings.generation;
+}
+
+void VolumeRenderer::readRayStatistics()
+{
+    // Like the brick usage, the counts are mapped on the next frame, when the
+    // frame that wrote them has usually finished.
+    if (m_rayStatisticsPending)
+    {
+        m_openGLExtra.glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER,
+                                   m_rayStatisticsBuffer);
+        auto* counts = static_cast<GLuint*>(m_openGLExtra.glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, 4 * sizeof(GLuint),
+            GL_MAP_READ_BIT | GL_MAP_WRITE_BIT));
+        if (counts)
+        {
+            m_rayStatistics.rays = counts[0];
+            m_rayStatistics.samples =
+                counts[1] + (static_cast<qint64>(counts[2]) << 32);
+            m_rayStatistics.terminatedRays = counts[3];
+            m_rayStatistics.pixels = m_rayStatisticsPixels;
+            std::fill(counts, counts + 4, 0u);
+            m_openGLExtra.glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        }
+        m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    m_rayStatisticsPending = false;
+}
+
+void VolumeRenderer::readRayCost()
+{
+    const QVector2D viewPort = m_viewPort.viewPort();
+    const qint64 bytes = static_cast<qint64>(viewPort.x()) *
+                         static_cast<qint64>(viewPort.y()) * 4 *
+                         static_cast<qint64>(sizeof(GLuint));
+    if (!m_rayCostBuffer)
+        m_openGLExtra.glGenBuffers(1, &m_rayCostBuffer);
+    m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_rayCostBuffer);
+    if (bytes != m_rayCostBufferBytes)
+    {
+        // Counts of another size are of no use, the next frame starts over.
+        m_openGLExtra.glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr,
+                                   GL_DYNAMIC_READ);
+        m_rayCostBufferBytes = bytes;
+        m_rayCostPending = false;
+        m_rayCost = RayCost{};
+        void* counters = m_openGLExtra.glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (counters)
+        {
+            std::memset(counters, 0, bytes);
+            m_openGLExtra.glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        }
+    }
+    else if (m_rayCostPending)
+    {
+        m_openGLExtra.glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        auto* counters = static_cast<GLuint*>(m_openGLExtra.glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, bytes,
+            GL_MAP_READ_BIT | GL_MAP_WRITE_BIT));
+        if (counters)
+        {
+            RayCost cost;
+            cost.pixels = bytes / 16;
+            for (qint64 pixel = 0; pixel < bytes / 16; pixel++)
+            {
+                const GLuint* counter = counters + 4 * pixel;
+                if (counter[3] == 0)
+                    continue;
+                cost.rays++;
+                cost.samples += counter[0];
+                cost.shadedSamples += counter[1];
+                cost.fetches += counter[2];
+                // The exit codes of cube-fs.glsl.
+                cost.opacityExits += counter[3] == 1;
+                cost.boxExits += counter[3] == 2;
+                cost.clipExits += counter[3] == 3;
+            }
+            m_rayCost = cost;
+            std::memset(counters, 0, bytes);
+            m_openGLExtra.glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        }
+    }
+    m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    m_rayCostPending = false;
+}
+
+void VolumeRenderer::releaseRayCost()
+{
+    m_openGLExtra.glDeleteBuffers(1, &m_rayCostBuffer);
+    m_rayCostBuffer = 0;
+    m_rayCostBufferBytes = 0;
+    m_rayCostPending = false;
+    m_rayCost = RayCost{};
+}
+
+void VolumeRenderer::dispatchRays()
+{
+    const QVector2D viewPort = m_viewPort.viewPort();
+    const QSize size(static_cast<int>(viewPort.x()),
+                     static_cast<int>(viewPort.y()));
+    if (!m_computeOutput || m_computeOutput->width() != size.width() ||
+        m_computeOutput->height() != size.height())
+    {
+        m_computeOutput =
+            std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+        m_computeOutput->setFormat(QOpenGLTexture::RGBA16F);
+        m_computeOutput->setMinificationFilter(QOpenGLTexture::Nearest);
+        m_computeOutput->setMagnificationFilter(QOpenGLTexture::Nearest);
+        m_computeOutput->setMipLevels(1);
+        m_computeOutput->setSize(size.width(), size.height());
+        m_computeOutput->allocateStorage();
+    }
+    const QRect tiles = tileBounds(size);
+    if (tiles.isEmpty())
+        return;
+
+    m_openGLExtra.glBindImageTexture(OUTPUT_IMAGE_UNIT,
+                                     m_computeOutput->textureId(), 0, GL_FALSE,
+                                     0, GL_WRITE_ONLY, GL_RGBA16F);
+    m_openGLExtra.glUniform2i(TILE_ORIGIN_LOCATION, tiles.x(), tiles.y());
+    m_openGLExtra.glDispatchCompute(tiles.width() / TILE_SIZE,
+                                    tiles.height() / TILE_SIZE, 1);
+    m_openGLExtra.glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // Pixels outside the dispatched tiles were not written this frame.
+    m_openGLExtra.glEnable(GL_SCISSOR_TEST);
+    m_openGLExtra.glScissor(tiles.x(), tiles.y(), tiles.width(),
+                            tiles.height());
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + COMPOSITE_UNIT);
+    m_computeOutput->bind();
+    m_compositeProgram.bind();
+    m_compositeProgram.setUniformValue(0, COMPOSITE_UNIT);
+    m_openGLExtra.glDrawArrays(GL_TRIANGLES, 0, 3);
+    m_compositeProgram.release();
+    m_computeOutput->release();
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0);
+    m_openGLExtra.glDisable(GL_SCISSOR_TEST);
+    m_openGLExtra.glBindImageTexture(OUTPUT_IMAGE_UNIT, 0, 0, GL_FALSE, 0,
+                                     GL_WRITE_ONLY, GL_RGBA16F);
+}
+
+QRect VolumeRenderer::tileBounds(QSize size) const
+{
+    const QRect viewPort(QPoint(0, 0), size);
+    // Only the part of the volume that can be visible: the occupied blocks
+    // within the crop box.
+    QVector3D minimum(-1.0f, -1.0f, -1.0f);
+    QVector3D maximum(1.0f, 1.0f, 1.0f);
+    if (m_useProxyGeometry)
+    {
+        minimum = m_proxyGeometryPass.minimum();
+        maximum = m_proxyGeometryPass.maximum();
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        minimum[axis] = std::max(minimum[axis], m_cropBox.minimum[axis]);
+        maximum[axis] = std::min(maximum[axis], m_cropBox.maximum[axis]);
+        if (minimum[axis] >= maximum[axis])
+            return QRect();
+    }
+
+    const QMatrix4x4 modelViewProjection = m_camera.projectionMatrix() *
+                                           m_viewMatrix *
+                                           m_textureStore->volume().modelMatrix();
+    float left = std::numeric_limits<float>::max();
+    float bottom = left;
+    float right = std::numeric_limits<float>::lowest();
+    float top = right;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const QVector4D position = modelViewProjection.map(
+            QVector4D(corner & 1 ? maximum.x() : minimum.x(),
+                      corner & 2 ? maximum.y() : minimum.y(),
+                      corner & 4 ? maximum.z() : minimum.z(), 1.0f));
+        // A corner behind the camera projects anywhere.
+        if (position.w() <= 0.0f)
+            return viewPort;
+        left = std::min(left, position.x() / position.w());
+        right = std::max(right, position.x() / position.w());
+        bottom = std::min(bottom, position.y() / position.w());
+        top = std::max(top, position.y() / position.w());
+    }
+
+    // From normalized device coordinates to whole tiles of pixels.
+    auto tile = [](float ndc, int pixels, bool up) {
+        const float pixel = (ndc + 1.0f) * 0.5f * pixels / TILE_SIZE;
+        return static_cast<int>(up ? std::ceil(pixel) : std::floor(pixel)) *
+               TILE_SIZE;
+    };
+    const int x0 = std::max(tile(left, size.width(), false), 0);
+    const int y0 = std::max(tile(bottom, size.height(), false), 0);
+    const int x1 = std::min(tile(right, size.width(), true),
+                            tile(1.0f, size.width(), true));
+    const int y1 = std::min(tile(top, size.height(), true),
+                            tile(1.0f, size.height(), true));
+    if (x0 >= x1 || y0 >= y1)
+        return QRect();
+    return QRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void VolumeRenderer::updateProxyGeometry()
+{
+    Volume& volume = m_textureStore->volume();
+    const auto& transferFunction = m_textureStore->transferFunction();
+    volume.updateOccupancy(transferFunction.opacity(),
+                           transferFunction.opacityRevision());
+    m_proxyGeometryPass.setMesh(volume.proxyGeometry(),
+                                volume.proxyGeometryRevision());
+    // The mesh leaves out transparent blocks, which maximum intensity
+    // projection still takes the maximum over.
+    m_useProxyGeometry = m_proxyGeometryEnabled &&
+                         volume.emptySpaceSkipping() &&
+                         !m_renderSettings.maxInt &&
+                         !m_proxyGeometryPass.empty();
 }
 
 void VolumeRenderer::setUniforms()
 {
-    int location = -1;
-    auto modelViewProjectionMatrix = m_camera.projectionViewMatrix() *
-                                     m_textureStore->volume().modelMatrix();
-
-    QVector3D rayOrigin =
-        m_camera.viewMatrix().inverted().map(QVector3D(0, 0, 0));
-
-    m_cubeProgram.bind();
-    location = m_cubeProgram.uniformLocation("rayOrigin");
-    m_cubeProgram.setUniformValue(location, rayOrigin);
-    location = m_cubeProgram.uniformLocation("viewMatrix");
-    m_cubeProgram.setUniformValue(location, m_camera.viewMatrix());
-    location = m_cubeProgram.uniformLocation("modelMatrix");
-    m_cubeProgram.setUniformValue(location,
-                                  m_textureStore->volume().modelMatrix());
-    location = m_cubeProgram.uniformLocation("modelViewProjectionMatrix");
-    m_cubeProgram.setUniformValue(location, modelViewProjectionMatrix);
-
-    location = m_cubeProgram.uniformLocation("focalLength");
-    m_cubeProgram.setUniformValue(location, m_camera.focalLength());
-    location = m_cubeProgram.uniformLocation("viewportSize");
-    m_cubeProgram.setUniformValue(location, m_viewPort.viewPort());
-    location = m_cubeProgram.uniformLocation("aspectRatio");
-    m_cubeProgram.setUniformValue(location, m_viewPort.aspectRatio());
-
-    auto [width, height, depth] = m_textureStore->volume().getDimensions();
-    location = m_cubeProgram.uniformLocation("width");
-    m_cubeProgram.setUniformValue(location, static_cast<int>(width));
-    location = m_cubeProgram.uniformLocation("height");
-    m_cubeProgram.setUniformValue(location, static_cast<int>(height));
-    location = m_cubeProgram.uniformLocation("depth");
-    m_cubeProgram.setUniformValue(location, static_cast<int>(depth));
-
-    location = m_cubeProgram.uniformLocation("planeNormal");
-    m_cubeProgram.setUniformValue(location, m_plane.normal());
-    location = m_cubeProgram.uniformLocation("planePoint");
-    m_cubeProgram.setUniformValue(location, m_plane.point());
-
-    const QVector4D lightPosition = m_lightRenderer.getLightTransform().inverted() * QVector4D(0.0f, 0.0f, 0.0f, 1.0f);
-    location = m_cubeProgram.uniformLocation("lightPosition");
-    m_cubeProgram.setUniformValue(location, QVector3D(lightPosition.x(), lightPosition.y(), lightPosition.z()));
-
-    for (const auto& [key, value] : m_renderSettings)
-    {
-        location = m_cubeProgram.uniformLocation(key);
-        std::visit(
-            [this, location](const auto& arg) {
-                m_cubeProgram.setUniformValue(location, arg);
-            },
-            value);
+    const QMatrix4x4 viewMatrix = m_camera.viewMatrix();
+    if (viewMatrix != m_viewMatrix)
+    {
+        m_viewMatrix = viewMatrix;
+        m_rayOrigin = viewMatrix.inverted().map(QVector3D(0, 0, 0));
+    }
+    const Volume& volume = m_textureStore->volume();
+    const QMatrix4x4 modelMatrix = volume.modelMatrix();
+
+    CameraBlock camera{};
+    copyMatrix(viewMatrix, camera.viewMatrix);
+    copyMatrix(modelMatrix, camera.modelMatrix);
+    copyMatrix(m_camera.projectionMatrix() * viewMatrix * modelMatrix,
+               camera.modelViewProjectionMatrix);
+    copyVector(m_rayOrigin, camera.rayOrigin);
+    camera.aspectRatio = m_viewPort.aspectRatio();
+    camera.viewportSize[0] = m_viewPort.viewPort().x();
+    camera.viewportSize[1] = m_viewPort.viewPort().y();
+    camera.focalLength = m_camera.focalLength();
+    m_cameraBuffer.update(camera);
+
+    const auto [width, height, depth] = volume.getDimensions();
+    VolumeBlock volumeBlock{};
+    volumeBlock.width = static_cast<GLint>(width);
+    volumeBlock.height = static_cast<GLint>(height);
+    volumeBlock.depth = static_cast<GLint>(depth);
+    volumeBlock.intensityScale = volume.intensityScale();
+    volumeBlock.loadedDepth = volume.loadedDepth();
+    volumeBlock.mipLevels = volume.mipLevels();
+    volumeBlock.lodBias = m_interacting ? INTERACTION_LOD_BIAS : 0.0f;
+    volumeBlock.bricked = volume.bricked();
+    volumeBlock.brickSize = volume.brickSize();
+    volumeBlock.emptySpaceSkipping = volume.emptySpaceSkipping();
+    volumeBlock.occupancyBlockSize = volume.emptySpaceBlockSize();
+    volumeBlock.precomputedGradients = volume.precomputedGradients();
+    volumeBlock.stepScale = m_stepScale;
+    volumeBlock.samplingPass = m_samplingPass;
+    volumeBlock.proxyGeometry = m_useProxyGeometry;
+    volumeBlock.stepOffset = m_stepOffset;
+    m_volumeBuffer.update(volumeBlock);
+
+    const QMatrix4x4 lightTransform = m_lightRenderer.getLightTransform();
+    if (lightTransform != m_lightTransform)
+    {
+        m_lightTransform = lightTransform;
+        m_lightPosition = lightTransform.inverted().map(QVector3D(0, 0, 0));
+    }
+    SceneBlock scene{};
+    copyVector(m_plane.normal(), scene.planeNormal);
+    copyVector(m_plane.point(), scene.planePoint);
+    copyVector(m_lightPosition, scene.lightPosition);
+    // From model coordinates in [-1, 1] to texture coordinates in [0, 1].
+    const int cutPlaneCount =
+        std::min(static_cast<int>(m_cutPlanes.size()),
+                 ClippingPlaneProperties::MAX_CUT_PLANES);
+    for (int i = 0; i < cutPlaneCount; i++)
+    {
+        const QVector3D normal = m_cutPlanes[i].normal();
+        const QVector3D point =
+            (m_cutPlanes[i].point() + QVector3D(1, 1, 1)) * 0.5f;
+        copyVector(normal, scene.cutPlanes[i]);
+        scene.cutPlanes[i][3] = -QVector3D::dotProduct(normal, point);
     }
+    scene.cutPlaneCount = cutPlaneCount;
+    copyVector((m_cropBox.minimum + QVector3D(1, 1, 1)) * 0.5f,
+               scene.cropMinimum);
+    copyVector((m_cropBox.maximum + QVector3D(1, 1, 1)) * 0.5f,
+               scene.cropMaximum);
+    m_sceneBuffer.update(scene);
+}
+
+void VolumeRenderer::updateSettingsBlock()
+{
+    SettingsBlock settings{};
+    settings.ambientInt = m_renderSettings.ambientInt;
+    settings.diffuseInt = m_renderSettings.diffuseInt;
+    settings.specInt = m_renderSettings.specInt;
+    settings.specCoeff = m_renderSettings.specCoeff;
+    settings.sliceNr = m_renderSettings.sliceNr;
+    m_settingsBuffer.update(settings);
 }
 
 void VolumeRenderer::bindTextures()
 {
-    m_openGLExtra.glActiveTexture(GL_TEXTURE0);
-    m_cubeProgram.setUniformValue("volumeTexture", 0);
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + VOLUME_UNIT);
     m_textureStore->volume().bind();
 
-    m_openGLExtra.glActiveTexture(GL_TEXTURE1);
-    m_cubeProgram.setUniformValue("transferFunction", 1);
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + TRANSFER_FUNCTION_UNIT);
     m_textureStore->transferFunction().bind();
+
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + MAXIMUM_VOLUME_UNIT);
+    m_textureStore->volume().bindMaximumPyramid();
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0);
+
+    // Whether the volume is bricked is only known once it has been bound.
+    Volume& volume = m_textureStore->volume();
+    m_bricksPending = volume.updateBricks();
+    volume.bindBricks(BRICK_ATLAS_UNIT, PAGE_TABLE_UNIT);
+
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + OCCUPANCY_UNIT);
+    volume.bindOccupancy();
+
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0 + GRADIENT_UNIT);
+    volume.bindGradients();
+
+    // Only built for the programs that sample it.
+    if (m_renderSettings.preIntegration)
+    {
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0 + PRE_INTEGRATION_UNIT);
+        m_textureStore->transferFunction().bindPreIntegration();
+    }
+    if (m_useProxyGeometry)
+    {
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0 + RAY_ENTRY_UNIT);
+        m_openGLExtra.glBindTexture(GL_TEXTURE_2D,
+                                    m_proxyGeometryPass.entryTexture());
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0 + RAY_EXIT_UNIT);
+        m_openGLExtra.glBindTexture(GL_TEXTURE_2D,
+                                    m_proxyGeometryPass.exitTexture());
+    }
+    m_openGLExtra.glActiveTexture(GL_TEXTURE0);
+}
+
+void VolumeRenderer::releaseTextures()
+{
+    if (m_useProxyGeometry)
+    {
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0 + RAY_EXIT_UNIT);
+        m_openGLExtra.glBindTexture(GL_TEXTURE_2D, 0);
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0 + RAY_ENTRY_UNIT);
+        m_openGLExtra.glBindTexture(GL_TEXTURE_2D, 0);
+        m_openGLExtra.glActiveTexture(GL_TEXTURE0);
+    }
+    if (m_renderSettings.preIntegration)
+        m_textureStore->transferFunction().releasePreIntegration();
+    m_textureStore->volume().releaseGradients();
+    m_textureStore->volume().releaseOccupancy();
+    m_textureStore->volume().releaseBricks();
+    m_textureStore->volume().releaseMaximumPyramid();
+    m_textureStore->transferFunction().release();
+    m_textureStore->volume().release();
 }
 
 void VolumeRenderer::setAttributes()
 {
-    int location = m_cubeProgram.attributeLocation("vertexPosition");
-    m_cubeProgram.enableAttributeArray(location);
-    m_cubeProgram.setAttributeBuffer(location, GL_FLOAT, 0, 3,
-                                     sizeof(QVector3D));
+    const int location = m_cubeProgram->vertexPosition;
+    m_cubeProgram->program->enableAttributeArray(location);
+    m_cubeProgram->program->setAttributeBuffer(location, GL_FLOAT, 0, 3,
+                                               sizeof(QVector3D));
 }
 
 void VolumeRenderer::compileShader()
 {
-    if (!m_cubeProgram.addShaderFromSourceFile(QOpenGLShader::Vertex,
-                                               ":shaders/cube-vs.glsl"))
-        qDebug() << "Could not load vertex shader!";
+    QFile vertexShader(":shaders/cube-vs.glsl");
+    QFile fragmentShader(":shaders/cube-fs.glsl");
+    if (!vertexShader.open(QIODevice::ReadOnly) ||
+        !fragmentShader.open(QIODevice::ReadOnly))
+        qDebug() << "Could not read shader sources!";
+    m_vertexSource = vertexShader.readAll();
+    m_fragmentSource = fragmentShader.readAll();
+    m_cubePrograms.clear();
 
-    if (!m_cubeProgram.addShaderFromSourceFile(QOpenGLShader::Fragment,
-                                               ":shaders/cube-fs.glsl"))
-        qDebug() << "Could not load fragment shader!";
+    m_cameraBuffer.create(m_openGLExtra);
+    m_volumeBuffer.create(m_openGLExtra);
+    m_sceneBuffer.create(m_openGLExtra);
+    m_settingsBuffer.create(m_openGLExtra);
+    if (!m_rayStatisticsBuffer)
+    {
+        const std::array<GLuint, 4> counts{};
+        m_openGLExtra.glGenBuffers(1, &m_rayStatisticsBuffer);
+        m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER,
+                                   m_rayStatisticsBuffer);
+        m_openGLExtra.glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counts),
+                                   counts.data(), GL_DYNAMIC_READ);
+        m_openGLExtra.glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    m_proxyGeometryPass.compileShader();
+    if (!m_compositeProgram.isLinked())
+    {
+        if (!m_compositeProgram.addShaderFromSourceFile(
+                QOpenGLShader::Vertex, ":shaders/accumulate-vs.glsl") ||
+            !m_compositeProgram.addShaderFromSourceFile(
+                QOpenGLShader::Fragment, ":shaders/accumulate-fs.glsl") ||
+            !m_compositeProgram.link())
+            qDebug() << "Could not build the composite shader program!";
+    }
+    m_programChanged = true;
+    m_settingsBlockChanged = true;
+}
 
-    if (!m_cubeProgram.link())
+VolumeRenderer::CubeProgram& VolumeRenderer::cubeProgram()
+{
+    // The #version directive has to stay on the first line.
+    QByteArray defines;
+    const bool compute = m_renderSettings.computeRaycaster;
+    if (compute)
+        defines += "#define COMPUTE_SHADER\n";
+    if (m_collectRayStatistics)
+        defines += "#define RAY_STATISTICS\n";
+    if (m_renderSettings.rayCost != RayCostView::Off)
+        defines += "#define RAY_COST " +
+                   QByteArray::number(m_renderSettings.rayCost) + "\n";
+    for (const auto& key : PERMUTATION_SETTINGS)
+    {
+        defines += QByteArray("#define ") + key.name +
+                   (m_renderSettings.*key.field ? " true" : " false") + "\n";
+    }
+
+    auto& cubeProgram = m_cubePrograms[defines];
+    if (cubeProgram.program)
+        return cubeProgram;
+
+    auto& program = cubeProgram.program;
+    program = std::make_unique<QOpenGLShaderProgram>();
+    const qsizetype versionEnd = m_fragmentSource.indexOf('\n') + 1;
+    QByteArray fragmentSource = m_fragmentSource;
+    fragmentSource.insert(versionEnd, defines);
+
+    if (compute)
+    {
+        if (!program->addShaderFromSourceCode(QOpenGLShader::Compute,
+                                              fragmentSource))
+            qDebug() << "Could not load compute shader!";
+    }
+    else
+    {
+        if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex,
+                                              m_vertexSource))
+            qDebug() << "Could not load vertex shader!";
+
+        if (!program->addShaderFromSourceCode(QOpenGLShader::Fragment,
+                                              fragmentSource))
+            qDebug() << "Could not load fragment shader!";
+    }
+
+    if (!program->link())
         qDebug() << "Could not link shader program!";
+
+    // Samplers stay on their units for the lifetime of the program, and
+    // everything else lives in the uniform blocks.
+    program->bind();
+    for (int unit = 0; unit < TEXTURE_UNITS; unit++)
+    {
+        program->setUniformValue(unit, unit);
+    }
+    program->release();
+    cubeProgram.vertexPosition = program->attributeLocation("vertexPosition");
+    return cubeProgram;
 }
@@ -2,20 +2,56 @@
 #define VOLUMERENDERER_H
 
 #include "../properties/cameraproperties.h"
+#include "../properties/clippingplaneproperties.h"
 #include "../properties/rendersettingsproperties.h"
 #include "../properties/viewport.h"
 #include "lightrenderer.h"
+#include "proxygeometrypass.h"
 #include "../texturestore.h"
 #include "../geometry/plane.h"
+#include "uniformbuffer.h"
 
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QRect>
+#include <array>
+#include <map>
+#include <memory>
 
 class VolumeRenderer
 {
   public:
+    // Totals over the rays of a frame.
+    struct RayStatistics
+    {
+        qint64 rays{0};
+        qint64 samples{0};
+        // Rays that reached full opacity before leaving the volume.
+        qint64 terminatedRays{0};
+        // Of the viewport the frame was rendered into.
+        qint64 pixels{0};
+    };
+    // Totals over the pixels of a frame rendered with a ray cost view, see
+    // RenderSettings::rayCost.
+    struct RayCost
+    {
+        // Zero until the counters of a frame have been read back.
+        qint64 pixels{0};
+        qint64 rays{0};
+        qint64 samples{0};
+        // Samples with a non-zero opacity, which are shaded.
+        qint64 shadedSamples{0};
+        qint64 fetches{0};
+        // Why the rays stopped: full opacity, leaving the volume, or a
+        // clipping plane or the crop box.
+        qint64 opacityExits{0};
+        qint64 boxExits{0};
+        qint64 clipExits{0};
+    };
+
     VolumeRenderer(const std::unique_ptr<ITextureStore>& textureStore,
-                   RenderSettings& settings,
+                   const RenderSettings& settings,
                    const CameraProperties& camera,
                    QOpenGLExtraFunctions& openGLextra,
                    const ViewPort& viewPort,
@@ -23,20 +59,210 @@ class VolumeRenderer
                    const Plane& plane
                    );
     void paint();
+    // Reads the shader sources and compiles the program variant for the
+    // current render settings. Other variants are compiled on first use,
+    // including the compute shader variants of cube-fs.glsl.
     void compileShader();
+    // While the view is being dragged, rays sample one mip level coarser.
+    void setInteracting(bool interacting) { m_interacting = interacting; };
+    // Multiplies the step length, and moves the first sample of every ray
+    // back by offset steps plus a per-pixel jitter that varies with pass. A
+    // negative pass disables the jitter.
+    void setRaySampling(float stepScale, float offset, int pass)
+    {
+        m_stepScale = stepScale;
+        m_stepOffset = offset;
+        m_samplingPass = pass;
+    };
+    // Removed from every ray before it is marched, on top of the slicing
+    // plane when the slice model option is on.
+    void setCutPlanes(const std::vector<Plane>& cutPlanes)
+    {
+        m_cutPlanes = cutPlanes;
+    };
+    void setCropBox(const CropBox& cropBox) { m_cropBox = cropBox; };
+    // Rays start and end at the rasterized proxy geometry wherever the volume
+    // has one, unless this is turned off.
+    void setProxyGeometry(bool enabled) { m_proxyGeometryEnabled = enabled; };
+    // True if the last frame requested bricks that are not resident yet.
+    bool bricksPending() const { return m_bricksPending; };
+    // Counts rays and samples in a program variant of its own, at the cost
+    // of a few atomic adds per ray. The totals of a frame are read back at
+    // the start of the next, whether or not that one counts as well, so
+    // single frames can be counted.
+    void setCollectRayStatistics(bool collect);
+    const RayStatistics& rayStatistics() const { return m_rayStatistics; };
+    // Picks up a change to one of the render settings. Only the settings a
+    // program variant is built from switch the program, the others are
+    // uploaded with the settings block.
+    void renderSettingChanged(RenderSetting setting);
+    // Totals of the last frame read back while a ray cost view is on.
+    const RayCost& rayCost() const { return m_rayCost; };
 
   private:
+    constexpr static float INTERACTION_LOD_BIAS = 1.0f;
+    // Texture units, matching the sampler locations in cube-fs.glsl.
+    constexpr static int VOLUME_UNIT = 0;
+    constexpr static int TRANSFER_FUNCTION_UNIT = 1;
+    constexpr static int MAXIMUM_VOLUME_UNIT = 2;
+    constexpr static int BRICK_ATLAS_UNIT = 3;
+    constexpr static int PAGE_TABLE_UNIT = 4;
+    constexpr static int OCCUPANCY_UNIT = 5;
+    constexpr static int GRADIENT_UNIT = 6;
+    constexpr static int PRE_INTEGRATION_UNIT = 7;
+    constexpr static int RAY_ENTRY_UNIT = 8;
+    constexpr static int RAY_EXIT_UNIT = 9;
+    constexpr static int TEXTURE_UNITS = 10;
+    // Work group size of the compute raycaster, its tileOrigin uniform and
+    // the image unit it writes to.
+    constexpr static int TILE_SIZE = 8;
+    constexpr static int TILE_ORIGIN_LOCATION = 10;
+    constexpr static int OUTPUT_IMAGE_UNIT = 0;
+    // Shader storage binding of the RayStatistics block, next to the brick
+    // cache's usage buffer.
+    constexpr static int RAY_STATISTICS_BINDING = 1;
+    constexpr static int RAY_COST_BINDING = 2;
+    // Texture unit the output is read from when drawn over the framebuffer.
+    constexpr static int COMPOSITE_UNIT = TEXTURE_UNITS;
+    // Boolean render settings that select a program variant instead of
+    // being set as uniforms, so the ray loop does not branch on them.
+    constexpr static std::array<RenderSettingKey<bool>, 7> PERMUTATION_SETTINGS{
+        RenderSettingKeys::SPEC_OFF,   RenderSettingKeys::MAX_INT,
+        RenderSettingKeys::SLICE_MODEL, RenderSettingKeys::SLICE_SIDE,
+        RenderSettingKeys::HEAD_LIGHT, RenderSettingKeys::DEFAULT_SLICE_NR,
+        RenderSettingKeys::PRE_INTEGRATION};
+
+    // The uniform blocks of cube-vs.glsl and cube-fs.glsl in std140 layout,
+    // grouped by how often they change.
+    struct CameraBlock
+    {
+        GLfloat viewMatrix[16];
+        GLfloat modelMatrix[16];
+        GLfloat modelViewProjectionMatrix[16];
+        GLfloat rayOrigin[3];
+        GLfloat aspectRatio;
+        GLfloat viewportSize[2];
+        GLfloat focalLength;
+        GLfloat padding;
+    };
+    struct VolumeBlock
+    {
+        GLint width;
+        GLint height;
+        GLint depth;
+        GLfloat intensityScale;
+        GLfloat loadedDepth;
+        GLint mipLevels;
+        GLfloat lodBias;
+        GLint bricked;
+        GLint brickSize;
+        GLint emptySpaceSkipping;
+        GLint occupancyBlockSize;
+        GLint precomputedGradients;
+        GLfloat stepScale;
+        GLint samplingPass;
+        GLint proxyGeometry;
+        GLfloat stepOffset;
+    };
+    struct SceneBlock
+    {
+        GLfloat planeNormal[3];
+        GLfloat padding0;
+        GLfloat planePoint[3];
+        GLfloat padding1;
+        GLfloat lightPosition[3];
+        GLfloat padding2;
+        GLfloat cutPlanes[ClippingPlaneProperties::MAX_CUT_PLANES][4];
+        GLint cutPlaneCount;
+        GLint padding3[3];
+        GLfloat cropMinimum[3];
+        GLfloat padding4;
+        GLfloat cropMaximum[3];
+        GLfloat padding5;
+    };
+    struct SettingsBlock
+    {
+        GLfloat ambientInt;
+        GLfloat diffuseInt;
+        GLfloat specInt;
+        GLfloat specCoeff;
+        GLint sliceNr;
+        GLint padding[3];
+    };
+    struct CubeProgram
+    {
+        std::unique_ptr<QOpenGLShaderProgram> program;
+        int vertexPosition;
+    };
+
     void setUniforms();
     void setAttributes();
     void bindTextures();
+    void releaseTextures();
+    void updateProxyGeometry();
+    // Raycasts the tiles covering the volume into m_computeOutput and draws
+    // it over the framebuffer.
+    void dispatchRays();
+    QRect tileBounds(QSize size) const;
+    CubeProgram& cubeProgram();
+    void updateSettingsBlock();
+    void readRayStatistics();
+    // Reads back and clears the per-pixel counters of the last frame, and
+    // sizes the buffer to the viewport.
+    void readRayCost();
+    void releaseRayCost();
 
-    QOpenGLShaderProgram m_cubeProgram;
+    QByteArray m_vertexSource;
+    QByteArray m_fragmentSource;
+    // Program variants keyed by the #define block that selects them.
+    std::map<QByteArray, CubeProgram> m_cubePrograms;
+    CubeProgram* m_cubeProgram{nullptr};
+    QOpenGLShaderProgram m_compositeProgram;
+    std::unique_ptr<QOpenGLTexture> m_computeOutput;
+    UniformBuffer<CameraBlock> m_cameraBuffer{0};
+    UniformBuffer<VolumeBlock> m_volumeBuffer{1};
+    UniformBuffer<SceneBlock> m_sceneBuffer{2};
+    UniformBuffer<SettingsBlock> m_settingsBuffer{3};
+    // The inverses behind the ray origin and the light position, redone
+    // only when their matrices change.
+    QMatrix4x4 m_viewMatrix;
+    QVector3D m_rayOrigin;
+    QMatrix4x4 m_lightTransform;
+    QVector3D m_lightPosition;
     const CameraProperties& m_camera;
     const ViewPort& m_viewPort;
     const std::unique_ptr<ITextureStore>& m_textureStore;
     QOpenGLExtraFunctions& m_openGLExtra;
-    RenderSettings& m_renderSettings;
+    ProxyGeometryPass m_proxyGeometryPass;
+    const RenderSettings& m_renderSettings;
     LightRenderer& m_lightRenderer;
     const Plane& m_plane;
+    std::vector<Plane> m_cutPlanes;
+    CropBox m_cropBox;
+    // Generation of the render settings last picked up. A newer one that
+    // came without renderSettingChanged redoes both the program variant and
+    // the settings block.
+    unsigned int m_renderSettingsGeneration{0};
+    bool m_programChanged{true};
+    bool m_settingsBlockChanged{true};
+    bool m_interacting{false};
+    float m_stepScale{1.0f};
+    float m_stepOffset{0.0f};
+    int m_samplingPass{-1};
+    bool m_bricksPending{false};
+    // Whether rays are bounded by the proxy geometry this frame.
+    bool m_proxyGeometryEnabled{true};
+    bool m_useProxyGeometry{false};
+    bool m_collectRayStatistics{false};
+    GLuint m_rayStatisticsBuffer{0};
+    // Set while the buffer holds the counts of a frame not yet read back.
+    bool m_rayStatisticsPending{false};
+    qint64 m_rayStatisticsPixels{0};
+    RayStatistics m_rayStatistics;
+    // Four counters per pixel of the viewport, in rows.
+    GLuint m_rayCostBuffer{0};
+    qint64 m_rayCostBufferBytes{0};
+    bool m_rayCostPending{false};
+    RayCost m_rayCost;
 };
 #endif // VOLUMERENDERER_H
@@ -0,0 +1,12 @@
+#version 450
+
+// The pass being added, the same size as the accumulation buffer. Blending
+// with a constant weight turns it into the running mean of all passes.
+layout(location = 0) uniform sampler2D passTexture;
+
+out vec4 fragmentColor;
+
+void main(void)
+{
+    fragmentColor = texelFetch(passTexture, ivec2(gl_FragCoord.xy), 0);
+}
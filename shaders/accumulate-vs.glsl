@@ -0,0 +1,9 @@
+#version 450
+
+// A single triangle covering the viewport, placed from the vertex index so
+// that no vertex buffer is needed.
+void main(void)
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -1,41 +1,182 @@
 #version 450
 
+// The same source builds the fragment shader drawn over the cube and, with
+// COMPUTE_SHADER defined, the compute shader that raycasts the viewport in
+// tiles of TILE_SIZE x TILE_SIZE pixels into outputImage.
+#ifdef COMPUTE_SHADER
+#define TILE_SIZE 8
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+layout(rgba16f, binding = 0) uniform writeonly image2D outputImage;
+// Pixel of the first tile dispatched, the tiles outside the screen bounds of
+// the volume are left out.
+layout(location = 10) uniform ivec2 tileOrigin;
+#else
 out vec4 fragmentColor;
+#endif
 
 layout(location = 0) uniform sampler3D volumeTexture;
 layout(location = 1) uniform sampler1D transferFunction;
+layout(location = 2) uniform sampler3D maximumVolumeTexture;
+layout(location = 3) uniform sampler3D brickAtlas;
+layout(location = 4) uniform usampler3D pageTable;
+layout(location = 5) uniform usampler3D occupancyTexture;
+layout(location = 6) uniform sampler3D gradientTexture;
+layout(location = 7) uniform sampler2D preIntegrationTable;
+// Texture coordinates of the nearest front face and the farthest back face of
+// the proxy geometry under each pixel, zero alpha where there is none.
+layout(location = 8) uniform sampler2D rayEntryTexture;
+layout(location = 9) uniform sampler2D rayExitTexture;
+
+// One entry per brick, set to 1 whenever a ray samples the brick. Read back
+// and cleared by the brick cache every frame.
+layout(std430, binding = 0) buffer BrickUsage
+{
+    uint brickUsage[];
+};
+
+#ifdef RAY_STATISTICS
+// Totals over the rays of a frame, read back and cleared by VolumeRenderer
+// on the next frame. The sample count carries into sampleCountHigh, a frame
+// at 4K takes more than 2^32 samples.
+layout(std430, binding = 1) buffer RayStatistics
+{
+    uint rayCount;
+    uint sampleCount;
+    uint sampleCountHigh;
+    uint terminatedRayCount;
+};
 
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
-uniform mat4 modelViewProjectionMatrix;
-uniform vec2 viewportSize;
-uniform float aspectRatio;
-uniform float focalLength;
-uniform vec3 rayOrigin;
-
-uniform int width;
-uniform int height;
-uniform int depth;
-
-uniform vec3 planeNormal;
-uniform vec3 planePoint;
-
-uniform vec3 lightPosition;
+void addRayStatistics(uint samples, bool terminated)
+{
+    atomicAdd(rayCount, 1u);
+    if (atomicAdd(sampleCount, samples) > 0xFFFFFFFFu - samples)
+        atomicAdd(sampleCountHigh, 1u);
+    if (terminated)
+        atomicAdd(terminatedRayCount, 1u);
+}
+#endif
+
+// With RAY_COST defined as one of the views below, the counters of every ray
+// are written to rayCost, a row per line of the viewport, and the pixel shows
+// the selected counter in false colour instead of the volume.
+#ifdef RAY_COST
+#define RAY_COST_SAMPLES 1
+#define RAY_COST_SHADED_SAMPLES 2
+#define RAY_COST_FETCHES 3
+#define RAY_COST_EXIT 4
+// Why the ray stopped marching, 0 is left where no ray was cast.
+#define EXIT_OPACITY 1u
+#define EXIT_BOX 2u
+#define EXIT_CLIP 3u
+// Rays shortened by less than this, in texture space, still leave through the
+// faces of the volume. Far below the step length at any slice number.
+#define CLIP_EPSILON 1e-4
+// Fetches per sample shown at full scale.
+#define FETCHES_PER_SAMPLE 8.0
+
+// Samples, shaded samples, texture fetches and the exit of each pixel's ray.
+// Read back and cleared by VolumeRenderer on the next frame.
+layout(std430, binding = 2) buffer RayCost
+{
+    uvec4 rayCost[];
+};
+
+uint fetchCount = 0u;
+#define countFetches(n) fetchCount += uint(n)
+#else
+#define countFetches(n)
+#endif
+
+// Uniform blocks, filled by VolumeRenderer and only uploaded when their
+// contents change. Camera is shared with cube-vs.glsl.
+layout(std140, binding = 0) uniform Camera
+{
+    mat4 viewMatrix;
+    mat4 modelMatrix;
+    mat4 modelViewProjectionMatrix;
+    vec3 rayOrigin;
+    float aspectRatio;
+    vec2 viewportSize;
+    float focalLength;
+};
+
+layout(std140, binding = 1) uniform Volume
+{
+    int width;
+    int height;
+    int depth;
+    float intensityScale;
+    float loadedDepth;
+    int mipLevels;
+    float lodBias;
+    bool bricked;
+    int brickSize;
+    bool emptySpaceSkipping;
+    int occupancyBlockSize;
+    bool precomputedGradients;
+    float stepScale;
+    int samplingPass;
+    bool proxyGeometry;
+    float stepOffset;
+};
+
+#define MAX_CUT_PLANES 4
+
+// Planes and the crop box are in texture space. A cut plane keeps the side
+// its normal points to, where dot(plane.xyz, position) + plane.w >= 0.
+layout(std140, binding = 2) uniform Scene
+{
+    vec3 planeNormal;
+    vec3 planePoint;
+    vec3 lightPosition;
+    vec4 cutPlanes[MAX_CUT_PLANES];
+    int cutPlaneCount;
+    vec3 cropMinimum;
+    vec3 cropMaximum;
+};
 
 // Render Settings:
-uniform float ambientInt;
-uniform float diffuseInt;
-uniform float specInt;
-uniform float specCoeff;
-uniform bool specOff;
-uniform bool maxInt;
-uniform bool sliceModel;
-uniform bool sliceSide;
-uniform bool headLight;
-uniform bool defaultSliceNr;
-uniform int sliceNr;
+layout(std140, binding = 3) uniform Settings
+{
+    float ambientInt;
+    float diffuseInt;
+    float specInt;
+    float specCoeff;
+    int sliceNr;
+};
+
+// The boolean render settings are compiled into each program variant, so
+// that branches on them are resolved before the ray loop ever runs.
+// VolumeRenderer defines them right after the #version directive.
+#ifndef specOff
+#define specOff false
+#endif
+#ifndef maxInt
+#define maxInt false
+#endif
+#ifndef sliceModel
+#define sliceModel false
+#endif
+#ifndef sliceSide
+#define sliceSide false
+#endif
+#ifndef headLight
+#define headLight false
+#endif
+#ifndef defaultSliceNr
+#define defaultSliceNr false
+#endif
+#ifndef preIntegration
+#define preIntegration false
+#endif
 
 float stepLength = 0.01;
+// Window coordinates of the centre of the pixel the ray is cast through.
+vec2 pixelCenter = vec2(0.0);
+// Mip level sampled along the current ray.
+float rayLod = 0.0;
+// Last brick marked in brickUsage, to write each brick once per run.
+int lastBrick = -1;
 
 struct Ray
 {
@@ -51,6 +192,116 @@ struct AABB
 
 vec3 calculateGradient(vec3 volumePosition);
 
+// Looks the brick up in the page table and samples its atlas slot. Slots are
+// brickSize + 2 voxels wide to hold a one-voxel apron around the brick. Bricks
+// that are not resident are requested and, until they arrive, served from
+// the coarse copy of the volume held by volumeTexture in bricked mode.
+float sampleBricks(vec3 volumePosition)
+{
+    ivec3 brickCount = textureSize(pageTable, 0);
+    vec3 voxel = volumePosition * vec3(width, height, depth);
+    ivec3 brick = clamp(ivec3(floor(voxel / brickSize)), ivec3(0),
+                        brickCount - 1);
+    int index = brick.x + brickCount.x * (brick.y + brickCount.y * brick.z);
+    if (index != lastBrick)
+    {
+        brickUsage[index] = 1u;
+        lastBrick = index;
+    }
+
+    uvec4 entry = texelFetch(pageTable, brick, 0);
+    countFetches(2);
+    if (entry.w == 0u)
+        return textureLod(volumeTexture, volumePosition, 0.0).r;
+    vec3 atlasTexel = vec3(entry.xyz) * float(brickSize + 2) + 1.0 +
+                      (voxel - vec3(brick * brickSize));
+    return textureLod(brickAtlas, atlasTexel / vec3(textureSize(brickAtlas, 0)),
+                      0.0).r;
+}
+
+// The volume texture holds the samples as stored on disk, scaled here to the
+// normalized range the transfer function is defined over. Maximum intensity
+// projection reads the max-preserving pyramid, which starts at level 1.
+float sampleVolume(vec3 volumePosition)
+{
+    float value;
+    if (bricked)
+        return sampleBricks(volumePosition) * intensityScale;
+    if (maxInt && rayLod >= 1.0)
+        value = textureLod(maximumVolumeTexture, volumePosition, rayLod - 1.0).r;
+    else
+        value = textureLod(volumeTexture, volumePosition, rayLod).r;
+    countFetches(1);
+    return value * intensityScale;
+}
+
+// Picks the level whose voxels are about the size of a pixel where the ray
+// enters the volume, the closest and thus finest point along it.
+float selectLod(vec3 viewDirection, vec3 worldDirection, float tmin,
+                vec3 boxSize)
+{
+    float pixelAngle = 2.0 / (viewportSize.y * length(viewDirection));
+    float footprint = pixelAngle * length(worldDirection) * tmin;
+    vec3 voxelSize = boxSize / vec3(width, height, depth);
+    float voxel = min(voxelSize.x, min(voxelSize.y, voxelSize.z));
+    float lod = log2(max(footprint / voxel, 1.0)) + lodBias;
+    return clamp(floor(lod), 0.0, float(mipLevels - 1));
+}
+
+// Number of steps along the ray that stay within the block around position,
+// or 0 if the transfer function makes some of the block visible. The block's
+// occupancy at the finest level also holds for level 0 samples, while coarser
+// levels filter across block faces and use the occupancy dilated by a block,
+// which covers filters up to level 3.
+float emptyBlockSteps(vec3 position, vec3 stepVector)
+{
+    if (rayLod > 3.0)
+        return 0.0;
+    vec3 blockPosition =
+        position * vec3(width, height, depth) / float(occupancyBlockSize);
+    ivec3 block = ivec3(floor(blockPosition));
+    if (any(lessThan(block, ivec3(0))) ||
+        any(greaterThanEqual(block, textureSize(occupancyTexture, 0))))
+        return 0.0;
+    uvec2 occupied = texelFetch(occupancyTexture, block, 0).rg;
+    countFetches(1);
+    if ((rayLod == 0.0 ? occupied.r : occupied.g) != 0u)
+        return 0.0;
+
+    // One step of a 3D-DDA: the distance, in steps, to the face through which
+    // the ray leaves the block.
+    vec3 blockStep =
+        stepVector * vec3(width, height, depth) / float(occupancyBlockSize);
+    vec3 exitFace = floor(blockPosition) + step(0.0, blockStep);
+    vec3 stepsToFace = (exitFace - blockPosition) / blockStep;
+    return floor(min(stepsToFace.x, min(stepsToFace.y, stepsToFace.z))) + 1.0;
+}
+
+// Shortens the interval of p(s) = origin + s * direction to the part on the
+// kept side of the plane. An empty interval ends before it starts.
+vec2 clipToPlane(vec2 interval, vec3 origin, vec3 direction, vec4 plane)
+{
+    float distance = dot(plane.xyz, origin) + plane.w;
+    float rate = dot(plane.xyz, direction);
+    if (rate == 0.0)
+        return distance >= 0.0 ? interval : vec2(interval.x, interval.x);
+    float s = -distance / rate;
+    return rate > 0.0 ? vec2(max(interval.x, s), interval.y)
+                      : vec2(interval.x, min(interval.y, s));
+}
+
+vec2 clipToBox(vec2 interval, vec3 origin, vec3 direction, vec3 minimum,
+               vec3 maximum)
+{
+    vec3 invDirection = 1.0 / direction;
+    vec3 tMinimum = (minimum - origin) * invDirection;
+    vec3 tMaximum = (maximum - origin) * invDirection;
+    vec3 tNear = min(tMinimum, tMaximum);
+    vec3 tFar = max(tMinimum, tMaximum);
+    return vec2(max(interval.x, max(tNear.x, max(tNear.y, tNear.z))),
+                min(interval.y, min(tFar.x, min(tFar.y, tFar.z))));
+}
+
 // Slab-intersection method from
 // https://martinopilia.com/posts/2018/09/17/volume-raycasting.html
 void rayBoxIntersection(Ray ray, AABB box, out float tmin, out float tmax)
@@ -108,20 +359,79 @@ float calcDepth(vec3 pos)
     return (((far - near) * ndc_depth) + near + far) / 2.0;
 }
 
-void main(void)
+// Fraction of a step the first sample of the ray is moved back by. Passes
+// that share a coarse step between them each set their own stepOffset. A
+// per-pixel noise breaks up the wood grain of coarse steps, and the golden
+// ratio sequence over passes varies it from frame to frame.
+float samplingOffset()
+{
+    if (samplingPass < 0)
+        return stepOffset;
+    float noise = fract(
+        52.9829189 * fract(dot(pixelCenter, vec2(0.06711056, 0.00583715))));
+    return fract(stepOffset + noise + float(samplingPass) * 0.61803399);
+}
+
+// Nothing visible lies under pixels the proxy geometry does not cover.
+bool pixelCovered()
+{
+    if (!proxyGeometry)
+        return true;
+    countFetches(1);
+    return texelFetch(rayExitTexture, ivec2(pixelCenter), 0).a > 0.0;
+}
+
+#ifdef RAY_COST
+// Blue through green to red over [0, 1].
+vec3 falseColor(float value)
+{
+    value = clamp(value, 0.0, 1.0);
+    return clamp(vec3(1.5 - abs(4.0 * value - vec3(3.0, 2.0, 1.0))), 0.0, 1.0);
+}
+
+// Stores the counters of the ray through pixelCenter and returns the colour
+// of the selected view. Counts are scaled by the samples of a ray along the
+// diagonal of the volume.
+vec4 storeRayCost(uint samples, uint shadedSamples, uint exit)
+{
+    ivec2 pixel = ivec2(pixelCenter);
+    rayCost[pixel.y * int(viewportSize.x) + pixel.x] =
+        uvec4(samples, shadedSamples, fetchCount, exit);
+
+    float fullScale = sqrt(3.0) / stepLength;
+#if RAY_COST == RAY_COST_SAMPLES
+    return vec4(falseColor(float(samples) / fullScale), 1.0);
+#elif RAY_COST == RAY_COST_SHADED_SAMPLES
+    return vec4(falseColor(float(shadedSamples) / fullScale), 1.0);
+#elif RAY_COST == RAY_COST_FETCHES
+    return vec4(falseColor(float(fetchCount) / (fullScale * FETCHES_PER_SAMPLE)),
+                1.0);
+#else
+    return vec4(exit == EXIT_OPACITY ? 1.0 : 0.0, exit == EXIT_BOX ? 1.0 : 0.0,
+                exit == EXIT_CLIP ? 1.0 : 0.0, 1.0);
+#endif
+}
+#endif
+
+// Marches the ray through pixelCenter, returning its colour and the depth of
+// the first opaque sample, or of the end of the ray.
+vec4 castRay(out float depth)
 {
     // Ray-direction calculated by method from
     // https://martinopilia.com/posts/2018/09/17/volume-raycasting.html
 
-    int dSliceNr = int(textureSize(volumeTexture, 0).x);
+    // The full width, volumeTexture only holds a coarse copy when bricked.
+    int dSliceNr = width;
 
     stepLength =
-        defaultSliceNr ? 1.0f / float(dSliceNr) : 1.0f / float(sliceNr);
+        (defaultSliceNr ? 1.0f / float(dSliceNr) : 1.0f / float(sliceNr)) *
+        stepScale;
 
     vec3 rayDirection;
-    rayDirection.xy = 2.0 * gl_FragCoord.xy / viewportSize - 1.0;
+    rayDirection.xy = 2.0 * pixelCenter / viewportSize - 1.0;
     rayDirection.x *= aspectRatio;
     rayDirection.z = -focalLength;
+    vec3 viewRayDirection = rayDirection;
     rayDirection = (vec4(rayDirection, 0) * viewMatrix).xyz;
 
     float tmin, tmax;
@@ -130,84 +440,195 @@ void main(void)
     vec3 bottom = vec3(modelMatrix * vec4(-1, -1, -1, 0));
     AABB boundingBox = AABB(top, bottom);
     rayBoxIntersection(castingRay, boundingBox, tmin, tmax);
+    rayLod = selectLod(viewRayDirection, rayDirection, tmin, top - bottom);
 
     vec3 rayStart = (rayOrigin + rayDirection * tmin - bottom) / (top - bottom);
     vec3 rayEnd = (rayOrigin + rayDirection * tmax - bottom) / (top - bottom);
 
     vec3 ray = rayEnd - rayStart;
     float rayLength = length(ray);
-    vec3 stepVector = stepLength * ray / rayLength;
+    vec3 direction = ray / rayLength;
+
+    // Everything clipped away is cut off the ray before marching, so no
+    // samples are spent on it. Slabs beyond loadedDepth have not been
+    // uploaded yet.
+    vec2 interval = vec2(0.0, rayLength);
+    if (sliceModel)
+    {
+        vec3 normal = sliceSide ? -planeNormal : planeNormal;
+        interval = clipToPlane(interval, rayStart, direction,
+                               vec4(normal, -dot(normal, (planePoint + 1.0) * 0.5)));
+    }
+    for (int i = 0; i < cutPlaneCount; i++)
+    {
+        interval = clipToPlane(interval, rayStart, direction, cutPlanes[i]);
+    }
+    interval = clipToBox(interval, rayStart, direction, cropMinimum,
+                         vec3(cropMaximum.xy, min(cropMaximum.z, loadedDepth)));
+#ifdef RAY_COST
+    // Rays cut short, or cut away entirely, by the clipping above. The
+    // default crop box lies on the faces of the volume, where it may still
+    // shorten the ray by rounding.
+    bool clipping = sliceModel || cutPlaneCount > 0 ||
+                    any(greaterThan(cropMinimum, vec3(0.0))) ||
+                    any(lessThan(cropMaximum, vec3(1.0))) ||
+                    loadedDepth < 1.0;
+    bool clipped = clipping && (interval.y < rayLength - CLIP_EPSILON ||
+                                (interval.x >= interval.y && rayLength > 0.0));
+#endif
+    if (proxyGeometry)
+    {
+        // Without a front face the camera is inside the proxy geometry. The
+        // ray skips to its entry in whole steps, so the samples stay where
+        // they would be without it.
+        vec4 rayEntry = texelFetch(rayEntryTexture, ivec2(pixelCenter), 0);
+        vec4 rayExit = texelFetch(rayExitTexture, ivec2(pixelCenter), 0);
+        countFetches(2);
+        float entry = dot(rayEntry.xyz - rayStart, direction);
+        if (rayEntry.a > 0.0 && entry > interval.x)
+            interval.x += floor((entry - interval.x) / stepLength) * stepLength;
+        interval.y = min(interval.y, dot(rayExit.xyz - rayStart, direction));
+    }
+    rayStart += direction * interval.x;
+    rayLength = interval.y - interval.x;
+
+    vec3 stepVector = stepLength * direction;
 
-    rayStart += stepVector;
+    rayStart += stepVector * (1.0 - samplingOffset());
 
     vec3 position = rayStart;
     float maxIntensity = 0.0f;
+    // Intensity at the front of the segment ending at the current sample,
+    // negative where there is no previous sample to pair with.
+    float frontIntensity = -1.0;
 
     vec4 color = vec4(0.0);
+    uint samples = 0u;
+    uint shadedSamples = 0u;
+    bool terminated = false;
 
     while (rayLength > 0)
     {
-        float intensity = texture(volumeTexture, position).r;
-        bool skip = false;
-
-        if(sliceModel) {
-                float num = dot(planeNormal.xyz, (position-(planePoint+1.0)*0.5));
-                if(sliceSide) {
-                    skip = (num >= 0.0); 
-                } else {
-                    skip = (num <= 0.0);
-                }
+        // Maximum intensity projection keeps the maximum of transparent
+        // samples as well, so it cannot leap over them.
+        if (emptySpaceSkipping && !maxInt)
+        {
+            float steps = emptyBlockSteps(position, stepVector);
+            if (steps > 0.0)
+            {
+                rayLength -= steps * stepLength;
+                position += steps * stepVector;
+                frontIntensity = -1.0;
+                continue;
+            }
         }
 
+        float intensity = sampleVolume(position);
+        samples++;
 
-        if (maxInt && !skip)
+        if (maxInt)
         {
             maxIntensity = max(intensity, maxIntensity);
         }
         else
         {
-            vec3 gradient = calculateGradient(position);
-            vec4 src = texture(transferFunction, intensity);
+            // The pre-integrated table holds the mean opacity of the segment
+            // per voxel of length, independent of the step length.
+            vec4 src = preIntegration
+                           ? texture(preIntegrationTable,
+                                     vec2(frontIntensity < 0.0 ? intensity
+                                                               : frontIntensity,
+                                          intensity))
+                           : texture(transferFunction, intensity);
+            countFetches(1);
             vec3 viewDir = rayOrigin - position;
             vec3 lightDir =
                 (headLight) ? rayOrigin : (lightPosition - position);
 
-            if (src.a > 0.0 && !skip)
+            if (src.a > 0.0)
             {
-
+                shadedSamples++;
                 src.rgb =
                     ShadeBlinnPhong(position, -lightDir, viewDir, src.rgb);
 
-                src.a =
-                    defaultSliceNr
-                        ? 1.0 - exp(-src.a * rayLength)
-                        : 1.0 - exp(-src.a * rayLength * dSliceNr / sliceNr);
+                // stepLength * dSliceNr is the step in voxels, 1 at the
+                // default quality. It depends on the step alone, so clipping
+                // the ray does not change the opacity of what is left of it.
+                src.a = 1.0 - exp(-src.a * stepLength * dSliceNr);
                 src.rgb = src.rgb * src.a;
                 color = color + (1.0 - color.a) * src;
 
                 if (color.a > 0.99)
                 {
-                    gl_FragDepth = calcDepth(position);
+                    terminated = true;
                     break;
                 }
             }
         }
 
+        frontIntensity = intensity;
         rayLength -= stepLength;
         position += stepVector;
-        gl_FragDepth = calcDepth(position);
     }
+    depth = calcDepth(position);
 
     if (maxInt)
     {
         color = texture(transferFunction, maxIntensity);
+        countFetches(1);
     }
+#ifdef RAY_STATISTICS
+    addRayStatistics(samples, terminated);
+#endif
+#ifdef RAY_COST
+    color = storeRayCost(samples, shadedSamples,
+                         terminated ? EXIT_OPACITY
+                                    : (clipped ? EXIT_CLIP : EXIT_BOX));
+#endif
+
+    return color;
+}
 
-    fragmentColor = color;
+#ifdef COMPUTE_SHADER
+void main(void)
+{
+    ivec2 pixel = tileOrigin + ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, ivec2(viewportSize))))
+        return;
+    pixelCenter = vec2(pixel) + 0.5;
+    vec4 color = vec4(0.0);
+    if (pixelCovered())
+    {
+        float depth;
+        color = castRay(depth);
+    }
+    imageStore(outputImage, pixel, color);
+}
+#else
+void main(void)
+{
+    pixelCenter = gl_FragCoord.xy;
+    if (!pixelCovered())
+        discard;
+    // Written once, at the first opaque sample or where the ray ran out.
+    float depth;
+    fragmentColor = castRay(depth);
+    gl_FragDepth = depth;
 }
+#endif
 
+// Precomputed gradients hold the direction in RGB and a magnitude in A that
+// is zero only where the gradient vanishes. Shading normalizes the result, so
+// the direction alone is enough.
 vec3 calculateGradient(vec3 volumePosition)
 {
+    if (precomputedGradients)
+    {
+        vec4 texel = textureLod(gradientTexture, volumePosition, rayLod);
+        countFetches(1);
+        return texel.a > 0.0 ? texel.rgb * 2.0 - 1.0 : vec3(0.0);
+    }
+
     vec3 gradient = vec3(0.0f);
     if (width == 0 || height == 0 || depth == 0)
     {
@@ -217,18 +638,19 @@ vec3 calculateGradient(vec3 volumePosition)
     float x = volumePosition.x;
     float y = volumePosition.y;
     float z = volumePosition.z;
-    float dx = 1.0f / width;
-    float dy = 1.0f / height;
-    float dz = 1.0f / depth;
+    float voxels = exp2(rayLod);
+    float dx = voxels / width;
+    float dy = voxels / height;
+    float dz = voxels / depth;
 
     gradient.x = 1.0f / (2 * dx) *
-                 (texture(volumeTexture, vec3(x + dx, y, z)).r -
-                  texture(volumeTexture, vec3(x - dx, y, z)).r);
+                 (sampleVolume(vec3(x + dx, y, z)) -
+                  sampleVolume(vec3(x - dx, y, z)));
     gradient.y = 1.0f / (2 * dy) *
-                 (texture(volumeTexture, vec3(x, y + dy, z)).r -
-                  texture(volumeTexture, vec3(x, y - dy, z)).r);
+                 (sampleVolume(vec3(x, y + dy, z)) -
+                  sampleVolume(vec3(x, y - dy, z)));
     gradient.z = 1.0f / (2 * dz) *
-                 (texture(volumeTexture, vec3(x, y, z + dz)).r -
-                  texture(volumeTexture, vec3(x, y, z - dz)).r);
+                 (sampleVolume(vec3(x, y, z + dz)) -
+                  sampleVolume(vec3(x, y, z - dz)));
     return gradient;
 }
@@ -1,7 +1,16 @@
 #version 450
 
 uniform vec4 clippingPlaneEquation;
-uniform mat4 modelViewProjectionMatrix;
+layout(std140, binding = 0) uniform Camera
+{
+    mat4 viewMatrix;
+    mat4 modelMatrix;
+    mat4 modelViewProjectionMatrix;
+    vec3 rayOrigin;
+    float aspectRatio;
+    vec2 viewportSize;
+    float focalLength;
+};
 
 in vec3 vertexPosition;
 
@@ -0,0 +1,12 @@
+#version 450
+
+in vec3 texturePosition;
+
+// The texture coordinates where the ray through the pixel crosses the proxy
+// geometry. Alpha tells covered pixels apart from the cleared ones.
+out vec4 fragmentColor;
+
+void main(void)
+{
+    fragmentColor = vec4(texturePosition, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 450
+
+// Shared with cube-vs.glsl and cube-fs.glsl, filled by VolumeRenderer.
+layout(std140, binding = 0) uniform Camera
+{
+    mat4 viewMatrix;
+    mat4 modelMatrix;
+    mat4 modelViewProjectionMatrix;
+    vec3 rayOrigin;
+    float aspectRatio;
+    vec2 viewportSize;
+    float focalLength;
+};
+
+in vec3 vertexPosition;
+
+out vec3 texturePosition;
+
+void main(void)
+{
+    gl_Position = modelViewProjectionMatrix * vec4(vertexPosition, 1.0);
+    texturePosition = (vertexPosition + 1.0) * 0.5;
+}
@@ -5,10 +5,14 @@ out vec4 fragmentColor;
 
 layout(location = 0) uniform sampler3D volumeTexture;
 layout(location = 1) uniform sampler1D transferFunction;
+uniform float intensityScale;
+uniform float loadedDepth;
 
 void main(void)
 {
-    float volumeValue = texture(volumeTexture, texCoords).r;
+    if (texCoords.z > loadedDepth)
+        discard;
+    float volumeValue = texture(volumeTexture, texCoords).r * intensityScale;
     vec4 color = texture(transferFunction, volumeValue);
     fragmentColor = color;
 }
@@ -0,0 +1,329 @@
+#include "syntheticvolume.h"
+
+#include "volumedata.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numbers>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace
+{
+constexpr float PI = std::numbers::pi_v<float>;
+constexpr int SHELLS = 4;
+constexpr int NOISE_WAVES = 8;
+// Marschner and Lobb's frequency and amplitude of the radial ripple.
+constexpr float ML_FREQUENCY = 6.0f;
+constexpr float ML_ALPHA = 0.25f;
+constexpr int SPARSE_BALLS = 16;
+constexpr float SPARSE_RADIUS = 0.1f;
+constexpr qint64 SLAB_BYTES = 64 * 1024 * 1024;
+
+const std::pair<SyntheticVolume::Content, QString> CONTENT_NAMES[]{
+    {SyntheticVolume::Content::Sphere, "sphere"},
+    {SyntheticVolume::Content::Shells, "shells"},
+    {SyntheticVolume::Content::Noise, "noise"},
+    {SyntheticVolume::Content::MarschnerLobb, "marschner-lobb"},
+    {SyntheticVolume::Content::Sparse, "sparse"}};
+
+// A linear falloff from 1 at the centre to 0 at radius.
+float cone(const QVector3D& offset, float radius)
+{
+    return std::max(0.0f, 1.0f - offset.length() / radius);
+}
+
+QVector3D coneGradient(const QVector3D& offset, float radius)
+{
+    const float distance = offset.length();
+    if (distance >= radius || distance == 0.0f)
+        return QVector3D();
+    return -offset / (distance * radius);
+}
+} // namespace
+
+SyntheticVolume::SyntheticVolume(const Parameters& parameters)
+    : m_parameters{parameters}
+{
+    m_scale = QVector3D(parameters.width, parameters.height, parameters.depth) *
+              parameters.spacing;
+    m_scale /= std::max({m_scale.x(), m_scale.y(), m_scale.z()});
+
+    std::mt19937 random(parameters.seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    auto randomDirection = [&]() {
+        QVector3D direction;
+        do
+        {
+            direction = QVector3D(unit(random), unit(random), unit(random));
+        } while (direction.lengthSquared() > 1.0f ||
+                 direction.lengthSquared() < 1.0e-4f);
+        return direction.normalized();
+    };
+    if (parameters.content == Content::Noise)
+    {
+        // One to four periods across the box.
+        for (int i = 0; i < NOISE_WAVES; i++)
+        {
+            const float frequency = PI * (2.5f + 1.5f * unit(random));
+            m_waves.push_back({randomDirection() * frequency,
+                               PI * unit(random)});
+        }
+    }
+    if (parameters.content == Content::Sparse)
+    {
+        const QVector3D inner = m_scale - QVector3D(1, 1, 1) * SPARSE_RADIUS;
+        for (int i = 0; i < SPARSE_BALLS; i++)
+        {
+            m_balls.push_back(
+                {QVector3D(unit(random), unit(random), unit(random)) * inner,
+                 SPARSE_RADIUS});
+        }
+    }
+}
+
+std::optional<SyntheticVolume::Content>
+SyntheticVolume::contentFromName(const QString& name)
+{
+    for (const auto& [content, contentName] : CONTENT_NAMES)
+    {
+        if (name == contentName)
+            return content;
+    }
+    return std::nullopt;
+}
+
+QString SyntheticVolume::contentName(Content content)
+{
+    for (const auto& [candidate, name] : CONTENT_NAMES)
+    {
+        if (candidate == content)
+            return name;
+    }
+    return QString();
+}
+
+QVector3D SyntheticVolume::voxelCentre(int x, int y, int z) const
+{
+    return QVector3D((x + 0.5f) * 2.0f / m_parameters.width - 1.0f,
+                     (y + 0.5f) * 2.0f / m_parameters.height - 1.0f,
+                     (z + 0.5f) * 2.0f / m_parameters.depth - 1.0f);
+}
+
+float SyntheticVolume::value(const QVector3D& point) const
+{
+    // Everything but the phantom is laid out in the box itself.
+    const QVector3D q = point * m_scale;
+    const float radius =
+        m_parameters.radius *
+        std::min({m_scale.x(), m_scale.y(), m_scale.z()});
+    switch (m_parameters.content)
+    {
+    case Content::Sphere:
+        return cone(q, radius);
+    case Content::Shells: {
+        const float distance = q.length();
+        if (distance >= radius)
+            return 0.0f;
+        return 0.5f - 0.5f * std::cos(2.0f * PI * SHELLS * distance / radius);
+    }
+    case Content::Noise: {
+        float sum = 0.0f;
+        for (const Wave& wave : m_waves)
+            sum += std::cos(QVector3D::dotProduct(wave.direction, q) + wave.phase);
+        return 0.5f + 0.5f * sum / NOISE_WAVES;
+    }
+    case Content::MarschnerLobb: {
+        const float r = std::hypot(point.x(), point.y());
+        const float ripple =
+            std::cos(2.0f * PI * ML_FREQUENCY * std::cos(PI * r / 2.0f));
+        return (1.0f - std::sin(PI * point.z() / 2.0f) +
+                ML_ALPHA * (1.0f + ripple)) /
+               (2.0f * (1.0f + ML_ALPHA));
+    }
+    case Content::Sparse: {
+        float maximum = 0.0f;
+        for (const Ball& ball : m_balls)
+            maximum = std::max(maximum, cone(q - ball.centre, ball.radius));
+        return maximum;
+    }
+    }
+    return 0.0f;
+}
+
+QVector3D SyntheticVolume::valueGradient(const QVector3D& point) const
+{
+    // Gradients in the box are scaled back to the [-1, 1] coordinates of
+    // point.
+    const QVector3D q = point * m_scale;
+    const float radius =
+        m_parameters.radius *
+        std::min({m_scale.x(), m_scale.y(), m_scale.z()});
+    switch (m_parameters.content)
+    {
+    case Content::Sphere:
+        return coneGradient(q, radius) * m_scale;
+    case Content::Shells: {
+        const float distance = q.length();
+        if (distance >= radius || distance == 0.0f)
+            return QVector3D();
+        const float frequency = 2.0f * PI * SHELLS / radius;
+        return 0.5f * frequency * std::sin(frequency * distance) * q /
+               distance * m_scale;
+    }
+    case Content::Noise: {
+        QVector3D sum;
+        for (const Wave& wave : m_waves)
+        {
+            sum -= std::sin(QVector3D::dotProduct(wave.direction, q) +
+                            wave.phase) *
+                   wave.direction;
+        }
+        return 0.5f * sum / NOISE_WAVES * m_scale;
+    }
+    case Content::MarschnerLobb: {
+        const float normalization = 2.0f * (1.0f + ML_ALPHA);
+        const float r = std::hypot(point.x(), point.y());
+        const float dz = -PI / 2.0f * std::cos(PI * point.z() / 2.0f);
+        if (r == 0.0f)
+            return QVector3D(0, 0, dz / normalization);
+        const float dr =
+            ML_ALPHA *
+            std::sin(2.0f * PI * ML_FREQUENCY * std::cos(PI * r / 2.0f)) *
+            2.0f * PI * ML_FREQUENCY * std::sin(PI * r / 2.0f) * PI / 2.0f;
+        return QVector3D(dr * point.x() / r, dr * point.y() / r, dz) /
+               normalization;
+    }
+    case Content::Sparse: {
+        // The gradient of whichever ball the maximum came from.
+        float maximum = 0.0f;
+        QVector3D gradient;
+        for (const Ball& ball : m_balls)
+        {
+            const float ballValue = cone(q - ball.centre, ball.radius);
+            if (ballValue > maximum)
+            {
+                maximum = ballValue;
+                gradient = coneGradient(q - ball.centre, ball.radius);
+            }
+        }
+        return gradient * m_scale;
+    }
+    }
+    return QVector3D();
+}
+
+unsigned short SyntheticVolume::voxel(int x, int y, int z) const
+{
+    const float intensity = std::clamp(value(voxelCentre(x, y, z)), 0.0f, 1.0f);
+    return static_cast<unsigned short>(
+        std::lround(intensity * MAXIMUM_INTENSITY));
+}
+
+QVector3D SyntheticVolume::gradient(int x, int y, int z) const
+{
+    // A voxel step covers 2 / size of the [-1, 1] coordinates.
+    return valueGradient(voxelCentre(x, y, z)) * MAXIMUM_INTENSITY * 2.0f /
+           QVector3D(m_parameters.width, m_parameters.height,
+                     m_parameters.depth);
+}
+
+std::optional<std::vector<qint64>>
+SyntheticVolume::write(const QString& fileName) const
+{
+    const int width = m_parameters.width;
+    const int height = m_parameters.height;
+    const int depth = m_parameters.depth;
+
+    QString iniFileName = fileName;
+    iniFileName.chop(3);
+    iniFileName.append("ini");
+    QFile iniFile(iniFileName);
+    if (!iniFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "Unable to write" << iniFileName;
+        return std::nullopt;
+    }
+    QTextStream ini(&iniFile);
+    ini << "[DatFile]\n"
+        << "oldDat Spacing X=" << m_parameters.spacing.x() << "\n"
+        << "oldDat Spacing Y=" << m_parameters.spacing.y() << "\n"
+        << "oldDat Spacing Z=" << m_parameters.spacing.z() << "\n";
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Unable to write" << fileName;
+        return std::nullopt;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << static_cast<unsigned short>(width)
+           << static_cast<unsigned short>(height)
+           << static_cast<unsigned short>(depth);
+
+    const qint64 sliceVoxels = static_cast<qint64>(width) * height;
+    const int slabSlices = static_cast<int>(std::clamp<qint64>(
+        SLAB_BYTES / (sliceVoxels * static_cast<qint64>(sizeof(unsigned short))),
+        1, depth));
+    std::vector<unsigned short> slab(slabSlices * sliceVoxels);
+    // Rows are handed out in chunks, each counting into a histogram of its
+    // own, so that wide slices still spread over all cores.
+    const int chunkCount = static_cast<int>(
+        std::max(1u, std::thread::hardware_concurrency()) * 4);
+    std::vector<std::vector<qint64>> chunkHistograms(
+        chunkCount, std::vector<qint64>(VolumeData::HISTOGRAM_BINS, 0));
+    std::vector<int> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), 0);
+
+    for (int first = 0; first < depth; first += slabSlices)
+    {
+        const int slices = std::min(slabSlices, depth - first);
+        const int rows = slices * height;
+        std::for_each(
+            std::execution::par, chunks.begin(), chunks.end(), [&](int chunk) {
+                std::vector<qint64>& histogram = chunkHistograms[chunk];
+                const int end = static_cast<int>(
+                    static_cast<qint64>(rows) * (chunk + 1) / chunkCount);
+                for (int row = static_cast<int>(static_cast<qint64>(rows) *
+                                                chunk / chunkCount);
+                     row < end; row++)
+                {
+                    const int y = row % height;
+                    const int z = first + row / height;
+                    unsigned short* out =
+                        slab.data() + static_cast<qint64>(row) * width;
+                    for (int x = 0; x < width; x++)
+                    {
+                        const unsigned short intensity = voxel(x, y, z);
+                        histogram[intensity]++;
+                        out[x] = qToLittleEndian(intensity);
+                    }
+                }
+            });
+        const qint64 bytes =
+            slices * sliceVoxels * static_cast<qint64>(sizeof(unsigned short));
+        if (file.write(reinterpret_cast<const char*>(slab.data()), bytes) !=
+            bytes)
+        {
+            qDebug() << "Unable to write" << fileName;
+            return std::nullopt;
+        }
+    }
+
+    std::vector<qint64> histogram(VolumeData::HISTOGRAM_BINS, 0);
+    for (const auto& chunkHistogram : chunkHistograms)
+    {
+        std::transform(histogram.begin(), histogram.end(),
+                       chunkHistogram.begin(), histogram.begin(),
+                       std::plus<>());
+    }
+    return histogram;
+}
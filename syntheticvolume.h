@@ -0,0 +1,87 @@
+#ifndef SYNTHETICVOLUME_H
+#define SYNTHETICVOLUME_H
+
+#include <QString>
+#include <QVector3D>
+#include <optional>
+#include <vector>
+
+// Analytic volumes for tests and benchmarks, written as .dat/.ini pairs. The
+// content is defined over the box the volume is drawn in, so spheres stay
+// round under anisotropic spacing, and is known exactly at every voxel along
+// with its gradient, which makes it ground truth for the loader, histogram and
+// gradient stages.
+class SyntheticVolume
+{
+  public:
+    enum class Content
+    {
+        // A ball fading linearly from full intensity at its centre.
+        Sphere,
+        // Concentric shells, alternating between empty and full intensity.
+        Shells,
+        // A sum of plane waves of random direction, frequency and phase.
+        Noise,
+        // The Marschner-Lobb phantom, whose fine radial ripple shows how
+        // well a renderer reconstructs the signal between samples.
+        MarschnerLobb,
+        // A few small balls scattered through an otherwise empty volume.
+        Sparse
+    };
+    struct Parameters
+    {
+        Content content{Content::Sphere};
+        int width{128};
+        int height{128};
+        int depth{128};
+        QVector3D spacing{1, 1, 1};
+        // Radius of the Sphere and Shells content, relative to the shortest
+        // half extent of the box.
+        float radius{0.9f};
+        // Seeds the random parts of Noise and Sparse.
+        unsigned int seed{1};
+    };
+    constexpr static int MAXIMUM_INTENSITY = 4095;
+
+    explicit SyntheticVolume(const Parameters& parameters);
+
+    static std::optional<Content> contentFromName(const QString& name);
+    static QString contentName(Content content);
+
+    unsigned short voxel(int x, int y, int z) const;
+    // The exact gradient at the centre of a voxel, in intensity per voxel
+    // along each axis.
+    QVector3D gradient(int x, int y, int z) const;
+
+    // Writes the volume to fileName and its spacing to the .ini file next to
+    // it. Slabs of slices are computed on all cores and written one after
+    // another, so volumes far larger than memory can be written. Returns the
+    // number of voxels of every intensity, or nothing if a file could not be
+    // written.
+    std::optional<std::vector<qint64>> write(const QString& fileName) const;
+
+  private:
+    struct Wave
+    {
+        QVector3D direction;
+        float phase;
+    };
+    struct Ball
+    {
+        QVector3D centre;
+        float radius;
+    };
+    // The content and its gradient at a point of the box, both in units of
+    // the full intensity range.
+    float value(const QVector3D& point) const;
+    QVector3D valueGradient(const QVector3D& point) const;
+    QVector3D voxelCentre(int x, int y, int z) const;
+
+    Parameters m_parameters;
+    // Half extents of the box, the longest being 1.
+    QVector3D m_scale;
+    std::vector<Wave> m_waves;
+    std::vector<Ball> m_balls;
+};
+
+#endif // SYNTHETICVOLUME_H
@@ -0,0 +1,58 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../brickcache.h"
+
+#include "../vendor/doctest/doctest.h"
+
+TEST_CASE("Requested bricks fill the free slots first")
+{
+    BrickResidency residency(8, 2);
+    std::vector<unsigned int> usage{1, 0, 1, 0, 0, 0, 0, 0};
+    auto assignments = residency.update(usage, 64);
+    REQUIRE(assignments.size() == 2);
+    CHECK(assignments[0].evictedBrick == BrickResidency::NO_BRICK);
+    CHECK(assignments[1].evictedBrick == BrickResidency::NO_BRICK);
+    CHECK(residency.slotOf(0) != BrickResidency::NO_BRICK);
+    CHECK(residency.slotOf(2) != BrickResidency::NO_BRICK);
+    CHECK(residency.slotOf(0) != residency.slotOf(2));
+    CHECK(!residency.requestsPending());
+}
+
+TEST_CASE("The least recently used brick is evicted")
+{
+    BrickResidency residency(8, 2);
+    residency.update(std::vector<unsigned int>{1, 0, 0, 0, 0, 0, 0, 0}, 64);
+    residency.update(std::vector<unsigned int>{0, 1, 0, 0, 0, 0, 0, 0}, 64);
+    const int slot = residency.slotOf(0);
+    auto assignments =
+        residency.update(std::vector<unsigned int>{0, 0, 1, 0, 0, 0, 0, 0}, 64);
+    REQUIRE(assignments.size() == 1);
+    CHECK(assignments[0].evictedBrick == 0);
+    CHECK(assignments[0].slot == slot);
+    CHECK(residency.slotOf(0) == BrickResidency::NO_BRICK);
+    CHECK(residency.slotOf(1) != BrickResidency::NO_BRICK);
+}
+
+TEST_CASE("Bricks used in the current frame are never evicted")
+{
+    BrickResidency residency(8, 2);
+    residency.update(std::vector<unsigned int>{1, 1, 0, 0, 0, 0, 0, 0}, 64);
+    auto assignments =
+        residency.update(std::vector<unsigned int>{1, 1, 1, 0, 0, 0, 0, 0}, 64);
+    CHECK(assignments.empty());
+    CHECK(residency.slotOf(0) != BrickResidency::NO_BRICK);
+    CHECK(residency.slotOf(1) != BrickResidency::NO_BRICK);
+    CHECK(residency.requestsPending());
+}
+
+TEST_CASE("Loads per update are capped")
+{
+    BrickResidency residency(8, 8);
+    std::vector<unsigned int> usage(8, 1);
+    CHECK(residency.update(usage, 3).size() == 3);
+    CHECK(residency.requestsPending());
+    CHECK(residency.update(usage, 3).size() == 3);
+    CHECK(residency.update(usage, 3).size() == 2);
+    CHECK(!residency.requestsPending());
+    CHECK(residency.update(usage, 3).empty());
+}
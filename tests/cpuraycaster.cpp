@@ -0,0 +1,166 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../renderers/cpuraycaster.h"
+#include "testvolumes.h"
+
+#include "../vendor/doctest/doctest.h"
+
+#include <QTemporaryDir>
+#include <cmath>
+
+namespace
+{
+constexpr int SIZE = 32;
+const QSize IMAGE_SIZE(192, 128);
+const QColor BACKGROUND = QColor::fromRgbF(0.95f, 0.95f, 0.95f);
+
+// A ball that is brightest at its centre and fades out to nothing at a third
+// of the volume's size.
+std::shared_ptr<const VolumeData> ballVolume(const QTemporaryDir& dir)
+{
+    const QString fileName = dir.filePath("ball.dat");
+    writeSphereVolume(fileName, SIZE, 2.0f / 3.0f);
+    return VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+}
+
+// Transparent below a quarter of the range, then opaque and turning from
+// blue to red.
+std::vector<float> rampTransferFunction()
+{
+    const int entries = 4096;
+    std::vector<float> transferFunction;
+    for (int i = 0; i < entries; i++)
+    {
+        const float t = i / static_cast<float>(entries - 1);
+        transferFunction.insert(transferFunction.end(),
+                                {t, 0.5f, 1.0f - t, t > 0.25f ? t : 0.0f});
+    }
+    return transferFunction;
+}
+
+CameraProperties frontCamera()
+{
+    CameraProperties camera;
+    camera.moveCamera(QVector3D(0, 0, -4));
+    return camera;
+}
+
+QRgb centre(const QImage& image)
+{
+    return image.pixel(image.width() / 2, image.height() / 2);
+}
+} // namespace
+
+TEST_CASE("Only rays through visible voxels leave the background")
+{
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+    const QImage image =
+        raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE);
+
+    REQUIRE(image.size() == IMAGE_SIZE);
+    CHECK(image.pixel(0, 0) == BACKGROUND.rgb());
+    CHECK(image.pixel(IMAGE_SIZE.width() - 1, IMAGE_SIZE.height() - 1) ==
+          BACKGROUND.rgb());
+    CHECK(centre(image) != BACKGROUND.rgb());
+}
+
+TEST_CASE("AVX2 and scalar samples give the same image")
+{
+    if (!CpuRaycaster::avx2Supported())
+        return;
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+    raycaster.setLightPosition(QVector3D(2, 2, 2));
+
+    raycaster.setInstructions(CpuRaycaster::Instructions::Scalar);
+    const QImage scalar =
+        raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE);
+    raycaster.setInstructions(CpuRaycaster::Instructions::Avx2);
+    const QImage avx2 =
+        raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE);
+
+    // Fused multiply-adds may round differently in the last bit.
+    int difference = 0;
+    for (int y = 0; y < IMAGE_SIZE.height(); y++)
+        for (int x = 0; x < IMAGE_SIZE.width(); x++)
+        {
+            const QRgb a = scalar.pixel(x, y);
+            const QRgb b = avx2.pixel(x, y);
+            difference = std::max({difference, std::abs(qRed(a) - qRed(b)),
+                                   std::abs(qGreen(a) - qGreen(b)),
+                                   std::abs(qBlue(a) - qBlue(b))});
+        }
+    CHECK(difference <= 1);
+}
+
+TEST_CASE("The image does not depend on how tiles are spread over threads")
+{
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+
+    raycaster.setThreadCount(1);
+    const QImage single =
+        raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE);
+    raycaster.setThreadCount(7);
+    CHECK(raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE) ==
+          single);
+}
+
+TEST_CASE("Maximum intensity projection shows the brightest sample")
+{
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+    RenderSettings settings;
+    settings.maxInt = true;
+    const QColor colour(
+        centre(raycaster.render(frontCamera(), settings, IMAGE_SIZE)));
+
+    // The centre of the ball is nearly white in the volume, so close to the
+    // red end of the ramp at close to full opacity.
+    CHECK(colour.redF() > 0.9f);
+    CHECK(colour.blueF() < 0.1f);
+}
+
+TEST_CASE("The slicing plane removes the half its normal points away from")
+{
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+    raycaster.setSlicingPlane(Plane(QVector4D(1, 0, 0, 0)));
+    RenderSettings settings;
+    settings.sliceModel = true;
+    const QImage image = raycaster.render(frontCamera(), settings, IMAGE_SIZE);
+
+    const int y = IMAGE_SIZE.height() / 2;
+    CHECK(image.pixel(IMAGE_SIZE.width() / 2 - 4, y) == BACKGROUND.rgb());
+    CHECK(image.pixel(IMAGE_SIZE.width() / 2 + 4, y) != BACKGROUND.rgb());
+
+    settings.sliceSide = true;
+    const QImage swapped =
+        raycaster.render(frontCamera(), settings, IMAGE_SIZE);
+    CHECK(swapped.pixel(IMAGE_SIZE.width() / 2 - 4, y) != BACKGROUND.rgb());
+    CHECK(swapped.pixel(IMAGE_SIZE.width() / 2 + 4, y) == BACKGROUND.rgb());
+}
+
+TEST_CASE("Cropping away empty space leaves the image unchanged")
+{
+    QTemporaryDir dir;
+    CpuRaycaster raycaster(ballVolume(dir));
+    raycaster.setTransferFunction(rampTransferFunction());
+    const QImage whole =
+        raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE);
+
+    // The visible part of the ball ends short of the sides of the box, so
+    // only the empty ends of the rays leaving through them are cut off.
+    CropBox cropBox;
+    cropBox.minimum = QVector3D(-0.6f, -0.6f, -1.0f);
+    cropBox.maximum = QVector3D(0.6f, 0.6f, 1.0f);
+    raycaster.setCropBox(cropBox);
+    CHECK(raycaster.render(frontCamera(), RenderSettings{}, IMAGE_SIZE) ==
+          whole);
+}
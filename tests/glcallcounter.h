@@ -0,0 +1,97 @@
+#ifndef GLCALLCOUNTER_H
+#define GLCALLCOUNTER_H
+
+#include <QOpenGLExtraFunctions>
+#include <QtGlobal>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Counts the OpenGL calls made on the current context while it is alive.
+//
+// Every QOpenGLFunctions and QOpenGLExtraFunctions of a context calls through
+// one table of entry points, which QOpenGLShaderProgram, QOpenGLBuffer,
+// QOpenGLTexture and QOpenGLFramebufferObject use as well. The counter swaps
+// each entry for a wrapper that counts the call and forwards it, and puts
+// the entries back when it is destroyed. Calls made to the GL library
+// directly bypass the table and are not counted, so the renderers make
+// theirs through QOpenGLFunctions.
+class GLCallCounter : private QOpenGLExtraFunctions
+{
+  public:
+    GLCallCounter()
+    {
+        initializeOpenGLFunctions();
+        s_calls = 0;
+        auto* extra = static_cast<QOpenGLExtraFunctionsPrivate*>(d_ptr);
+        QOpenGLFunctionsPrivate* core = extra;
+// An entry's position in its table is its offset over ENTRY_SIZE.
+#define WRAP_CORE(ret, name, args)                                             \
+    wrap<CoreFunctions, offsetof(CoreFunctions, name) / ENTRY_SIZE>(           \
+        core->f.name);
+#define WRAP_EXTRA(ret, name, args)                                            \
+    wrap<ExtraFunctions, offsetof(ExtraFunctions, name) / ENTRY_SIZE>(         \
+        extra->f.name);
+        QT_OPENGL_FUNCTIONS(WRAP_CORE)
+        QT_OPENGL_EXTRA_FUNCTIONS(WRAP_EXTRA)
+#undef WRAP_CORE
+#undef WRAP_EXTRA
+    };
+    ~GLCallCounter()
+    {
+        auto* extra = static_cast<QOpenGLExtraFunctionsPrivate*>(d_ptr);
+        QOpenGLFunctionsPrivate* core = extra;
+        restore<CoreFunctions>(core->functions);
+        restore<ExtraFunctions>(extra->functions);
+    };
+    GLCallCounter(const GLCallCounter&) = delete;
+    GLCallCounter& operator=(const GLCallCounter&) = delete;
+
+    // Calls since the counter was created.
+    qint64 calls() const { return s_calls; };
+
+  private:
+    using CoreFunctions = QOpenGLFunctionsPrivate::Functions;
+    using ExtraFunctions = QOpenGLExtraFunctionsPrivate::Functions;
+
+    constexpr static std::size_t ENTRY_SIZE = sizeof(QFunctionPointer);
+
+    // The entries replaced in a table, by their position in it.
+    template <typename Functions> struct Table
+    {
+        inline static std::array<QFunctionPointer,
+                                 sizeof(Functions) / ENTRY_SIZE>
+            entries{};
+    };
+
+    template <typename Functions, std::size_t Slot, typename R,
+              typename... Args>
+    static R QOPENGLF_APIENTRY counted(Args... args)
+    {
+        s_calls++;
+        using Entry = R(QOPENGLF_APIENTRYP)(Args...);
+        return reinterpret_cast<Entry>(Table<Functions>::entries[Slot])(
+            args...);
+    };
+
+    // Entries the driver does not have stay null, Qt checks some of them.
+    template <typename Functions, std::size_t Slot, typename R,
+              typename... Args>
+    static void wrap(R(QOPENGLF_APIENTRYP& entry)(Args...))
+    {
+        Table<Functions>::entries[Slot] =
+            reinterpret_cast<QFunctionPointer>(entry);
+        if (entry)
+            entry = &counted<Functions, Slot, R, Args...>;
+    };
+
+    template <typename Functions> static void restore(QFunctionPointer* table)
+    {
+        std::copy(Table<Functions>::entries.begin(),
+                  Table<Functions>::entries.end(), table);
+    };
+
+    inline static qint64 s_calls{0};
+};
+
+#endif // GLCALLCOUNTER_H
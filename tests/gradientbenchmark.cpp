@@ -0,0 +1,122 @@
+// Throughput of the gradient precomputation.
+//
+//   gradientBenchmark [size]
+//
+// Builds a synthetic volume of size^3 voxels (256 by default) in memory and
+// times both gradient kernels with scalar code and with AVX2, once on a single
+// thread to give the per-core rate and once across all cores the way the
+// loader runs them.
+
+#include "../gradientvolume.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace
+{
+constexpr int REPETITIONS = 3;
+
+std::shared_ptr<const VolumeData> syntheticVolume(const QTemporaryDir& dir,
+                                                  unsigned short size)
+{
+    QString fileName = dir.filePath("synthetic.dat");
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            return nullptr;
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream << size << size << size;
+        // A sphere with a noisy shell, so that the gradients are not uniform.
+        const float radius = size * 0.4f;
+        for (int z = 0; z < size; z++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                for (int x = 0; x < size; x++)
+                {
+                    const float dx = x - size * 0.5f;
+                    const float dy = y - size * 0.5f;
+                    const float dz = z - size * 0.5f;
+                    const bool inside = dx * dx + dy * dy + dz * dz < radius * radius;
+                    stream << static_cast<unsigned short>(
+                        (inside ? 2000 : 0) + ((x ^ y ^ z) & 0xff));
+                }
+            }
+        }
+    }
+    return VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+}
+
+double megavoxelsPerSecond(qint64 voxels, qint64 nanoseconds)
+{
+    return voxels * 1000.0 / nanoseconds;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+    QStringList arguments = app.arguments();
+    const auto size = static_cast<unsigned short>(
+        arguments.size() > 1 ? arguments[1].toUShort() : 256);
+
+    QTemporaryDir dir;
+    auto volume = syntheticVolume(dir, size);
+    QTextStream out(stdout);
+    if (!volume)
+    {
+        out << "Unable to write the synthetic volume\n";
+        return 1;
+    }
+
+    const unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    out << size << "^3 voxels, " << threads << " threads\n";
+    out << "kernel\tinstructions\tsingle MVoxels/s\tall MVoxels/s\tall ms\n";
+    const std::pair<GradientVolume::Kernel, QString> kernels[]{
+        {GradientVolume::Kernel::CentralDifference, "central"},
+        {GradientVolume::Kernel::Sobel, "sobel"}};
+    std::vector<std::pair<GradientVolume::Instructions, QString>>
+        instructionSets{{GradientVolume::Instructions::Scalar, "scalar"}};
+    if (GradientVolume::avx2Supported())
+        instructionSets.emplace_back(GradientVolume::Instructions::Avx2,
+                                     "avx2");
+    std::vector<unsigned char> slice(volume->sliceVoxelCount() *
+                                     GradientVolume::CHANNELS);
+    for (const auto& [kernel, name] : kernels)
+    {
+        for (const auto& [instructions, instructionsName] : instructionSets)
+        {
+            QElapsedTimer timer;
+            qint64 singleNanoseconds = std::numeric_limits<qint64>::max();
+            qint64 allNanoseconds = std::numeric_limits<qint64>::max();
+            for (int i = 0; i < REPETITIONS; i++)
+            {
+                timer.start();
+                for (int z = 0; z < volume->depth(); z++)
+                {
+                    GradientVolume::computeSlice(*volume, kernel, z, slice.data(),
+                                                 instructions);
+                }
+                singleNanoseconds = std::min(singleNanoseconds, timer.nsecsElapsed());
+
+                timer.start();
+                auto gradients =
+                    GradientVolume::build(*volume, kernel, instructions);
+                allNanoseconds = std::min(allNanoseconds, timer.nsecsElapsed());
+            }
+            out << name << "\t" << instructionsName << "\t"
+                << megavoxelsPerSecond(volume->voxelCount(), singleNanoseconds)
+                << "\t"
+                << megavoxelsPerSecond(volume->voxelCount(), allNanoseconds)
+                << "\t" << allNanoseconds / 1000000 << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Compares peak resident memory and load time of the .dat loading paths.
+//
+//   loaderBenchmark [directory]
+//
+// Writes synthetic volumes of 256^3, 512^3 and 1024^3 voxels to the given
+// directory (a temporary one by default) and loads each of them once per mode
+// in a fresh child process, so that the reported peak RSS belongs to that mode
+// alone. The "legacy" mode reproduces the loader before memory mapping: a read
+// into a vector, followed by the copies made by the queued signal and by the
+// assignment in Volume::load.
+
+#include "../volumedata.h"
+#include "testvolumes.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <array>
+#include <atomic>
+#include <execution>
+#include <iostream>
+#include <numeric>
+
+#ifdef Q_OS_WIN
+// clang-format off
+#include <windows.h>
+#include <psapi.h>
+// clang-format on
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+constexpr std::array<unsigned short, 3> VOLUME_SIZES{256, 512, 1024};
+const QStringList MODES{"legacy", "stream", "mmap"};
+
+qint64 peakResidentBytes()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<qint64>(counters.PeakWorkingSetSize);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Touches every voxel the way the texture upload would.
+unsigned long long consume(std::span<const unsigned short> voxels)
+{
+    return std::accumulate(voxels.begin(), voxels.end(), 0ull);
+}
+
+int runChild(const QString& mode, const QString& fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+    unsigned long long checksum = 0;
+    if (mode == "legacy")
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
+            return 1;
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        unsigned short width = 0, height = 0, depth = 0;
+        stream >> width >> height >> depth;
+        std::vector<unsigned short> volumeData(static_cast<std::size_t>(width) *
+                                               height * depth);
+        file.read(reinterpret_cast<char*>(volumeData.data()),
+                  static_cast<qint64>(volumeData.size() * sizeof(volumeData[0])));
+        std::array<std::atomic<unsigned long long>, 4096> histogramData{};
+        std::for_each(std::execution::par_unseq, volumeData.begin(),
+                      volumeData.end(), [&histogramData](auto& elem) {
+                          histogramData[elem]++;
+                          elem *= 16;
+                      });
+        std::vector<unsigned short> signalCopy = volumeData;
+        std::vector<unsigned short> memberCopy;
+        memberCopy = signalCopy;
+        checksum = consume(memberCopy);
+    }
+    else
+    {
+        auto loadMode = mode == "mmap" ? VolumeData::LoadMode::MemoryMapped
+                                       : VolumeData::LoadMode::Stream;
+        auto volumeData = VolumeData::fromFile(fileName, loadMode);
+        if (!volumeData)
+            return 1;
+        volumeData->normalizedHistogram();
+        checksum = consume(volumeData->voxels());
+    }
+    std::cout << timer.elapsed() << " " << peakResidentBytes() << " "
+              << checksum << std::endl;
+    return 0;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+    QStringList arguments = app.arguments();
+    if (arguments.size() == 4 && arguments[1] == "--child")
+        return runChild(arguments[2], arguments[3]);
+
+    QTemporaryDir temporaryDir;
+    QString directory = arguments.size() > 1 ? arguments[1] : temporaryDir.path();
+
+    QTextStream out(stdout);
+    out << "size\tmode\tload ms\tpeak RSS MiB\n";
+    for (auto size : VOLUME_SIZES)
+    {
+        QString fileName =
+            QString("%1/synthetic_%2.dat").arg(directory).arg(size);
+        if (!QFile::exists(fileName) && !writeSphereVolume(fileName, size))
+        {
+            out << "Unable to write " << fileName << "\n";
+            return 1;
+        }
+        for (const auto& mode : MODES)
+        {
+            QProcess child;
+            child.start(app.applicationFilePath(),
+                        {"--child", mode, fileName});
+            child.waitForFinished(-1);
+            QStringList result =
+                QString::fromLocal8Bit(child.readAllStandardOutput())
+                    .split(' ');
+            if (child.exitCode() != 0 || result.size() != 3)
+            {
+                out << size << "^3\t" << mode << "\tfailed\n";
+                continue;
+            }
+            out << size << "^3\t" << mode << "\t" << result[0] << "\t"
+                << result[1].toLongLong() / (1024 * 1024) << "\n";
+            out.flush();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,504 @@
+// Frame times of the 3D view along a camera path, across a matrix of render
+// settings.
+//
+//   renderBenchmark [--volume file.dat] [--tfn file.json] [--path file]
+//                   [--frames 120] [--size 768x768] [--slice-numbers 0,512]
+//                   [--pre-integration] [--reference-slices 4096]
+//                   [--output results.json]
+//
+// Renders the volume, plane and light renderers into a framebuffer object of
+// an offscreen surface, so no window is shown; on a host without a display
+// run it under xvfb-run or with QT_QPA_PLATFORM=offscreen. Without --volume a
+// synthetic 256^3 volume is written to a temporary directory.
+//
+// Every combination of maximum intensity projection, specular shading, the
+// slice model, fragment or compute shader raycasting, with --pre-integration
+// pre-integrated or not, and the given slice numbers (0 being the default of
+// one per voxel) follows the same camera path.
+// A path file holds one frame per line, either "rotate <degrees> <x> <y> <z>"
+// or "zoom <factor>"; the default path orbits the volume once while zooming in
+// and out again. Frames are rendered the way the 3D view renders them while it
+// is being dragged.
+//
+// Reports the 50th, 95th and 99th percentile frame times, from GPU timer
+// queries where the driver has them and from the CPU clock around a glFinish
+// otherwise, and the samples per second over the whole path: the samples the
+// rays actually took, as counted by the shader, over the total frame time.
+// Also reports the OpenGL calls per frame, counted by GLCallCounter at the
+// function table every Qt OpenGL class calls through. With --reference-slices
+// the start of the path is rendered once more at the full step, and its mean
+// error per colour channel is reported against the same view rendered with
+// the given slice number and without pre-integration.
+
+#include "../geometry.h"
+#include "../geometry/cubeplaneintersection.h"
+#include "../properties/sharedproperties.h"
+#include "../properties/viewport.h"
+#include "../renderers/lightrenderer.h"
+#include "../renderers/planerenderer.h"
+#include "../renderers/volumerenderer.h"
+#include "../texturestore.h"
+#include "glcallcounter.h"
+#include "testvolumes.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTimerQuery>
+#include <QSurfaceFormat>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <tuple>
+
+namespace
+{
+// As RayCastingWidget samples while the view is dragged.
+constexpr float INTERACTION_STEP_SCALE = 2.0f;
+constexpr unsigned short SYNTHETIC_SIZE = 256;
+// Frames rendered before the measured ones, which give the shader variant
+// time to compile and bricks time to become resident.
+constexpr int WARM_UP_FRAMES = 5;
+
+// One combination of the render settings the path is rendered with.
+struct Configuration
+{
+    bool maxInt{false};
+    bool specular{false};
+    bool sliceModel{false};
+    bool compute{false};
+    bool preIntegration{false};
+    // 0 for the default of one per voxel.
+    int sliceNr{0};
+};
+
+struct CameraStep
+{
+    float angle{0};
+    QVector3D axis;
+    float zoom{1};
+};
+
+std::vector<CameraStep> defaultPath(int frames)
+{
+    std::vector<CameraStep> path;
+    for (int i = 0; i < frames; i++)
+    {
+        path.push_back({360.0f / frames, QVector3D(0, 1, 0),
+                        i < frames / 2 ? 1.01f : 1.0f / 1.01f});
+    }
+    return path;
+}
+
+std::optional<std::vector<CameraStep>> readPath(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return std::nullopt;
+    std::vector<CameraStep> path;
+    QTextStream in(&file);
+    while (!in.atEnd())
+    {
+        const QStringList words =
+            in.readLine().split(' ', Qt::SkipEmptyParts);
+        if (words.size() == 5 && words[0] == "rotate")
+        {
+            path.push_back({words[1].toFloat(),
+                            QVector3D(words[2].toFloat(), words[3].toFloat(),
+                                      words[4].toFloat())});
+        }
+        else if (words.size() == 2 && words[0] == "zoom")
+        {
+            path.push_back({0, QVector3D(), words[1].toFloat()});
+        }
+        else if (!words.isEmpty())
+        {
+            return std::nullopt;
+        }
+    }
+    return path;
+}
+
+// Mean absolute difference of the colour channels of two images of the same
+// size, out of 255.
+double meanError(const QImage& image, const QImage& reference)
+{
+    qint64 difference = 0;
+    for (int y = 0; y < image.height(); y++)
+    {
+        const auto* row = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        const auto* referenceRow =
+            reinterpret_cast<const QRgb*>(reference.constScanLine(y));
+        for (int x = 0; x < image.width(); x++)
+        {
+            difference += std::abs(qRed(row[x]) - qRed(referenceRow[x])) +
+                          std::abs(qGreen(row[x]) - qGreen(referenceRow[x])) +
+                          std::abs(qBlue(row[x]) - qBlue(referenceRow[x]));
+        }
+    }
+    return static_cast<double>(difference) /
+           (3.0 * image.width() * image.height());
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setMajorVersion(4);
+    format.setMinorVersion(5);
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setProfile(QSurfaceFormat::CompatibilityProfile);
+    format.setOption(QSurfaceFormat::DeprecatedFunctions, true);
+    QSurfaceFormat::setDefaultFormat(format);
+    QGuiApplication app{argc, argv};
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption volumeOption("volume", "The .dat file to render.",
+                                          "file");
+    const QCommandLineOption transferFunctionOption(
+        "tfn", "Transfer function control points, as JSON.", "file");
+    const QCommandLineOption pathOption("path", "Camera path, a step per line.",
+                                        "file");
+    const QCommandLineOption framesOption(
+        "frames", "Frames of the default camera path.", "count", "120");
+    const QCommandLineOption sizeOption("size", "Framebuffer size.", "WxH",
+                                        "768x768");
+    const QCommandLineOption sliceNumbersOption(
+        "slice-numbers", "Slice numbers to render with, 0 for the default.",
+        "list", "0,512");
+    const QCommandLineOption preIntegrationOption(
+        "pre-integration", "Renders every case with pre-integration as well.");
+    const QCommandLineOption referenceSlicesOption(
+        "reference-slices",
+        "Reports the error of every case against a reference rendered with "
+        "this slice number.",
+        "count", "0");
+    const QCommandLineOption outputOption("output", "Writes the results here.",
+                                          "file");
+    parser.addOptions({volumeOption, transferFunctionOption, pathOption,
+                       framesOption, sizeOption, sliceNumbersOption,
+                       preIntegrationOption, referenceSlicesOption,
+                       outputOption});
+    parser.process(app);
+    QTextStream out(stdout);
+
+    const QStringList sizeParts = parser.value(sizeOption).split('x');
+    const QSize size(sizeParts.value(0).toInt(), sizeParts.value(1).toInt());
+    if (size.isEmpty())
+    {
+        out << "Invalid size\n";
+        return 1;
+    }
+    std::vector<CameraStep> path =
+        defaultPath(std::max(1, parser.value(framesOption).toInt()));
+    if (parser.isSet(pathOption))
+    {
+        auto recorded = readPath(parser.value(pathOption));
+        if (!recorded || recorded->empty())
+        {
+            out << "Invalid camera path\n";
+            return 1;
+        }
+        path = *recorded;
+    }
+
+    QOpenGLContext context;
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        out << "Unable to create an OpenGL context\n";
+        return 1;
+    }
+    out << reinterpret_cast<const char*>(
+               context.functions()->glGetString(GL_RENDERER))
+        << "\n";
+
+    QOpenGLExtraFunctions openGLExtra;
+    openGLExtra.initializeOpenGLFunctions();
+    QOpenGLFramebufferObject framebuffer(
+        size, QOpenGLFramebufferObject::CombinedDepthStencil);
+    framebuffer.bind();
+    openGLExtra.glViewport(0, 0, size.width(), size.height());
+
+    std::unique_ptr<ITextureStore> textureStore =
+        std::make_unique<TextureStore>();
+    auto properties = std::make_shared<SharedProperties>();
+    tfn::TransferFunction transferFunction;
+    if (parser.isSet(transferFunctionOption))
+    {
+        auto loaded =
+            tfn::TransferFunction::fromFile(parser.value(transferFunctionOption));
+        if (!loaded)
+            return 1;
+        transferFunction = *loaded;
+    }
+    transferFunction.setColorMap(tfn::ColorMap{});
+    transferFunction.updateTransferFunction();
+    textureStore->transferFunction().setTransferFunction(transferFunction);
+
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("synthetic.dat");
+    if (parser.isSet(volumeOption))
+        fileName = parser.value(volumeOption);
+    else if (!writeSphereVolume(fileName, SYNTHETIC_SIZE))
+    {
+        out << "Unable to write " << fileName << "\n";
+        return 1;
+    }
+    if (!VolumeData::open(fileName, VolumeData::LoadMode::MemoryMapped))
+    {
+        out << "Unable to read " << fileName << "\n";
+        return 1;
+    }
+    {
+        QEventLoop loop;
+        QObject::connect(&textureStore->volume(), &Volume::loaderFinished,
+                         &loop, &QEventLoop::quit);
+        textureStore->volume().load(fileName);
+        loop.exec();
+    }
+    const int volumeSlices = static_cast<int>(
+        textureStore->volume().getDimensions().x());
+
+    RenderSettings settings;
+    CameraProperties camera;
+    camera.moveCamera(QVector3D(0, 0, -2.0f * std::sqrt(3.0f)));
+    camera.updateProjectionMatrix(static_cast<float>(size.width()) /
+                                  size.height());
+    ViewPort viewPort(size.width(), size.height());
+    const Plane& plane = properties->clippingPlane().plane();
+    CubePlaneIntersection intersection(plane);
+
+    Geometry::instance().allocateObliqueSlice(intersection);
+    LightRenderer lightRenderer(camera, settings);
+    PlaneRenderer planeRenderer(textureStore, properties, camera, settings);
+    VolumeRenderer volumeRenderer(textureStore, settings, camera, openGLExtra,
+                                  viewPort, lightRenderer, plane);
+    volumeRenderer.compileShader();
+    planeRenderer.compileShader();
+    lightRenderer.compileShader();
+    volumeRenderer.setInteracting(true);
+
+    // Counts from here on, the renderers are set up.
+    const GLCallCounter glCallCounter;
+    QOpenGLTimerQuery timer;
+    const bool gpuTimer = timer.create();
+    out << (gpuTimer ? "GPU timer queries\n" : "CPU clock around glFinish\n");
+
+    const auto applySettings = [&](const Configuration& configuration) {
+        settings.maxInt = configuration.maxInt;
+        settings.specOff = !configuration.specular;
+        settings.sliceModel = configuration.sliceModel;
+        settings.computeRaycaster = configuration.compute;
+        settings.preIntegration = configuration.preIntegration;
+        settings.sliceNr = configuration.sliceNr;
+        settings.defaultSliceNr = configuration.sliceNr <= 0;
+        settings.generation++;
+    };
+    const auto paintFrame = [&]() {
+        openGLExtra.glClearColor(0.95f, 0.95f, 0.95f, 1.0f);
+        openGLExtra.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        volumeRenderer.paint();
+        planeRenderer.paint();
+        lightRenderer.paint();
+    };
+    int frame = 0;
+    const auto renderFrame = [&]() {
+        volumeRenderer.setRaySampling(INTERACTION_STEP_SCALE, 0.0f, frame++);
+        paintFrame();
+    };
+
+    // Puts the camera back at the start of the path, or takes a step along it.
+    const auto resetCamera = [&]() {
+        camera.rotateCamera(QMatrix4x4{});
+        camera.zoomCamera(1.0f / camera.zoomFactor());
+    };
+    const auto moveCamera = [&](const CameraStep& step) {
+        if (step.angle != 0)
+            camera.rotateCamera(step.angle, step.axis);
+        camera.zoomCamera(step.zoom);
+    };
+    const std::vector<bool> preIntegrationValues =
+        parser.isSet(preIntegrationOption) ? std::vector<bool>{false, true}
+                                           : std::vector<bool>{false};
+
+    // The image of the start of the path, sampled at the full step without
+    // jitter.
+    const auto renderStill = [&]() {
+        resetCamera();
+        volumeRenderer.setInteracting(false);
+        volumeRenderer.setRaySampling(1.0f, 0.0f, -1);
+        for (int i = 0; i < WARM_UP_FRAMES; i++)
+            paintFrame();
+        volumeRenderer.setInteracting(true);
+        return framebuffer.toImage().convertToFormat(QImage::Format_RGB32);
+    };
+    // References at the given slice number, by maxInt, specular and
+    // sliceModel, rendered when first needed.
+    const int referenceSlices = parser.value(referenceSlicesOption).toInt();
+    std::map<std::tuple<bool, bool, bool>, QImage> references;
+    const auto reference = [&](const Configuration& configuration) {
+        const auto key = std::make_tuple(configuration.maxInt,
+                                         configuration.specular,
+                                         configuration.sliceModel);
+        if (!references.contains(key))
+        {
+            applySettings({configuration.maxInt, configuration.specular,
+                           configuration.sliceModel, false, false,
+                           referenceSlices});
+            references[key] = renderStill();
+        }
+        return references[key];
+    };
+
+    std::vector<Configuration> configurations;
+    for (const QString& sliceNumber :
+         parser.value(sliceNumbersOption).split(','))
+        for (bool maxInt : {false, true})
+            for (bool specular : {false, true})
+                for (bool sliceModel : {false, true})
+                    for (bool compute : {false, true})
+                        for (bool preIntegration : preIntegrationValues)
+                        {
+                            configurations.push_back(
+                                {maxInt, specular, sliceModel, compute,
+                                 preIntegration, sliceNumber.toInt()});
+                        }
+
+    QJsonArray results;
+    out << "maxInt\tspecular\tsliceModel\tcompute\tpreIntegration\tsliceNr\t"
+           "p50 ms\tp95 ms\tp99 ms\tMsamples/s\tGL calls\terror\n";
+    for (const Configuration& configuration : configurations)
+    {
+        applySettings(configuration);
+        resetCamera();
+        for (int i = 0; i < WARM_UP_FRAMES; i++)
+            renderFrame();
+        openGLExtra.glFinish();
+
+        std::vector<double> milliseconds;
+        qint64 glCalls = 0;
+        QElapsedTimer clock;
+        for (const CameraStep& step : path)
+        {
+            moveCamera(step);
+            clock.start();
+            if (gpuTimer)
+                timer.begin();
+            const qint64 callsBefore = glCallCounter.calls();
+            renderFrame();
+            glCalls += glCallCounter.calls() - callsBefore;
+            if (gpuTimer)
+            {
+                timer.end();
+                milliseconds.push_back(timer.waitForResult() / 1.0e6);
+            }
+            else
+            {
+                openGLExtra.glFinish();
+                milliseconds.push_back(clock.nsecsElapsed() / 1.0e6);
+            }
+        }
+
+        // The counters slow the shader down, so the samples are counted on
+        // a second, untimed run of the path. A frame's counts are read back
+        // by the next paint.
+        volumeRenderer.setCollectRayStatistics(true);
+        resetCamera();
+        qint64 samples = 0;
+        for (std::size_t i = 0; i <= path.size(); i++)
+        {
+            if (i < path.size())
+                moveCamera(path[i]);
+            renderFrame();
+            if (i > 0)
+                samples += volumeRenderer.rayStatistics().samples;
+        }
+        volumeRenderer.setCollectRayStatistics(false);
+
+        // Mean difference per colour channel, out of 255.
+        std::optional<double> error;
+        if (referenceSlices > 0)
+        {
+            const QImage still = renderStill();
+            error = meanError(still, reference(configuration));
+            applySettings(configuration);
+        }
+
+        const double totalMilliseconds =
+            std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0);
+        std::sort(milliseconds.begin(), milliseconds.end());
+        const int slices = settings.defaultSliceNr ? volumeSlices
+                                                   : settings.sliceNr;
+        const double p50 = percentile(milliseconds, 0.5);
+        const double p95 = percentile(milliseconds, 0.95);
+        const double p99 = percentile(milliseconds, 0.99);
+        const double samplesPerSecond = samples / (totalMilliseconds / 1000.0);
+        const double glCallsPerFrame =
+            static_cast<double>(glCalls) / path.size();
+        out << configuration.maxInt << "\t" << configuration.specular << "\t"
+            << configuration.sliceModel << "\t" << configuration.compute
+            << "\t" << configuration.preIntegration << "\t" << slices << "\t"
+            << p50 << "\t" << p95 << "\t" << p99 << "\t"
+            << samplesPerSecond / 1.0e6 << "\t" << glCallsPerFrame << "\t"
+            << (error ? QString::number(*error, 'f', 3) : QString("-"))
+            << "\n";
+        out.flush();
+        QJsonObject result{{"maxInt", configuration.maxInt},
+                           {"specular", configuration.specular},
+                           {"sliceModel", configuration.sliceModel},
+                           {"computeRaycaster", configuration.compute},
+                           {"preIntegration", configuration.preIntegration},
+                           {"sliceNr", slices},
+                           {"p50Milliseconds", p50},
+                           {"p95Milliseconds", p95},
+                           {"p99Milliseconds", p99},
+                           {"samples", samples},
+                           {"samplesPerSecond", samplesPerSecond},
+                           {"glCallsPerFrame", glCallsPerFrame}};
+        if (error)
+            result["error"] = *error;
+        results.append(result);
+    }
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            out << "Unable to write " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(QJsonObject{{"gpuTimer", gpuTimer},
+                                             {"width", size.width()},
+                                             {"height", size.height()},
+                                             {"frames", static_cast<int>(
+                                                            path.size())},
+                                             {"configurations", results}})
+                       .toJson());
+    }
+    framebuffer.release();
+    return 0;
+}
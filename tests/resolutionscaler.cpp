@@ -0,0 +1,51 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../renderers/resolutionscaler.h"
+
+#include "../vendor/doctest/doctest.h"
+
+TEST_CASE("Slow frames lower the scale by the square root of the overrun")
+{
+    ResolutionScaler scaler;
+    scaler.unpin();
+    scaler.setFrameTimeBudget(16.0f);
+    scaler.addFrameTime(64.0f);
+    CHECK(scaler.scale() == doctest::Approx(0.5));
+    CHECK(scaler.lastFrameTime() == doctest::Approx(64.0));
+}
+
+TEST_CASE("Frames close to the budget keep the scale")
+{
+    ResolutionScaler scaler;
+    scaler.unpin();
+    scaler.setFrameTimeBudget(16.0f);
+    scaler.addFrameTime(64.0f);
+    scaler.addFrameTime(17.0f);
+    scaler.addFrameTime(15.0f);
+    CHECK(scaler.scale() == doctest::Approx(0.5));
+}
+
+TEST_CASE("The scale stays within its bounds")
+{
+    ResolutionScaler scaler;
+    scaler.unpin();
+    scaler.setFrameTimeBudget(16.0f);
+    scaler.addFrameTime(10000.0f);
+    CHECK(scaler.scale() == doctest::Approx(ResolutionScaler::MINIMUM_SCALE));
+    for (int i = 0; i < 10; i++)
+    {
+        scaler.addFrameTime(1.0f);
+    }
+    CHECK(scaler.scale() == doctest::Approx(1.0));
+}
+
+TEST_CASE("A pinned scale ignores frame times")
+{
+    ResolutionScaler scaler;
+    scaler.pin(0.6f);
+    CHECK(scaler.pinned());
+    // Snapped to the nearest sixteenth.
+    CHECK(scaler.scale() == doctest::Approx(10.0 / 16.0));
+    scaler.addFrameTime(1000.0f);
+    CHECK(scaler.scale() == doctest::Approx(10.0 / 16.0));
+}
@@ -0,0 +1,275 @@
+// Repeatable timings of the CPU hot paths, for spotting regressions.
+//
+//   strangevisBenchmark [--sizes 64,128,256] [--output results.json]
+//                       [--baseline baseline.json] [--tolerance 0.1]
+//
+// Writes synthetic volumes of the given sizes to a temporary directory and
+// times loading and the loader's per-voxel passes on each of them, followed
+// by the transfer function, colour map and slicing plane geometry paths.
+// Every case runs REPETITIONS times after a warm-up run; the median and the
+// minimum are printed and written to the output file as JSON. Given the JSON
+// of an earlier run as a baseline, medians are compared against it and any
+// case slower by more than the tolerance makes the exit code 1.
+
+#include "../emptyspacegrid.h"
+#include "../geometry/cubeplaneintersection.h"
+#include "../geometry/utils.h"
+#include "../gradientvolume.h"
+#include "../transferfunction.h"
+#include "../transfertexture.h"
+#include "../volumedata.h"
+#include "../volumepyramid.h"
+#include "testvolumes.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMatrix4x4>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+constexpr int REPETITIONS = 7;
+// Calls per repetition of the cases that take microseconds.
+constexpr int TRANSFER_FUNCTION_CALLS = 100;
+constexpr int PLANE_CALLS = 1000;
+
+struct Result
+{
+    QString name;
+    qint64 medianNanoseconds;
+    qint64 minNanoseconds;
+    // Voxels or calls per repetition.
+    qint64 items;
+};
+
+// Keeps the compiler from dropping work whose result is never used.
+volatile std::size_t sink = 0;
+
+template <typename F> Result measure(const QString& name, qint64 items, F&& run)
+{
+    run();
+    std::vector<qint64> nanoseconds;
+    QElapsedTimer timer;
+    for (int i = 0; i < REPETITIONS; i++)
+    {
+        timer.start();
+        run();
+        nanoseconds.push_back(timer.nsecsElapsed());
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    return {name, nanoseconds[nanoseconds.size() / 2], nanoseconds.front(),
+            items};
+}
+
+void volumeCases(const QString& fileName, std::vector<Result>& results)
+{
+    auto volume = VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    if (!volume)
+        return;
+    const QString size = QString::number(volume->width());
+    const qint64 voxels = volume->voxelCount();
+
+    results.push_back(measure("load.stream/" + size, voxels, [&]() {
+        sink = sink + VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream)
+                          ->voxels()
+                          .size();
+    }));
+    results.push_back(measure("load.mapped/" + size, voxels, [&]() {
+        sink = sink +
+               VolumeData::fromFile(fileName, VolumeData::LoadMode::MemoryMapped)
+                   ->voxels()
+                   .size();
+    }));
+    results.push_back(measure("histogram/" + size, voxels, [&]() {
+        sink = sink + volume->normalizedHistogram().size();
+    }));
+    results.push_back(measure("pyramid/" + size, voxels, [&]() {
+        sink = sink + VolumePyramid::build(*volume)->levels().size();
+    }));
+    results.push_back(measure("emptySpaceGrid/" + size, voxels, [&]() {
+        sink = sink + EmptySpaceGrid::build(*volume)->width();
+    }));
+    results.push_back(measure("gradients/" + size, voxels, [&]() {
+        sink = sink + GradientVolume::build(*volume)->texels().size();
+    }));
+}
+
+void transferFunctionCases(std::vector<Result>& results)
+{
+    // Two sets of control points in turn, so every call evaluates every
+    // segment.
+    std::array<QList<tfn::ControlPoint>, 2> controlPoints;
+    for (int set = 0; set < 2; set++)
+    {
+        tfn::TransferFunction tfn;
+        for (int i = 1; i <= 8; i++)
+        {
+            const double x = i / 9.0;
+            tfn.addControlPoint(tfn::ControlPoint(QPointF(x, (set + 1) * x / 3)));
+        }
+        controlPoints[set] = tfn.getControlPoints();
+    }
+    tfn::TransferFunction tfn;
+    results.push_back(measure(
+        "transferFunction.interpolatePoints", TRANSFER_FUNCTION_CALLS, [&]() {
+            for (int i = 0; i < TRANSFER_FUNCTION_CALLS; i++)
+            {
+                tfn.getControlPoints() = controlPoints[i % 2];
+                tfn.interpolatePoints();
+            }
+            sink = sink + tfn.evaluatedEntries();
+        }));
+
+    tfn::ColorMapStore store;
+    results.push_back(measure("colorMapStore.loadColorMapsFromFile", 1, [&]() {
+        sink = sink + store.loadColorMapsFromFile(":cmaps/cmaps.xml");
+    }));
+}
+
+void planeCases(std::vector<Result>& results)
+{
+    // Planes through the cube at a spread of angles and offsets, giving
+    // three to six intersection points.
+    std::vector<Plane> planes;
+    for (int i = 0; i < PLANE_CALLS; i++)
+    {
+        QMatrix4x4 rotation;
+        rotation.rotate(i * 7.0f, 1, 0, 0);
+        rotation.rotate(i * 13.0f, 0, 1, 0);
+        const QVector3D normal = rotation.map(QVector3D(0, 0, 1));
+        planes.emplace_back(QVector4D(normal, (i % 10) * 0.05f));
+    }
+    CubePlaneIntersection intersection(planes.front());
+    results.push_back(
+        measure("cubePlaneIntersection.changePlane", PLANE_CALLS, [&]() {
+            for (const Plane& plane : planes)
+                intersection.changePlane(plane);
+            sink = sink + intersection.getConvexHullIndexOrder().size();
+        }));
+
+    std::vector<std::vector<QVector3D>> points;
+    for (const Plane& plane : planes)
+    {
+        intersection.changePlane(plane);
+        points.push_back(intersection.getCubeIntersections());
+    }
+    results.push_back(measure("convexHullGiftWrapping", PLANE_CALLS, [&]() {
+        for (const auto& polygon : points)
+            sink = sink + convexHullGiftWrapping(polygon).size();
+    }));
+}
+
+QJsonDocument toJson(const std::vector<Result>& results)
+{
+    QJsonArray benchmarks;
+    for (const Result& result : results)
+    {
+        benchmarks.append(QJsonObject{
+            {"name", result.name},
+            {"medianNanoseconds", result.medianNanoseconds},
+            {"minNanoseconds", result.minNanoseconds},
+            {"items", result.items}});
+    }
+    return QJsonDocument(QJsonObject{
+        {"threads", static_cast<int>(std::thread::hardware_concurrency())},
+        {"repetitions", REPETITIONS},
+        {"benchmarks", benchmarks}});
+}
+
+QMap<QString, qint64> readBaseline(const QString& fileName)
+{
+    QMap<QString, qint64> medians;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return medians;
+    const QJsonArray benchmarks =
+        QJsonDocument::fromJson(file.readAll()).object()["benchmarks"].toArray();
+    for (const QJsonValue& benchmark : benchmarks)
+    {
+        medians.insert(benchmark["name"].toString(),
+                       benchmark["medianNanoseconds"].toInteger());
+    }
+    return medians;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption(
+        "sizes", "Edge lengths of the synthetic volumes.", "list", "64,128,256");
+    const QCommandLineOption outputOption("output", "Writes the results here.",
+                                          "file");
+    const QCommandLineOption baselineOption(
+        "baseline", "Results of an earlier run to compare against.", "file");
+    const QCommandLineOption toleranceOption(
+        "tolerance", "Slowdown that counts as a regression.", "fraction",
+        "0.1");
+    parser.addOptions(
+        {sizesOption, outputOption, baselineOption, toleranceOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    std::vector<Result> results;
+    {
+        QTemporaryDir dir;
+        for (const QString& size : parser.value(sizesOption).split(','))
+        {
+            const QString fileName =
+                dir.filePath(QString("synthetic%1.dat").arg(size));
+            if (!writeSphereVolume(fileName, size.toInt()))
+            {
+                out << "Unable to write " << fileName << "\n";
+                return 1;
+            }
+            volumeCases(fileName, results);
+        }
+    }
+    transferFunctionCases(results);
+    planeCases(results);
+
+    const QMap<QString, qint64> baseline =
+        readBaseline(parser.value(baselineOption));
+    const double tolerance = parser.value(toleranceOption).toDouble();
+    int regressions = 0;
+    out << "case\tmedian ms\tmin ms\tMitems/s\tbaseline ms\tchange\n";
+    for (const Result& result : results)
+    {
+        out << result.name << "\t" << result.medianNanoseconds / 1.0e6 << "\t"
+            << result.minNanoseconds / 1.0e6 << "\t"
+            << result.items * 1000.0 / result.medianNanoseconds;
+        if (baseline.contains(result.name))
+        {
+            const qint64 before = baseline[result.name];
+            const double change =
+                static_cast<double>(result.medianNanoseconds) / before - 1.0;
+            const bool regressed = change > tolerance;
+            regressions += regressed;
+            out << "\t" << before / 1.0e6 << "\t"
+                << QString::asprintf("%+.1f%%", change * 100.0)
+                << (regressed ? " REGRESSION" : "");
+        }
+        out << "\n";
+    }
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            out << "Unable to write " << file.fileName() << "\n";
+            return 1;
+        }
+        file.write(toJson(results).toJson());
+    }
+    return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../gradientvolume.h"
+#include "../syntheticvolume.h"
+#include "../volumedata.h"
+
+#include "../vendor/doctest/doctest.h"
+
+#include <QTemporaryDir>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+SyntheticVolume::Parameters parameters(SyntheticVolume::Content content)
+{
+    SyntheticVolume::Parameters parameters;
+    parameters.content = content;
+    parameters.width = 40;
+    parameters.height = 32;
+    parameters.depth = 24;
+    parameters.spacing = QVector3D(1.0f, 1.0f, 2.0f);
+    return parameters;
+}
+} // namespace
+
+TEST_CASE("Synthetic volumes load back as written")
+{
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("noise.dat");
+    const SyntheticVolume synthetic(
+        parameters(SyntheticVolume::Content::Noise));
+    const auto histogram = synthetic.write(fileName);
+    REQUIRE(histogram);
+
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    CHECK(volumeData->dimensions() == QVector3D(40, 32, 24));
+    CHECK(VolumeData::gridSpacing(fileName) == QVector3D(1.0f, 1.0f, 2.0f));
+
+    const auto voxels = volumeData->voxels();
+    bool matching = true;
+    for (int z = 0; z < 24; z++)
+    {
+        for (int y = 0; y < 32; y++)
+        {
+            for (int x = 0; x < 40; x++)
+            {
+                matching &= voxels[(z * 32 + y) * 40 + x] ==
+                            synthetic.voxel(x, y, z);
+            }
+        }
+    }
+    CHECK(matching);
+
+    const qint64 maxCount =
+        *std::max_element(histogram->begin(), histogram->end());
+    const auto normalized = volumeData->normalizedHistogram();
+    bool sameHistogram = true;
+    for (int i = 0; i < VolumeData::HISTOGRAM_BINS; i++)
+    {
+        sameHistogram &= std::abs(normalized[i] - static_cast<float>(
+                                                      (*histogram)[i]) /
+                                                      maxCount) < 1.0e-6f;
+    }
+    CHECK(sameHistogram);
+}
+
+TEST_CASE("Gradients of the loader point along the exact gradient")
+{
+    QTemporaryDir dir;
+    const QString fileName = dir.filePath("sphere.dat");
+    const SyntheticVolume synthetic(
+        parameters(SyntheticVolume::Content::Sphere));
+    REQUIRE(synthetic.write(fileName));
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    const auto gradients = GradientVolume::build(*volumeData);
+
+    // A voxel step is 1 / size in texture space, so gradients per texture
+    // unit grow with the size of the volume. The probes lie on the sloped
+    // part of the sphere, away from its tip.
+    const QVector3D dimensions(40, 32, 24);
+    for (const auto& [x, y, z] : {std::array{10, 16, 12}, std::array{26, 12, 9},
+                                  std::array{20, 22, 15}})
+    {
+        const QVector3D exact =
+            (synthetic.gradient(x, y, z) * dimensions).normalized();
+        const unsigned char* texel =
+            gradients->texels().data() +
+            static_cast<std::size_t>((z * 32 + y) * 40 + x) *
+                GradientVolume::CHANNELS;
+        const QVector3D packed =
+            (QVector3D(texel[0], texel[1], texel[2]) / 255.0f * 2.0f -
+             QVector3D(1, 1, 1))
+                .normalized();
+        CHECK(QVector3D::dotProduct(exact, packed) > 0.99f);
+    }
+}
+
+TEST_CASE("Sparse volumes are mostly empty")
+{
+    QTemporaryDir dir;
+    const SyntheticVolume synthetic(
+        parameters(SyntheticVolume::Content::Sparse));
+    const auto histogram = synthetic.write(dir.filePath("sparse.dat"));
+    REQUIRE(histogram);
+    CHECK((*histogram)[0] > 40 * 32 * 24 * 9 / 10);
+    CHECK((*histogram)[0] < 40 * 32 * 24);
+}
+
+TEST_CASE("The Marschner-Lobb phantom spans the intensity range")
+{
+    const SyntheticVolume synthetic(
+        parameters(SyntheticVolume::Content::MarschnerLobb));
+    unsigned short lowest = SyntheticVolume::MAXIMUM_INTENSITY;
+    unsigned short highest = 0;
+    for (int z = 0; z < 24; z++)
+    {
+        for (int y = 0; y < 32; y++)
+        {
+            for (int x = 0; x < 40; x++)
+            {
+                lowest = std::min(lowest, synthetic.voxel(x, y, z));
+                highest = std::max(highest, synthetic.voxel(x, y, z));
+            }
+        }
+    }
+    CHECK(lowest < SyntheticVolume::MAXIMUM_INTENSITY / 10);
+    CHECK(highest > SyntheticVolume::MAXIMUM_INTENSITY * 9 / 10);
+}
@@ -0,0 +1,22 @@
+#ifndef TESTVOLUMES_H
+#define TESTVOLUMES_H
+
+#include "../syntheticvolume.h"
+
+#include <QString>
+
+// A cube of size^3 voxels holding a sphere that is brightest at its centre and
+// fades out to nothing at the given radius, relative to half the cube's size.
+// Written in slabs by SyntheticVolume, so size can exceed memory. Returns
+// false if the file could not be written.
+inline bool
+writeSphereVolume(const QString& fileName, int size,
+                  float radius = SyntheticVolume::Parameters{}.radius)
+{
+    SyntheticVolume::Parameters parameters;
+    parameters.width = parameters.height = parameters.depth = size;
+    parameters.radius = radius;
+    return SyntheticVolume(parameters).write(fileName).has_value();
+}
+
+#endif // TESTVOLUMES_H
@@ -0,0 +1,149 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../preintegrationtable.h"
+#include "../transferfunction.h"
+#include "../transfertexture.h"
+
+#include "../vendor/doctest/doctest.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <algorithm>
+
+using namespace tfn;
+
+namespace
+{
+TransferFunction fourSegments()
+{
+    TransferFunction tfn;
+    tfn.addControlPoint(ControlPoint(QPointF(0.25, 0.2)));
+    tfn.addControlPoint(ControlPoint(QPointF(0.5, 0.6)));
+    tfn.addControlPoint(ControlPoint(QPointF(0.75, 0.3)));
+    tfn.interpolatePoints();
+    return tfn;
+}
+} // namespace
+
+TEST_CASE("The curve covers every texel")
+{
+    TransferFunction tfn = fourSegments();
+    const auto& x = tfn.curveX();
+    const auto& y = tfn.curveY();
+    REQUIRE(x.size() == size::NUM_POINTS);
+    CHECK(x.front() == doctest::Approx(0.0));
+    CHECK(y.front() == doctest::Approx(0.0));
+    CHECK(x.back() == doctest::Approx(1.0));
+    CHECK(y.back() == doctest::Approx(0.999));
+    CHECK(std::is_sorted(x.begin(), x.end()));
+}
+
+TEST_CASE("Moving a control point re-evaluates only its segments")
+{
+    TransferFunction tfn = fourSegments();
+    tfn.replace(2, ControlPoint(QPointF(0.5, 0.9)));
+    tfn.interpolatePoints();
+
+    // The segments on either side of the point, about half of the texels.
+    CHECK(tfn.evaluatedEntries() > 0);
+    CHECK(tfn.evaluatedEntries() <= size::NUM_POINTS / 2 + 1);
+
+    TransferFunction fresh;
+    fresh.getControlPoints() = tfn.getControlPoints();
+    fresh.interpolatePoints();
+    CHECK(fresh.evaluatedEntries() == size::NUM_POINTS);
+    CHECK(tfn.curveX() == fresh.curveX());
+    CHECK(tfn.curveY() == fresh.curveY());
+}
+
+TEST_CASE("An unchanged function is not re-evaluated")
+{
+    TransferFunction tfn = fourSegments();
+    tfn.interpolatePoints();
+    CHECK(tfn.evaluatedEntries() == 0);
+}
+
+TEST_CASE("A transfer function file gives the curve of its control points")
+{
+    QTemporaryDir dir;
+    const auto write = [&dir](const QByteArray& json) {
+        QFile file(dir.filePath("tfn.json"));
+        file.open(QIODevice::WriteOnly);
+        file.write(json);
+        return file.fileName();
+    };
+
+    auto loaded = TransferFunction::fromFile(write(R"({"controlPoints": [
+        {"x": 0, "y": 0},
+        {"x": 0.25, "y": 0.2},
+        {"x": 0.5, "y": 0.6},
+        {"x": 0.75, "y": 0.3},
+        {"x": 1, "y": 1}]})"));
+    REQUIRE(loaded);
+    TransferFunction expected = fourSegments();
+    CHECK(loaded->curveX() == expected.curveX());
+    CHECK(loaded->curveY() == expected.curveY());
+
+    // Out of order, off the domain and unparseable files are rejected.
+    CHECK_FALSE(TransferFunction::fromFile(write(
+        R"({"controlPoints": [{"x": 0, "y": 0}, {"x": 0.6, "y": 0.5},
+                              {"x": 0.4, "y": 0.5}, {"x": 1, "y": 1}]})")));
+    CHECK_FALSE(TransferFunction::fromFile(
+        write(R"({"controlPoints": [{"x": 0, "y": 0}, {"x": 1, "y": 2}]})")));
+    CHECK_FALSE(TransferFunction::fromFile(write("{\"controlPoints\": [")));
+    CHECK_FALSE(TransferFunction::fromFile(dir.filePath("missing.json")));
+}
+
+namespace
+{
+const float* tableEntry(const std::vector<float>& table, int front, int back)
+{
+    return table.data() +
+           (static_cast<std::size_t>(back) * PreIntegrationTable::SIZE + front) *
+               PreIntegrationTable::CHANNELS;
+}
+} // namespace
+
+TEST_CASE("A constant transfer function integrates to itself")
+{
+    std::vector<float> rgba;
+    for (int i = 0; i < 64; i++)
+    {
+        rgba.insert(rgba.end(), {0.2f, 0.4f, 0.6f, 0.5f});
+    }
+    const auto table = PreIntegrationTable::build(rgba);
+    REQUIRE(table.size() == static_cast<std::size_t>(PreIntegrationTable::SIZE) *
+                                PreIntegrationTable::SIZE *
+                                PreIntegrationTable::CHANNELS);
+    for (auto [front, back] : {std::pair{0, 0}, std::pair{10, 400},
+                               std::pair{511, 3}})
+    {
+        const float* texel = tableEntry(table, front, back);
+        CHECK(texel[0] == doctest::Approx(0.2));
+        CHECK(texel[1] == doctest::Approx(0.4));
+        CHECK(texel[2] == doctest::Approx(0.6));
+        CHECK(texel[3] == doctest::Approx(0.5));
+    }
+}
+
+TEST_CASE("A peak between two samples is not stepped over")
+{
+    // Transparent except for one red entry in the middle.
+    std::vector<float> rgba(256 * PreIntegrationTable::CHANNELS, 0.0f);
+    rgba[128 * PreIntegrationTable::CHANNELS] = 1.0f;
+    rgba[128 * PreIntegrationTable::CHANNELS + 3] = 1.0f;
+    const auto table = PreIntegrationTable::build(rgba);
+
+    const int size = PreIntegrationTable::SIZE;
+    // Both ends transparent, the segment across the peak is not.
+    CHECK(tableEntry(table, size / 4, size / 4)[3] == 0.0f);
+    CHECK(tableEntry(table, 3 * size / 4, 3 * size / 4)[3] == 0.0f);
+    const float* across = tableEntry(table, size / 4, 3 * size / 4);
+    CHECK(across[0] == doctest::Approx(1.0));
+    CHECK(across[3] == doctest::Approx(2.0 / 256.0).epsilon(0.05));
+    // Integrating backwards gives the same segment.
+    const float* reversed = tableEntry(table, 3 * size / 4, size / 4);
+    CHECK(reversed[3] == doctest::Approx(across[3]));
+    // A segment beside the peak stays transparent.
+    CHECK(tableEntry(table, 0, size / 4)[3] == 0.0f);
+}
@@ -0,0 +1,72 @@
+// Cost of re-evaluating the transfer function while a control point is
+// dragged.
+//
+//   transferFunctionBenchmark [control points]
+//
+// Spreads the given number of control points (8 by default) over the domain
+// and moves the middle one up and down once per tick, reporting the time per
+// tick and the entries re-evaluated, next to a full evaluation for reference.
+
+#include "../transferfunction.h"
+#include "../transfertexture.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+
+namespace
+{
+constexpr int TICKS = 10000;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+    QStringList arguments = app.arguments();
+    const int controlPoints =
+        std::max(1, arguments.size() > 1 ? arguments[1].toInt() : 8);
+
+    tfn::TransferFunction tfn;
+    for (int i = 1; i <= controlPoints; i++)
+    {
+        const double x = i / static_cast<double>(controlPoints + 1);
+        tfn.addControlPoint(tfn::ControlPoint(QPointF(x, 0.5 * x)));
+    }
+    tfn.interpolatePoints();
+    const int dragged = (controlPoints + 1) / 2;
+    const double x = tfn.getControlPoints()[dragged].x();
+
+    QTextStream out(stdout);
+    out << tfn::size::NUM_POINTS << " entries, " << controlPoints
+        << " control points\n";
+    out << "\tns/tick\tentries/tick\n";
+
+    QElapsedTimer timer;
+    qint64 entries = 0;
+    timer.start();
+    for (int tick = 0; tick < TICKS; tick++)
+    {
+        const double y = 0.1 + 0.8 * ((tick % 100) / 100.0);
+        tfn.replace(dragged, tfn::ControlPoint(QPointF(x, y)));
+        tfn.interpolatePoints();
+        entries += tfn.evaluatedEntries();
+    }
+    const qint64 dragNanoseconds = timer.nsecsElapsed();
+    out << "drag\t" << dragNanoseconds / TICKS << "\t" << entries / TICKS
+        << "\n";
+
+    entries = 0;
+    timer.start();
+    for (int tick = 0; tick < TICKS; tick++)
+    {
+        tfn::TransferFunction fresh;
+        fresh.getControlPoints() = tfn.getControlPoints();
+        fresh.interpolatePoints();
+        entries += fresh.evaluatedEntries();
+    }
+    const qint64 fullNanoseconds = timer.nsecsElapsed();
+    out << "full\t" << fullNanoseconds / TICKS << "\t" << entries / TICKS
+        << "\n";
+    return 0;
+}
@@ -0,0 +1,306 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include "../emptyspacegrid.h"
+#include "../gradientvolume.h"
+#include "../proxygeometry.h"
+#include "../volumedata.h"
+#include "../volumepyramid.h"
+
+#include "../vendor/doctest/doctest.h"
+
+#include <QDataStream>
+#include <QTemporaryDir>
+#include <cmath>
+
+namespace
+{
+QString writeVolume(const QTemporaryDir& dir, unsigned short width,
+                    unsigned short height, unsigned short depth,
+                    int voxelCount)
+{
+    QString fileName = dir.filePath("volume.dat");
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly);
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << width << height << depth;
+    for (int i = 0; i < voxelCount; i++)
+    {
+        stream << static_cast<unsigned short>(i % 4096);
+    }
+    return fileName;
+}
+} // namespace
+
+TEST_CASE("Mapped and streamed volumes hold the same voxels")
+{
+    QTemporaryDir dir;
+    QString fileName = writeVolume(dir, 3, 4, 5, 3 * 4 * 5);
+
+    auto streamed =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    auto mapped =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::MemoryMapped);
+    REQUIRE(streamed);
+    REQUIRE(mapped);
+    CHECK(streamed->loadMode() == VolumeData::LoadMode::Stream);
+    CHECK(mapped->dimensions() == QVector3D(3, 4, 5));
+    REQUIRE(mapped->voxels().size() == 3 * 4 * 5);
+    CHECK(std::equal(mapped->voxels().begin(), mapped->voxels().end(),
+                     streamed->voxels().begin()));
+}
+
+TEST_CASE("Slabs can be read out of order")
+{
+    QTemporaryDir dir;
+    QString fileName = writeVolume(dir, 3, 4, 5, 3 * 4 * 5);
+    auto volumeData =
+        VolumeData::open(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    CHECK(volumeData->readSlices(3, 2));
+    CHECK(volumeData->readSlices(0, 3));
+    CHECK_FALSE(volumeData->readSlices(4, 2));
+    for (int i = 0; i < 3 * 4 * 5; i++)
+    {
+        CHECK(volumeData->voxels()[i] == i);
+    }
+}
+
+TEST_CASE("Truncated volumes are rejected")
+{
+    QTemporaryDir dir;
+    QString fileName = writeVolume(dir, 3, 4, 5, 3 * 4 * 5 - 1);
+    CHECK_FALSE(VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream));
+    CHECK_FALSE(
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::MemoryMapped));
+}
+
+TEST_CASE("Histogram is normalized to the most frequent value")
+{
+    QTemporaryDir dir;
+    QString fileName = writeVolume(dir, 2, 2, 2, 8);
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::MemoryMapped);
+    REQUIRE(volumeData);
+    auto histogram = volumeData->normalizedHistogram();
+    REQUIRE(histogram.size() == VolumeData::HISTOGRAM_BINS);
+    CHECK(histogram[0] == 1.0f);
+    CHECK(histogram[7] == 1.0f);
+    CHECK(histogram[8] == 0.0f);
+}
+
+TEST_CASE("Pyramid stops at the minimum size")
+{
+    CHECK(VolumePyramid::levelCount(256, 256, 256) == 3);
+    CHECK(VolumePyramid::levelCount(32, 32, 32) == 0);
+    CHECK(VolumePyramid::levelCount(512, 512, 100) == 4);
+}
+
+TEST_CASE("Pyramid levels preserve the average and the maximum")
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("volume.dat");
+    {
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        const unsigned short size = 65;
+        stream << size << size << size;
+        for (int i = 0; i < size * size * size; i++)
+        {
+            // A single bright voxel in the leftover last slice.
+            stream << static_cast<unsigned short>(
+                i == size * size * size - 1 ? 4095 : 100);
+        }
+    }
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    auto pyramid = VolumePyramid::build(*volumeData);
+    REQUIRE(pyramid->levels().size() == 1);
+    const auto& level = pyramid->levels().front();
+    CHECK(level.width == 32);
+    CHECK(level.average.front() == 100);
+    CHECK(level.maximum.front() == 100);
+    CHECK(level.maximum.back() == 4095);
+}
+
+TEST_CASE("Empty space grid follows the opacity of the transfer function")
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("volume.dat");
+    {
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        const unsigned short width = 48;
+        const unsigned short size = 16;
+        stream << width << size << size;
+        for (int i = 0; i < width * size * size; i++)
+        {
+            // A single bright voxel inside the last of three blocks.
+            stream << static_cast<unsigned short>(i == 40 ? 4095 : 0);
+        }
+    }
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    auto grid = EmptySpaceGrid::build(*volumeData);
+    REQUIRE(grid->blockCount() == 3);
+
+    std::vector<float> opacity(256, 0.0f);
+    opacity.back() = 1.0f;
+    auto occupancy = grid->occupancy(opacity, VolumeData::INTENSITY_SCALE);
+    REQUIRE(occupancy.size() == 3 * EmptySpaceGrid::OCCUPANCY_CHANNELS);
+    CHECK(occupancy[0] == 0);
+    CHECK(occupancy[1] == 0);
+    CHECK(occupancy[2] == 0);
+    // Only coarser levels filter across into the neighbouring block.
+    CHECK(occupancy[3] == 1);
+    CHECK(occupancy[4] == 1);
+    CHECK(occupancy[5] == 1);
+
+    std::fill(opacity.begin(), opacity.end(), 0.0f);
+    opacity.front() = 0.5f;
+    occupancy = grid->occupancy(opacity, VolumeData::INTENSITY_SCALE);
+    CHECK(std::all_of(occupancy.begin(), occupancy.end(),
+                      [](unsigned char visible) { return visible == 1; }));
+
+    std::fill(opacity.begin(), opacity.end(), 0.0f);
+    occupancy = grid->occupancy(opacity, VolumeData::INTENSITY_SCALE);
+    CHECK(std::all_of(occupancy.begin(), occupancy.end(),
+                      [](unsigned char visible) { return visible == 0; }));
+}
+
+TEST_CASE("Proxy geometry bounds the visible blocks")
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("volume.dat");
+    {
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        const unsigned short width = 40;
+        const unsigned short size = 16;
+        stream << width << size << size;
+        for (int i = 0; i < width * size * size; i++)
+        {
+            // A single bright voxel inside the last, partial block.
+            stream << static_cast<unsigned short>(i == 36 ? 4095 : 0);
+        }
+    }
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    auto grid = EmptySpaceGrid::build(*volumeData);
+    REQUIRE(grid->blockCount() == 3);
+    const QVector3D dimensions(40, 16, 16);
+
+    std::vector<float> opacity(256, 0.0f);
+    opacity.back() = 1.0f;
+    auto occupancy = grid->occupancy(opacity, VolumeData::INTENSITY_SCALE);
+
+    // The last block alone is a box of 6 faces, clamped to the volume.
+    auto vertices = ProxyGeometry::build(occupancy, 0, *grid, dimensions);
+    REQUIRE(vertices.size() == 6 * 6);
+    for (const auto& vertex : vertices)
+    {
+        CHECK((vertex.x() == doctest::Approx(0.6f) ||
+               vertex.x() == doctest::Approx(1.0f)));
+        CHECK(std::abs(vertex.y()) == doctest::Approx(1.0f));
+        CHECK(std::abs(vertex.z()) == doctest::Approx(1.0f));
+    }
+    // Every triangle faces away from the centre of the box.
+    const QVector3D centre(0.8f, 0.0f, 0.0f);
+    for (std::size_t i = 0; i < vertices.size(); i += 3)
+    {
+        const QVector3D normal = QVector3D::crossProduct(
+            vertices[i + 1] - vertices[i], vertices[i + 2] - vertices[i]);
+        CHECK(QVector3D::dotProduct(normal, vertices[i] - centre) > 0.0f);
+    }
+
+    // The dilated occupancy covers all three blocks, and the faces between
+    // them are left out.
+    vertices = ProxyGeometry::build(occupancy, 1, *grid, dimensions);
+    CHECK(vertices.size() == (2 + 4 * 3) * 6);
+
+    std::fill(opacity.begin(), opacity.end(), 0.0f);
+    occupancy = grid->occupancy(opacity, VolumeData::INTENSITY_SCALE);
+    CHECK(ProxyGeometry::build(occupancy, 1, *grid, dimensions).empty());
+}
+
+TEST_CASE("Gradients point along increasing intensity")
+{
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("volume.dat");
+    {
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        const unsigned short size = 5;
+        stream << size << size << size;
+        for (int i = 0; i < size * size * size; i++)
+        {
+            stream << static_cast<unsigned short>(1000 + (i % size) * 100);
+        }
+    }
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    const std::size_t center = ((2 * 5 + 2) * 5 + 2) * GradientVolume::CHANNELS;
+    for (auto kernel : {GradientVolume::Kernel::CentralDifference,
+                        GradientVolume::Kernel::Sobel})
+    {
+        auto gradients = GradientVolume::build(*volumeData, kernel);
+        const auto& texels = gradients->texels();
+        REQUIRE(texels.size() == 5 * 5 * 5 * GradientVolume::CHANNELS);
+        CHECK(texels[center] == 255);
+        CHECK(texels[center + 1] == 128);
+        CHECK(texels[center + 2] == 128);
+        CHECK(texels[center + 3] > 0);
+        // The zero border outside the volume makes its faces slope.
+        CHECK(texels[3] > 0);
+    }
+}
+
+TEST_CASE("AVX2 and scalar gradients are the same")
+{
+    if (!GradientVolume::avx2Supported())
+        return;
+    QTemporaryDir dir;
+    QString fileName = dir.filePath("volume.dat");
+    // Rows of two AVX2 blocks and a scalar tail, of noise next to a block of
+    // zeros where the gradient vanishes.
+    const unsigned short width = 21, height = 6, depth = 5;
+    {
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        QDataStream stream(&file);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream << width << height << depth;
+        for (int z = 0; z < depth; z++)
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                {
+                    const int i = (z * height + y) * width + x;
+                    stream << static_cast<unsigned short>(
+                        x < 10 && z < 3 ? 0 : (i * 7919) % 4096);
+                }
+    }
+    auto volumeData =
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream);
+    REQUIRE(volumeData);
+    for (auto kernel : {GradientVolume::Kernel::CentralDifference,
+                        GradientVolume::Kernel::Sobel})
+    {
+        const auto scalar = GradientVolume::build(
+            *volumeData, kernel, GradientVolume::Instructions::Scalar);
+        const auto avx2 = GradientVolume::build(
+            *volumeData, kernel, GradientVolume::Instructions::Avx2);
+        CHECK(scalar->texels() == avx2->texels());
+    }
+}
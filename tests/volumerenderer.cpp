@@ -0,0 +1,241 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+
+#include "../geometry/plane.h"
+#include "../renderers/cpuraycaster.h"
+#include "../renderers/lightrenderer.h"
+#include "../renderers/volumerenderer.h"
+#include "../texturestore.h"
+#include "testvolumes.h"
+
+#include "../vendor/doctest/doctest.h"
+
+#include <QDebug>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QSurfaceFormat>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+
+// Renders into a framebuffer object of an offscreen context, run by ctest on
+// Mesa's llvmpipe so no display or GPU is needed.
+
+namespace
+{
+constexpr int SIZE = 64;
+constexpr qint64 VOLUME_BYTES = static_cast<qint64>(SIZE) * SIZE * SIZE * 2;
+const QSize IMAGE_SIZE(256, 256);
+// Frames drawn at most for the bricks a view needs to become resident.
+constexpr int MAX_FRAMES = 32;
+
+// A ball that is brightest at its centre and fades out to nothing at a third
+// of the volume's size.
+QString writeBallVolume(const QTemporaryDir& dir)
+{
+    const QString fileName = dir.filePath("ball.dat");
+    writeSphereVolume(fileName, SIZE, 2.0f / 3.0f);
+    return fileName;
+}
+
+// The 3D view's volume renderer without the widget. The texture budget
+// decides whether the volume is bricked, and whether its gradients are
+// precomputed.
+class OffscreenView
+{
+  public:
+    OffscreenView(const QString& fileName, qint64 textureBudget)
+        : m_textureStore(std::make_unique<TextureStore>()),
+          m_viewPort(IMAGE_SIZE.width(), IMAGE_SIZE.height()),
+          m_lightRenderer(m_camera, m_settings),
+          m_renderer(m_textureStore, m_settings, m_camera, m_openGLExtra,
+                     m_viewPort, m_lightRenderer, m_plane),
+          m_framebuffer(IMAGE_SIZE,
+                        QOpenGLFramebufferObject::CombinedDepthStencil)
+    {
+        m_openGLExtra.initializeOpenGLFunctions();
+        m_camera.moveCamera(QVector3D(0, 0, -4));
+        m_camera.updateProjectionMatrix(
+            static_cast<float>(IMAGE_SIZE.width()) / IMAGE_SIZE.height());
+
+        m_transferFunction.setColorMap(tfn::ColorMap{});
+        m_transferFunction.updateTransferFunction();
+        m_textureStore->transferFunction().setTransferFunction(
+            m_transferFunction);
+
+        Volume& volume = m_textureStore->volume();
+        volume.setTextureBudget(textureBudget);
+        QEventLoop loop;
+        QObject::connect(&volume, &Volume::loaderFinished, &loop,
+                         &QEventLoop::quit);
+        volume.load(fileName);
+        loop.exec();
+        m_renderer.compileShader();
+    }
+
+    // Draws until no bricks are missing, without jitter.
+    QImage render()
+    {
+        m_framebuffer.bind();
+        m_openGLExtra.glViewport(0, 0, IMAGE_SIZE.width(), IMAGE_SIZE.height());
+        m_settings.generation++;
+        for (int frame = 0; frame < MAX_FRAMES; frame++)
+        {
+            m_openGLExtra.glClearColor(0.95f, 0.95f, 0.95f, 1.0f);
+            m_openGLExtra.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            m_renderer.setRaySampling(1.0f, 0.0f, -1);
+            m_renderer.paint();
+            // The first frames upload the volume and request its bricks.
+            if (frame > 1 && !m_renderer.bricksPending())
+                break;
+        }
+        m_openGLExtra.glFinish();
+        m_framebuffer.release();
+        return m_framebuffer.toImage();
+    }
+
+    bool bricked() const { return m_textureStore->volume().bricked(); }
+    const CameraProperties& camera() const { return m_camera; }
+    const std::vector<float>& transferFunction() const
+    {
+        return m_transferFunction.getColorMapData();
+    }
+    RenderSettings& settings() { return m_settings; }
+    VolumeRenderer& renderer() { return m_renderer; }
+
+  private:
+    RenderSettings m_settings;
+    tfn::TransferFunction m_transferFunction;
+    std::unique_ptr<ITextureStore> m_textureStore;
+    QOpenGLExtraFunctions m_openGLExtra;
+    CameraProperties m_camera;
+    ViewPort m_viewPort;
+    Plane m_plane;
+    LightRenderer m_lightRenderer;
+    VolumeRenderer m_renderer;
+    QOpenGLFramebufferObject m_framebuffer;
+};
+
+// The largest difference of any channel of any pixel.
+int maxDifference(const QImage& a, const QImage& b)
+{
+    REQUIRE(a.size() == b.size());
+    int difference = 0;
+    for (int y = 0; y < a.height(); y++)
+        for (int x = 0; x < a.width(); x++)
+        {
+            const QRgb p = a.pixel(x, y);
+            const QRgb q = b.pixel(x, y);
+            difference = std::max({difference, std::abs(qRed(p) - qRed(q)),
+                                   std::abs(qGreen(p) - qGreen(q)),
+                                   std::abs(qBlue(p) - qBlue(q))});
+        }
+    return difference;
+}
+
+bool drawsVolume(const QImage& image)
+{
+    const QRgb background = qRgb(242, 242, 242);
+    for (int y = 0; y < image.height(); y++)
+        for (int x = 0; x < image.width(); x++)
+            if (std::abs(qRed(image.pixel(x, y)) - qRed(background)) > 8)
+                return true;
+    return false;
+}
+} // namespace
+
+TEST_CASE("A bricked volume pages in the same image as a whole one")
+{
+    QTemporaryDir dir;
+    const QString fileName = writeBallVolume(dir);
+    // Room for the volume but not its gradients, and too little for either.
+    OffscreenView whole(fileName, 2 * VOLUME_BYTES);
+    OffscreenView bricked(fileName, VOLUME_BYTES / 2);
+
+    const QImage wholeImage = whole.render();
+    const QImage brickedImage = bricked.render();
+    REQUIRE(!whole.bricked());
+    REQUIRE(bricked.bricked());
+    CHECK(!bricked.renderer().bricksPending());
+    CHECK(drawsVolume(wholeImage));
+    // Both sample the same R16F voxels, the atlas through its aprons.
+    CHECK(maxDifference(wholeImage, brickedImage) <= 2);
+}
+
+TEST_CASE("Clipped or not, the image matches the CPU raycaster")
+{
+    QTemporaryDir dir;
+    const QString fileName = writeBallVolume(dir);
+    // Gradients are taken from the volume on both sides.
+    OffscreenView view(fileName, 2 * VOLUME_BYTES);
+    CpuRaycaster raycaster(
+        VolumeData::fromFile(fileName, VolumeData::LoadMode::Stream));
+    raycaster.setTransferFunction(view.transferFunction());
+    // The light position of the 3D view is not known to the CPU raycaster.
+    view.settings().headLight = true;
+
+    for (const std::vector<Plane>& cutPlanes :
+         {std::vector<Plane>{}, std::vector<Plane>{Plane(QVector4D(1, 0, 0, 0)),
+                                                  Plane(QVector4D(0, 1, 1, 0))}})
+    {
+        CAPTURE(cutPlanes.size());
+        view.renderer().setCutPlanes(cutPlanes);
+        raycaster.setCutPlanes(cutPlanes);
+        const QImage image = view.render();
+        CHECK(drawsVolume(image));
+        // The GPU filters half float voxels and transfer function entries.
+        CHECK(maxDifference(image, raycaster.render(view.camera(),
+                                                    view.settings(),
+                                                    IMAGE_SIZE)) <= 4);
+    }
+}
+
+TEST_CASE("Proxy geometry skips empty space without changing the image")
+{
+    QTemporaryDir dir;
+    const QString fileName = writeBallVolume(dir);
+    OffscreenView view(fileName, 2 * VOLUME_BYTES);
+
+    for (const std::vector<Plane>& cutPlanes :
+         {std::vector<Plane>{}, std::vector<Plane>{Plane(QVector4D(1, 0, 0, 0))}})
+    {
+        CAPTURE(cutPlanes.size());
+        view.renderer().setCutPlanes(cutPlanes);
+        view.renderer().setProxyGeometry(false);
+        const QImage box = view.render();
+        view.renderer().setProxyGeometry(true);
+        const QImage proxy = view.render();
+        CHECK(drawsVolume(proxy));
+        // Samples are placed by a multiple of the step rather than by
+        // adding it up, which may round differently.
+        CHECK(maxDifference(box, proxy) <= 1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setMajorVersion(4);
+    format.setMinorVersion(5);
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setProfile(QSurfaceFormat::CompatibilityProfile);
+    format.setOption(QSurfaceFormat::DeprecatedFunctions, true);
+    QSurfaceFormat::setDefaultFormat(format);
+    QGuiApplication app{argc, argv};
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+    QOpenGLContext context;
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        qDebug() << "Unable to create an OpenGL context";
+        return 1;
+    }
+
+    doctest::Context tests(argc, argv);
+    return tests.run();
+}
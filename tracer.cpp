@@ -0,0 +1,170 @@
+#include "tracer.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+// Recording stops after this many events, about 100 MB of them, so that a
+// session left running does not grow without bound.
+constexpr qint64 MAX_EVENTS = 4 * 1024 * 1024;
+constexpr int GPU_TRACK = 0;
+
+struct Event
+{
+    const char* name;
+    qint64 start;
+    qint64 end;
+};
+
+// The events of one thread, or of the GPU. Only its own thread appends to
+// a track, the lock is there for write().
+struct Track
+{
+    int id;
+    QString name;
+    std::mutex mutex;
+    std::vector<Event> events;
+};
+
+// Tracks outlive their threads, the loader thread is gone by the time the
+// trace is written.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Track>> tracks;
+    std::atomic<qint64> eventCount{0};
+};
+
+Registry& registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+std::shared_ptr<Track> addTrack(int id, const QString& name)
+{
+    auto track = std::make_shared<Track>();
+    track->id = id;
+    track->name = name;
+    Registry& tracks = registry();
+    std::lock_guard lock(tracks.mutex);
+    tracks.tracks.push_back(track);
+    return track;
+}
+
+Track& threadTrack()
+{
+    static std::atomic<int> nextId{GPU_TRACK + 1};
+    thread_local std::shared_ptr<Track> track = [] {
+        const int id = nextId++;
+        return addTrack(id, QString("Thread %1").arg(id));
+    }();
+    return *track;
+}
+
+Track& gpuTrack()
+{
+    static std::shared_ptr<Track> track = addTrack(GPU_TRACK, "GPU");
+    return *track;
+}
+
+void record(Track& track, const char* name, qint64 start, qint64 end)
+{
+    if (registry().eventCount.fetch_add(1, std::memory_order_relaxed) >=
+        MAX_EVENTS)
+        return;
+    std::lock_guard lock(track.mutex);
+    track.events.push_back({name, start, end});
+}
+
+QString quoted(const QString& text)
+{
+    QString escaped = text;
+    escaped.replace('\\', "\\\\").replace('"', "\\\"");
+    return '"' + escaped + '"';
+}
+
+QString microseconds(qint64 nanoseconds)
+{
+    return QString::number(nanoseconds / 1000.0, 'f', 3);
+}
+} // namespace
+
+Tracer::Zone::Zone(const char* name) : m_name{name}, m_start{now()} {}
+
+Tracer::Zone::~Zone()
+{
+    record(threadTrack(), m_name, m_start, now());
+}
+
+qint64 Tracer::now()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+void Tracer::setThreadName(const QString& name)
+{
+    Track& track = threadTrack();
+    std::lock_guard lock(track.mutex);
+    track.name = name;
+}
+
+void Tracer::gpuSpan(const char* name, qint64 start, qint64 end)
+{
+    record(gpuTrack(), name, start, end);
+}
+
+QString Tracer::fileName()
+{
+    return qEnvironmentVariable("STRANGEVIS_TRACE", "strangevis.trace.json");
+}
+
+bool Tracer::write(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qDebug() << "Unable to write" << fileName;
+        return false;
+    }
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+        << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": 1, "
+           "\"tid\": 0, \"args\": {\"name\": \"strangevis\"}}";
+
+    Registry& tracks = registry();
+    std::lock_guard registryLock(tracks.mutex);
+    for (const auto& track : tracks.tracks)
+    {
+        std::lock_guard lock(track->mutex);
+        out << ",\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, "
+               "\"tid\": "
+            << track->id << ", \"args\": {\"name\": " << quoted(track->name)
+            << "}}";
+        for (const Event& event : track->events)
+        {
+            out << ",\n{\"ph\": \"X\", \"name\": \"" << event.name
+                << "\", \"pid\": 1, \"tid\": " << track->id
+                << ", \"ts\": " << microseconds(event.start)
+                << ", \"dur\": " << microseconds(event.end - event.start)
+                << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    const qint64 events = tracks.eventCount.load();
+    if (events > MAX_EVENTS)
+        qDebug() << "Trace full," << events - MAX_EVENTS << "events dropped";
+    return out.status() == QTextStream::Ok;
+}
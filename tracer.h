@@ -0,0 +1,61 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+
+// Records where time goes as Chrome trace events, which chrome://tracing and
+// ui.perfetto.dev show with one track per thread, so the loader thread and
+// the GUI thread line up on a single timeline.
+//
+// Zones are only recorded when built with the STRANGEVIS_TRACING CMake
+// option, TRACE_ZONE and TRACE_THREAD_NAME compile to nothing otherwise. The
+// application writes the trace when it exits, to the file named by the
+// STRANGEVIS_TRACE environment variable or to strangevis.trace.json.
+class Tracer
+{
+  public:
+#ifdef STRANGEVIS_TRACING
+    constexpr static bool ENABLED = true;
+#else
+    constexpr static bool ENABLED = false;
+#endif
+
+    // Records the time from its construction to its destruction on the
+    // calling thread. The name must outlive the tracer, a string literal.
+    class Zone
+    {
+      public:
+        explicit Zone(const char* name);
+        ~Zone();
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+      private:
+        const char* m_name;
+        qint64 m_start;
+    };
+
+    // Nanoseconds on the clock all events are recorded with.
+    static qint64 now();
+    static void setThreadName(const QString& name);
+    // A span measured on the GPU, already converted to the tracer's clock.
+    // GPU spans get a track of their own.
+    static void gpuSpan(const char* name, qint64 start, qint64 end);
+
+    static QString fileName();
+    // Writes everything recorded so far. Returns false if the file could
+    // not be written.
+    static bool write(const QString& fileName);
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#ifdef STRANGEVIS_TRACING
+#define TRACE_ZONE(name) Tracer::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Tracer::setThreadName(name)
+#else
+#define TRACE_ZONE(name)
+#define TRACE_THREAD_NAME(name)
+#endif
+
+#endif // TRACER_H
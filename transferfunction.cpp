@@ -2,16 +2,89 @@
 
 #include "transfertexture.h"
 
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
 namespace tfn
 {
 
 TransferFunction::TransferFunction()
+    : m_curveX(size::NUM_POINTS, 0.0f), m_curveY(size::NUM_POINTS, 0.0f)
 {
-    m_interpolatedPoints = QList<QPointF>(size::NUM_POINTS, QPointF(0, 0));
     reset();
     interpolatePoints();
 };
 
+std::optional<TransferFunction>
+TransferFunction::fromFile(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Unable to open" << fileName;
+        return std::nullopt;
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "Invalid transfer function" << fileName << ":"
+                 << error.errorString();
+        return std::nullopt;
+    }
+
+    QList<ControlPoint> controlPoints;
+    for (const QJsonValue& value : document.object()["controlPoints"].toArray())
+    {
+        const QJsonObject object = value.toObject();
+        ControlPoint point(
+            QPointF(object["x"].toDouble(-1), object["y"].toDouble(-1)));
+        const QJsonArray nodes = object["nodes"].toArray();
+        if (nodes.size() == 2)
+        {
+            point.setAllControlNodes(
+                {QPointF(nodes[0][0].toDouble(), nodes[0][1].toDouble()),
+                 QPointF(nodes[1][0].toDouble(), nodes[1][1].toDouble())});
+        }
+        controlPoints.append(point);
+    }
+
+    const auto outOfRange = [](const ControlPoint& point) {
+        return point.x() < points::START_POINT.x() ||
+               point.x() > points::END_POINT.x() ||
+               point.y() < points::START_POINT.y() ||
+               point.y() > points::END_POINT.y();
+    };
+    if (controlPoints.size() < 2 ||
+        controlPoints.front().x() != points::START_POINT.x() ||
+        controlPoints.back().x() != points::END_POINT.x() ||
+        std::any_of(controlPoints.begin(), controlPoints.end(), outOfRange) ||
+        !std::is_sorted(controlPoints.begin(), controlPoints.end(),
+                        [](const ControlPoint& a, const ControlPoint& b) {
+                            return a.x() < b.x();
+                        }))
+    {
+        qDebug() << "Invalid control points in" << fileName;
+        return std::nullopt;
+    }
+
+    TransferFunction tfn;
+    tfn.m_controlPoints = controlPoints;
+    // Keeps the nodes within the bounds the editor would have given them.
+    for (int i = 0; i < controlPoints.size() - 1; i++)
+    {
+        const auto& nodes = controlPoints[i].getControlNodes();
+        tfn.setControlNodePos(i, Nodes::NODE0, nodes.value(Nodes::NODE0));
+        tfn.setControlNodePos(i, Nodes::NODE1, nodes.value(Nodes::NODE1));
+    }
+    tfn.interpolatePoints();
+    return tfn;
+}
+
 void TransferFunction::reset()
 {
     m_controlPoints.clear();
@@ -65,82 +138,119 @@ void TransferFunction::updateTransferFunction()
 
 void TransferFunction::applyTransferFunction()
 {
-    for (int i = 0; i < m_interpolatedPoints.length(); i++)
+    if (m_cmapData.size() != static_cast<std::size_t>(size::ARRAY_SIZE))
+        return;
+    for (int i = m_dirtyBegin; i < m_dirtyEnd; i++)
     {
-        m_cmapData[(i * size::NUM_CHANNELS) + 3] =
-            m_interpolatedPoints.at(i).y();
+        m_cmapData[(i * size::NUM_CHANNELS) + 3] = m_curveY[i];
     };
+    m_dirtyBegin = m_dirtyEnd = 0;
 }
 
 void TransferFunction::setColorMap(ColorMap cmap)
 {
     m_cmapData = cmap.colorMapData();
+    // The colour map brings its own alpha, all of it has to be replaced.
+    m_dirtyBegin = 0;
+    m_dirtyEnd = size::NUM_POINTS;
 }
 
 void TransferFunction::interpolatePoints()
 {
+    std::vector<Segment> segments;
+    segments.reserve(m_controlPoints.size());
     int from_x = 0;
     for (int i = 0; i < m_controlPoints.length() - 1; i++)
     {
-        auto x = m_controlPoints[i + 1].x();
-        int target_x = static_cast<int>(x * (tfn::size::NUM_POINTS - 1));
-        for (int t = from_x; t <= target_x; t++)
+        const ControlPoint& from = m_controlPoints[i];
+        const ControlPoint& target = m_controlPoints[i + 1];
+        const int target_x =
+            static_cast<int>(target.x() * (tfn::size::NUM_POINTS - 1));
+        const QPointF cp0 = from.getControlNodes().value(Nodes::NODE0);
+        const QPointF cp1 = from.getControlNodes().value(Nodes::NODE1);
+        segments.push_back(
+            {{static_cast<float>(from.x()), static_cast<float>(from.y()),
+              static_cast<float>(cp0.x()), static_cast<float>(cp0.y()),
+              static_cast<float>(cp1.x()), static_cast<float>(cp1.y()),
+              static_cast<float>(target.x()), static_cast<float>(target.y())},
+             from_x,
+             std::max(from_x, target_x + 1)});
+        from_x = target_x + 1;
+    }
+
+    // Segments are ordered by the first texel they cover, any segment
+    // that starts at the same texel and is otherwise unchanged is still
+    // valid.
+    m_evaluatedEntries = 0;
+    for (const Segment& segment : segments)
+    {
+        auto previous = std::lower_bound(
+            m_segments.begin(), m_segments.end(), segment.begin,
+            [](const Segment& s, int begin) { return s.begin < begin; });
+        if (previous != m_segments.end() && *previous == segment)
+            continue;
+        evaluateSegment(segment, m_curveX.data() + segment.begin,
+                        m_curveY.data() + segment.begin);
+        if (m_dirtyBegin >= m_dirtyEnd)
         {
-            const QPointF from = m_controlPoints.at(i);
-            const QPointF target = m_controlPoints.at(i + 1);
-            if (target_x - from_x == 0) {
-                continue;
-            }
-            QPointF cp0 =
-                m_controlPoints[i].getControlNodes().value(Nodes::NODE0);
-            QPointF cp1 =
-                m_controlPoints[i].getControlNodes().value(Nodes::NODE1);
-            float perc = (t - from_x) / static_cast<float>(target_x - from_x);
-            QPointF interpolatedPoint =
-                deCasteljau(from, QPointF(cp0.x(), cp0.y()),
-                            QPointF(cp1.x(), cp1.y()), target, perc);
-            m_interpolatedPoints.replace(t, interpolatedPoint);
+            m_dirtyBegin = segment.begin;
+            m_dirtyEnd = segment.end;
         }
-        from_x = target_x + 1;
+        else
+        {
+            m_dirtyBegin = std::min(m_dirtyBegin, segment.begin);
+            m_dirtyEnd = std::max(m_dirtyEnd, segment.end);
+        }
+        m_evaluatedEntries += segment.end - segment.begin;
     }
+    m_segments = std::move(segments);
 };
 
-// De Casteljau's algorithm for cubic bezier splines
-constexpr QPointF TransferFunction::deCasteljau(QPointF p0, QPointF p1,
-                                                QPointF p2, QPointF p3, float t)
+// Cubic Bézier in Bernstein form, the same curve De Casteljau's algorithm
+// gives but without dependencies between the texels of a segment.
+void TransferFunction::evaluateSegment(const Segment& segment, float* x,
+                                       float* y)
 {
+    auto [x0, y0, x1, y1, x2, y2, x3, y3] = segment.points;
+    const int count = segment.end - segment.begin;
 
-    if (p0.x() == p3.x())
+    // A vertical segment takes the value of its higher end.
+    if (x0 == x3)
     {
-        return p0.y() > p3.y() ? p0 : p3;
+        const bool first = y0 > y3;
+        std::fill(x, x + count, first ? x0 : x3);
+        std::fill(y, y + count, first ? y0 : y3);
+        return;
     }
+    y0 = y0 == 1.0f ? y0 - 0.001f : y0;
+    y3 = y3 == 1.0f ? y3 - 0.001f : y3;
 
-    p0 = p0.y() == 1.0f ? QPointF(p0.x(), p0.y() - 0.001f) : p0;
-    p3 = p3.y() == 1.0f ? QPointF(p3.x(), p3.y() - 0.001f) : p3;
-
-    float xa = getPt(p0.x(), p1.x(), t);
-    float ya = getPt(p0.y(), p1.y(), t);
-    float xb = getPt(p1.x(), p2.x(), t);
-    float yb = getPt(p1.y(), p2.y(), t);
-    float xc = getPt(p2.x(), p3.x(), t);
-    float yc = getPt(p2.y(), p3.y(), t);
-
-    float xm = getPt(xa, xb, t);
-    float ym = getPt(ya, yb, t);
-    float xn = getPt(xb, xc, t);
-    float yn = getPt(yb, yc, t);
-
-    float x = getPt(xm, xn, t);
-    float y = getPt(ym, yn, t);
-
-    return QPointF(x, y);
-};
+    const float step = count > 1 ? 1.0f / (count - 1) : 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        const float t = i * step;
+        const float s = 1.0f - t;
+        const float b0 = s * s * s;
+        const float b1 = 3.0f * s * s * t;
+        const float b2 = 3.0f * s * t * t;
+        const float b3 = t * t * t;
+        x[i] = b0 * x0 + b1 * x1 + b2 * x2 + b3 * x3;
+        y[i] = b0 * y0 + b1 * y1 + b2 * y2 + b3 * y3;
+    }
+}
 
-constexpr float TransferFunction::getPt(float n1, float n2, float perc)
+QList<QPointF> TransferFunction::getInterpolatedPoints() const
 {
-    float diff = n2 - n1;
-    return n1 + (diff * perc);
-};
+    constexpr int stride = std::max(1, size::NUM_POINTS / size::COLOR_MAP_POINTS);
+    QList<QPointF> points;
+    points.reserve(size::NUM_POINTS / stride + 1);
+    for (int i = 0; i < size::NUM_POINTS; i += stride)
+    {
+        points.append(QPointF(m_curveX[i], m_curveY[i]));
+    }
+    points.append(QPointF(m_curveX.back(), m_curveY.back()));
+    return points;
+}
 
 void TransferFunction::replace(int index, ControlPoint cp)
 {
@@ -5,6 +5,9 @@
 #include <QOpenGLFunctions>
 #include <QPointF>
 #include <QString>
+#include <array>
+#include <optional>
+#include <vector>
 
 namespace tfn
 {
@@ -31,15 +34,28 @@ class ControlPoint : public QPointF
     void setControlNode(Nodes node, QPointF pos);
     void setAllControlNodes(QList<QPointF> nodes);
     QMap<Nodes, QPointF>& getControlNodes() { return m_controlNodes; };
+    const QMap<Nodes, QPointF>& getControlNodes() const
+    {
+        return m_controlNodes;
+    };
 
   private:
      QMap<Nodes, QPointF> m_controlNodes;
 };
 
+// The opacity curve is a chain of cubic Bézier segments between the control
+// points, evaluated into one entry per transfer function texel. Each segment
+// remembers what it was evaluated from, so an edit only re-evaluates the
+// segments next to the control point that moved.
 class TransferFunction
 {
   public:
     TransferFunction();
+    // Reads the control points from a JSON file of the form
+    // {"controlPoints": [{"x": 0, "y": 0, "nodes": [[x, y], [x, y]]}, ...]}.
+    // The points must run from x = 0 to x = 1 in order, the nodes of a point
+    // shape the segment to its right and default to the point itself.
+    static std::optional<TransferFunction> fromFile(const QString& fileName);
     void reset();
     bool addControlPoint(ControlPoint cp);
     bool removeControlPoint(ControlPoint point);
@@ -55,16 +71,36 @@ class TransferFunction
 
     void setControlNodePos(int index, Nodes node, QPointF pos);
 
-    QList<QPointF> getInterpolatedPoints() { return m_interpolatedPoints; };
+    // A thinned out copy of the curve for plotting.
+    QList<QPointF> getInterpolatedPoints() const;
+    // The evaluated curve, one entry per texel.
+    const std::vector<float>& curveX() const { return m_curveX; };
+    const std::vector<float>& curveY() const { return m_curveY; };
+    // Entries re-evaluated by the last interpolatePoints().
+    int evaluatedEntries() const { return m_evaluatedEntries; };
+
   private:
-    constexpr static QPointF deCasteljau(QPointF p0, QPointF p1, QPointF p2,
-                                         QPointF p3, float t);
-    constexpr static float getPt(float n1, float n2, float perc);
+    struct Segment
+    {
+        // Start point, the two control nodes and the end point, as x and y.
+        std::array<float, 8> points;
+        // The texels [begin, end) the segment covers.
+        int begin;
+        int end;
+        bool operator==(const Segment&) const = default;
+    };
+    static void evaluateSegment(const Segment& segment, float* x, float* y);
     QPointF clampToNeighbours(int index, ControlPoint point);
     QPointF clampToDomain(ControlPoint point, QPointF min, QPointF max);
 
     QList<ControlPoint> m_controlPoints;
-    QList<QPointF> m_interpolatedPoints;
+    std::vector<Segment> m_segments;
+    std::vector<float> m_curveX;
+    std::vector<float> m_curveY;
+    int m_evaluatedEntries{0};
+    // Entries of the curve not yet copied into the colour map data.
+    int m_dirtyBegin{0};
+    int m_dirtyEnd{0};
     std::vector<GLfloat> m_cmapData;
 };
 
@@ -1,67 +1,182 @@
 #include "transfertexture.h"
 
+#include "preintegrationtable.h"
+#include "tracer.h"
+
 #include <QFile>
 #include <QVector4D>
 #include <QtXml>
+#include <algorithm>
 
 namespace tfn
 {
 
 TransferTexture::TransferTexture(QObject* parent)
-    : QObject(parent), m_transferTexture(QOpenGLTexture::Target1D),
-      m_updateNeeded{true}, m_colorMap{}
+    : QObject(parent), m_colorMap{}
 {
 }
 
 void TransferTexture::setColorMap(std::vector<GLfloat> colormap)
 {
     m_colorMap = colormap;
-    m_updateNeeded = true;
 };
 
 void TransferTexture::setTransferFunction(TransferFunction tfn)
 {
     m_tfn = tfn;
-    m_updateNeeded = true;
+
+    const auto& data = m_tfn.getColorMapData();
+    if (data.size() == static_cast<std::size_t>(size::ARRAY_SIZE))
+    {
+        if (m_data.size() != data.size())
+        {
+            m_data = data;
+            markDirty(0, size::NUM_POINTS);
+        }
+        else
+        {
+            // Dragging a control point only reshapes the curve around it.
+            auto first = std::mismatch(data.begin(), data.end(), m_data.begin());
+            if (first.first != data.end())
+            {
+                auto last = std::mismatch(data.rbegin(), data.rend(),
+                                          m_data.rbegin());
+                const int begin = static_cast<int>(first.first - data.begin()) /
+                                  size::NUM_CHANNELS;
+                const int end =
+                    (static_cast<int>(data.rend() - last.first) - 1) /
+                        size::NUM_CHANNELS +
+                    1;
+                std::copy(data.begin() + begin * size::NUM_CHANNELS,
+                          data.begin() + end * size::NUM_CHANNELS,
+                          m_data.begin() + begin * size::NUM_CHANNELS);
+                markDirty(begin, end);
+            }
+        }
+    }
+
+    std::vector<float> opacity(data.size() / tfn::size::NUM_CHANNELS);
+    for (std::size_t i = 0; i < opacity.size(); i++)
+    {
+        opacity[i] = data[i * tfn::size::NUM_CHANNELS + 3];
+    }
+    if (opacity != m_opacity)
+    {
+        m_opacity = std::move(opacity);
+        m_opacityRevision++;
+    }
 }
 
-void TransferTexture::bind()
+void TransferTexture::markDirty(int begin, int end)
 {
-    if (m_updateNeeded)
+    m_dataRevision++;
+    for (auto& buffer : m_buffers)
     {
-        if (m_transferTexture.isCreated())
+        if (buffer.dirtyBegin >= buffer.dirtyEnd)
         {
-            m_transferTexture.destroy();
+            buffer.dirtyBegin = begin;
+            buffer.dirtyEnd = end;
         }
+        else
+        {
+            buffer.dirtyBegin = std::min(buffer.dirtyBegin, begin);
+            buffer.dirtyEnd = std::max(buffer.dirtyEnd, end);
+        }
+    }
+}
 
-        m_transferTexture.setBorderColor(0, 0, 0, 0);
-        m_transferTexture.setWrapMode(QOpenGLTexture::ClampToEdge);
-        m_transferTexture.setFormat(QOpenGLTexture::RGBA32F);
-        m_transferTexture.setMinificationFilter(QOpenGLTexture::Nearest);
-        m_transferTexture.setMagnificationFilter(QOpenGLTexture::Nearest);
-        m_transferTexture.setAutoMipMapGenerationEnabled(false);
-        m_transferTexture.setMipLevels(0);
-        m_transferTexture.setSize(tfn::size::NUM_POINTS);
-        m_transferTexture.allocateStorage();
-        m_transferTexture.setData(QOpenGLTexture::RGBA, QOpenGLTexture::Float32,
-                                  m_tfn.getColorMapData().data());
-
-        m_updateNeeded = false;
+void TransferTexture::allocate()
+{
+    for (auto& buffer : m_buffers)
+    {
+        QOpenGLTexture& texture = buffer.texture;
+        texture.setBorderColor(0, 0, 0, 0);
+        texture.setWrapMode(QOpenGLTexture::ClampToEdge);
+        texture.setFormat(QOpenGLTexture::RGBA16F);
+        texture.setMinificationFilter(QOpenGLTexture::Nearest);
+        texture.setMagnificationFilter(QOpenGLTexture::Nearest);
+        texture.setAutoMipMapGenerationEnabled(false);
+        texture.setMipLevels(1);
+        texture.setSize(tfn::size::NUM_POINTS);
+        texture.allocateStorage();
+        buffer.dirtyBegin = 0;
+        buffer.dirtyEnd = size::NUM_POINTS;
     }
-    if (m_transferTexture.isCreated())
+}
+
+void TransferTexture::bind()
+{
+    TRACE_ZONE("TransferTexture::bind");
+    if (m_data.empty())
+        return;
+    if (!m_buffers[m_front].texture.isCreated())
+        allocate();
+
+    // New edits go into the texture the last frames did not sample, which
+    // then takes over.
+    if (m_buffers[m_front].dirtyBegin < m_buffers[m_front].dirtyEnd)
     {
-        m_transferTexture.bind();
+        TextureBuffer& back = m_buffers[1 - m_front];
+        const int entries = back.dirtyEnd - back.dirtyBegin;
+        const qsizetype values = static_cast<qsizetype>(entries) *
+                                 size::NUM_CHANNELS;
+        m_uploadBuffer.resize(values);
+        qFloatToFloat16(m_uploadBuffer.data(),
+                        m_data.data() + back.dirtyBegin * size::NUM_CHANNELS,
+                        values);
+        back.texture.setData(back.dirtyBegin, 0, 0, entries, 1, 1,
+                             QOpenGLTexture::RGBA, QOpenGLTexture::Float16,
+                             m_uploadBuffer.data());
+        back.dirtyBegin = back.dirtyEnd = 0;
+        m_front = 1 - m_front;
+
+        m_lastUploadBytes = values * static_cast<qint64>(sizeof(qfloat16));
+        m_totalUploadBytes += m_lastUploadBytes;
     }
+    m_buffers[m_front].texture.bind();
 };
 
 void TransferTexture::release()
 {
-    if (m_transferTexture.isCreated())
+    if (m_buffers[m_front].texture.isCreated())
     {
-        m_transferTexture.release();
+        m_buffers[m_front].texture.release();
     }
 };
 
+void TransferTexture::bindPreIntegration()
+{
+    if (m_data.empty())
+        return;
+    if (!m_preIntegrationTexture.isCreated())
+    {
+        m_preIntegrationTexture.setWrapMode(QOpenGLTexture::ClampToEdge);
+        m_preIntegrationTexture.setFormat(QOpenGLTexture::RGBA16F);
+        m_preIntegrationTexture.setMinificationFilter(QOpenGLTexture::Linear);
+        m_preIntegrationTexture.setMagnificationFilter(QOpenGLTexture::Linear);
+        m_preIntegrationTexture.setAutoMipMapGenerationEnabled(false);
+        m_preIntegrationTexture.setMipLevels(1);
+        m_preIntegrationTexture.setSize(PreIntegrationTable::SIZE,
+                                        PreIntegrationTable::SIZE);
+        m_preIntegrationTexture.allocateStorage();
+        m_preIntegrationRevision = m_dataRevision - 1;
+    }
+    if (m_preIntegrationRevision != m_dataRevision)
+    {
+        const auto table = PreIntegrationTable::build(m_data);
+        m_preIntegrationTexture.setData(QOpenGLTexture::RGBA,
+                                        QOpenGLTexture::Float32, table.data());
+        m_preIntegrationRevision = m_dataRevision;
+    }
+    m_preIntegrationTexture.bind();
+}
+
+void TransferTexture::releasePreIntegration()
+{
+    if (m_preIntegrationTexture.isCreated())
+        m_preIntegrationTexture.release();
+}
+
 ColorMap::ColorMap(QString name, std::vector<GLfloat>& data)
     : m_name{name}, m_colorMapData{data} {};
 
@@ -125,7 +240,7 @@ bool ColorMapStore::loadColorMapsFromFile(QString path)
             std::vector<GLfloat> colors{};
             colors.reserve(tfn::size::ARRAY_SIZE);
             std::vector<QVector4D> sortableColors{};
-            sortableColors.reserve(tfn::size::NUM_POINTS);
+            sortableColors.reserve(tfn::size::COLOR_MAP_POINTS);
 
             while (!child.isNull())
             {
@@ -143,8 +258,24 @@ bool ColorMapStore::loadColorMapsFromFile(QString path)
             std::sort(
                 sortableColors.begin(), sortableColors.end(),
                 [](const auto& c1, const auto& c2) { return c1.w() < c2.w(); });
-            for (const auto& color : sortableColors)
+            if (sortableColors.empty())
+            {
+                component = component.nextSibling().toElement();
+                continue;
+            }
+            // Linear interpolation between the points of the colour map.
+            const float last = static_cast<float>(sortableColors.size() - 1);
+            for (int i = 0; i < tfn::size::NUM_POINTS; i++)
             {
+                const float position =
+                    i * last / static_cast<float>(tfn::size::NUM_POINTS - 1);
+                const auto lower = static_cast<std::size_t>(position);
+                const auto upper =
+                    std::min(lower + 1, sortableColors.size() - 1);
+                const QVector4D color =
+                    sortableColors[lower] +
+                    (sortableColors[upper] - sortableColors[lower]) *
+                        (position - lower);
                 colors.push_back(color.x()); // r
                 colors.push_back(color.y()); // g
                 colors.push_back(color.z()); // b
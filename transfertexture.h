@@ -8,6 +8,8 @@
 #include <QObject>
 #include <QOpenGLFunctions>
 #include <QOpenGLTexture>
+#include <QFloat16>
+#include <array>
 #include <vector>
 
 namespace tfn
@@ -15,7 +17,11 @@ namespace tfn
 
 namespace size
 {
-constexpr static int NUM_POINTS = 256;
+// One entry per intensity of the 12-bit data. Raise to 65536 for full 16-bit
+// data on hardware whose GL_MAX_TEXTURE_SIZE allows it.
+constexpr static int NUM_POINTS = 4096;
+// Entries of every colour map in cmaps.xml, resampled to NUM_POINTS on load.
+constexpr static int COLOR_MAP_POINTS = 256;
 constexpr static int NUM_CHANNELS = 4;
 constexpr static int ARRAY_SIZE = NUM_POINTS * NUM_CHANNELS;
 } // namespace size
@@ -32,6 +38,11 @@ class ColorMap
     QString m_name;
 };
 
+// The transfer function as a 1D half float texture. The storage is allocated
+// once and edits only upload the entries they changed. Two textures take
+// turns, so an upload never waits on a frame that still samples the texture
+// it replaces; each keeps track of the entries it has missed while the other
+// was in use.
 class TransferTexture : public QObject
 {
     Q_OBJECT
@@ -43,16 +54,48 @@ class TransferTexture : public QObject
 
     void bind();
     void release();
+    // The pre-integrated table as a 2D texture, rebuilt on the first bind
+    // after the transfer function changed.
+    void bindPreIntegration();
+    void releasePreIntegration();
+    // Opacity of every entry of the texture, and a counter that changes
+    // whenever it does.
+    const std::vector<float>& opacity() const { return m_opacity; };
+    unsigned int opacityRevision() const { return m_opacityRevision; };
+    // Bytes uploaded for the most recent edit, and over the lifetime of the
+    // texture.
+    qint64 lastUploadBytes() const { return m_lastUploadBytes; };
+    qint64 totalUploadBytes() const { return m_totalUploadBytes; };
 
   public slots:
     void setColorMap(std::vector<GLfloat> cmap);
     void setTransferFunction(TransferFunction tfn);
 
   private:
+    struct TextureBuffer
+    {
+        TextureBuffer() : texture(QOpenGLTexture::Target1D){};
+        QOpenGLTexture texture;
+        // Entries [dirtyBegin, dirtyEnd) differ from the current data.
+        int dirtyBegin{0};
+        int dirtyEnd{size::NUM_POINTS};
+    };
+    void allocate();
+    void markDirty(int begin, int end);
+
     std::vector<GLfloat> m_colorMap;
     TransferFunction m_tfn;
-    QOpenGLTexture m_transferTexture;
-    bool m_updateNeeded;
+    std::vector<GLfloat> m_data;
+    std::vector<qfloat16> m_uploadBuffer;
+    std::array<TextureBuffer, 2> m_buffers;
+    int m_front{0};
+    std::vector<float> m_opacity;
+    unsigned int m_opacityRevision{0};
+    QOpenGLTexture m_preIntegrationTexture{QOpenGLTexture::Target2D};
+    unsigned int m_dataRevision{0};
+    unsigned int m_preIntegrationRevision{0};
+    qint64 m_lastUploadBytes{0};
+    qint64 m_totalUploadBytes{0};
 };
 
 class IColorMapStore
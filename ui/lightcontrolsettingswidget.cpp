@@ -5,7 +5,6 @@ LightControlSettingsWidget::LightControlSettingsWidget(
     const std::shared_ptr<ISharedProperties> properties, QWidget* parent)
     : m_properties{properties}, QWidget(parent)
 {
-    m_renderSettings = {};
     m_layout = new QVBoxLayout();
     setupSettings();
     setupWidgets();
@@ -47,14 +46,9 @@ void LightControlSettingsWidget::setupSettings()
 
     connect(&m_properties->renderSettings(),
             &RenderSettingsProperties::renderSettingsChanged,
-            [this](auto settings) {
-                if (settings.contains("maxInt"))
-                {
-                    m_boolCheckboxes["headLight"]->setEnabled(
-                        !std::get<bool>(settings["maxInt"]));
-                    m_floatSliders["diffuseInt"]->setEnabled(
-                        !std::get<bool>(settings["maxInt"]));
-                }
+            [this](const RenderSettings& settings) {
+                m_boolCheckboxes["headLight"]->setEnabled(!settings.maxInt);
+                m_floatSliders["diffuseInt"]->setEnabled(!settings.maxInt);
             });
 };
 
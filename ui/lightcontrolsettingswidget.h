@@ -26,7 +26,6 @@ class LightControlSettingsWidget : public QWidget
     const std::shared_ptr<ISharedProperties> m_properties;
 
     QVBoxLayout* m_layout;
-    RenderSettings m_renderSettings;
     QMap<QString, FloatSlider*> m_floatSliders;
     QMap<QString, BoolCheckbox*> m_boolCheckboxes;
     QMap<QString, IntSlider*> m_intSliders;
@@ -19,6 +19,10 @@ MainWindowWidget::MainWindowWidget(QWidget* p_3dRenderWidget,
 
     m_mainWindowLayout->addLayout(m_3dRenderLayout, 3);
     m_mainWindowLayout->addLayout(m_2dRenderLayout, 2);
+
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setGeometry(16, 16, 320, 16);
+    m_progressBar->hide();
 }
 
 QVBoxLayout* MainWindowWidget::create2dRenderLayout()
@@ -41,13 +45,25 @@ void MainWindowWidget::toggleFileLoadingInProgressOverlay(bool state)
 {
     if (state)
     {
-        m_progressBar = new QProgressBar(this);
-        m_progressBar->setGeometry(16, 16, 320, 16);
+        // Busy indicator until the first progress report arrives.
         m_progressBar->setMaximum(0);
         m_progressBar->setMinimum(0);
         m_progressBar->raise();
         m_progressBar->show();
     }
     else
-        delete m_progressBar;
+        m_progressBar->hide();
+}
+
+void MainWindowWidget::updateFileLoadingProgress(qint64 bytesLoaded,
+                                                 qint64 bytesTotal)
+{
+    // QProgressBar only takes ints, which the byte counts of large volumes
+    // overflow.
+    m_progressBar->setMaximum(PROGRESS_STEPS);
+    m_progressBar->setValue(
+        static_cast<int>(bytesLoaded * PROGRESS_STEPS / bytesTotal));
+    m_progressBar->setFormat(QString("%1 / %2 MiB")
+                                 .arg(bytesLoaded / (1024 * 1024))
+                                 .arg(bytesTotal / (1024 * 1024)));
 }
@@ -19,8 +19,10 @@ class MainWindowWidget : public QWidget
                      QWidget* parent);
   public slots:
     void toggleFileLoadingInProgressOverlay(bool state);
+    void updateFileLoadingProgress(qint64 bytesLoaded, qint64 bytesTotal);
 
   private:
+    constexpr static int PROGRESS_STEPS = 1000;
     QProgressBar* m_progressBar;
     QVBoxLayout* create3dRenderLayout();
     QVBoxLayout* create2dRenderLayout();
@@ -4,7 +4,6 @@ RenderSettingsWidget::RenderSettingsWidget(
     const std::shared_ptr<ISharedProperties> properties, QWidget* parent)
     : m_properties{properties}, QWidget(parent)
 {
-    m_renderSettings = {};
     m_layout = new QVBoxLayout();
     setupSettings();
     setupWidgets();
@@ -36,6 +35,11 @@ void RenderSettingsWidget::setupSettings()
     sliceNr->setEnabled(!m_boolCheckboxes["defaultSliceNr"]->getValue());
     m_intSliders.insert("sliceNr", sliceNr);
 
+    m_boolCheckboxes.insert("preIntegration",
+                            new BoolCheckbox("Pre-integration:", false));
+    m_boolCheckboxes.insert("computeRaycaster",
+                            new BoolCheckbox("Compute shader:", false));
+
     connect(m_boolCheckboxes["defaultSliceNr"], &BoolCheckbox::valueChanged,
             [this](bool vis) { m_intSliders["sliceNr"]->setEnabled(!vis); });
 
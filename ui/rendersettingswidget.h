@@ -16,7 +16,8 @@ namespace Settings
 {
 static QList<QString>
     RENDER_SETTINGS_ORDER({"maxInt", "showSlice", "sliceModel",
-                    "sliceSide", "defaultSliceNr", "sliceNr"});
+                    "sliceSide", "defaultSliceNr", "sliceNr",
+                    "preIntegration", "computeRaycaster"});
 }; // namespace Settings
 
 class SliderWidget : public QWidget
@@ -102,7 +103,6 @@ class RenderSettingsWidget : public QWidget
     const std::shared_ptr<ISharedProperties> m_properties;
 
     QVBoxLayout* m_layout;
-    RenderSettings m_renderSettings;
     QMap<QString, FloatSlider*> m_floatSliders;
     QMap<QString, BoolCheckbox*> m_boolCheckboxes;
     QMap<QString, IntSlider*> m_intSliders;
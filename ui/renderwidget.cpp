@@ -19,6 +19,8 @@ StackedRayCastingWidget::StackedRayCastingWidget(
         new RayCastingInteractor{textureStore, properties, m_camera, this, f};
     m_imguizmoWidget = new ImguizmoWidget{
         properties, m_camera, renderSettings, lightSettings, this, f};
+    m_imguizmoWidget->setResolutionScaler(
+        &m_rayCastingWidget->resolutionScaler());
     m_imguizmoWidget->setAttribute(Qt::WA_TranslucentBackground);
     m_imguizmoWidget->setAttribute(Qt::WA_AlwaysStackOnTop);
     m_layout = new QStackedLayout(this);
@@ -86,6 +88,12 @@ RayCastingInteractor::RayCastingInteractor(
     connect(&m_properties.get()->clippingPlane(),
             &ClippingPlaneProperties::clippingPlaneChanged, this,
             [this](const Plane& plane) { updateClippingPlane(plane); });
+    connect(&m_properties.get()->clippingPlane(),
+            &ClippingPlaneProperties::cutPlanesChanged, this,
+            &RayCastingInteractor::updateCutPlanes);
+    connect(&m_properties.get()->clippingPlane(),
+            &ClippingPlaneProperties::cropBoxChanged, this,
+            &RayCastingInteractor::updateCropBox);
 
     connect(&m_properties.get()->transferFunction(),
             &tfn::TransferProperties::transferFunctionChanged, this,
@@ -96,8 +104,11 @@ RayCastingInteractor::RayCastingInteractor(
             &RayCastingInteractor::changeTransferFunction);
 
     connect(&m_properties.get()->renderSettings(),
-            &RenderSettingsProperties::renderSettingsChanged, this,
-            &RayCastingInteractor::changeRenderSettings);
+            &RenderSettingsProperties::renderSettingChanged, this,
+            [this](RenderSetting setting) {
+                changeRenderSetting(
+                    m_properties->renderSettings().renderSettings(), setting);
+            });
     connect(&m_properties->clippingPlane(),
             &ClippingPlaneProperties::selectedPointChanged,
             [this]() { update(); });
@@ -153,13 +164,9 @@ void RayCastingInteractor::wheelEvent(QWheelEvent* p_event)
 
 void RayCastingInteractor::moveLightSource()
 {
-    std::visit(
-        [this](const auto& arg) {
-            if (!arg)
-                RayCastingWidget::moveLightSource(arcballVector(
-                    m_currentPosition.x(), m_currentPosition.y()));
-        },
-        m_properties.get()->renderSettings().renderSettings().at("headLight"));
+    if (!m_properties->renderSettings().renderSettings().headLight)
+        RayCastingWidget::moveLightSource(
+            arcballVector(m_currentPosition.x(), m_currentPosition.y()));
 }
 
 void RayCastingInteractor::rotateCamera()
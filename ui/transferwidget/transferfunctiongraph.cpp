@@ -204,8 +204,11 @@ void TransferFunctionGraph::updateGradient()
     m_gradient = QLinearGradient(QPointF(0, 0), QPointF(1, 0));
     m_gradient.setCoordinateMode(QGradient::ObjectBoundingMode);
 
-    auto cmap = m_tfn.getColorMapData();
-    for (int i = 0; i < tfn::size::NUM_POINTS; i++)
+    const auto& cmap = m_tfn.getColorMapData();
+    // Every texel as a gradient stop would be far too slow to redraw while
+    // dragging, one per colour map entry looks the same.
+    constexpr int stride = tfn::size::NUM_POINTS / tfn::size::COLOR_MAP_POINTS;
+    for (int i = 0; i < tfn::size::NUM_POINTS; i += stride)
     {
         float r = cmap.at(i * tfn::size::NUM_CHANNELS);
         float g = cmap.at(i * tfn::size::NUM_CHANNELS + 1);
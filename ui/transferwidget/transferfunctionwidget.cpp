@@ -72,7 +72,9 @@ ColorMapSelector::ColorMapSelector(
 
         const auto colorMapData =
             colorMapStore->colorMap(colorMapName).colorMapData();
-        for (int i = 0; i < tfn::size::NUM_POINTS; i++)
+        constexpr int stride =
+            tfn::size::NUM_POINTS / tfn::size::COLOR_MAP_POINTS;
+        for (int i = 0; i < tfn::size::NUM_POINTS; i += stride)
         {
             float r = colorMapData.at(i * tfn::size::NUM_CHANNELS);
             float g = colorMapData.at(i * tfn::size::NUM_CHANNELS + 1);
@@ -1,41 +1,132 @@
 #include "volume.h"
 
-#include "vendor/inireader/INIReader.h"
+#include "proxygeometry.h"
+#include "tracer.h"
 
-#include <QDataStream>
 #include <QDebug>
-#include <QFile>
+#include <QElapsedTimer>
 #include <QMatrix4x4>
-#include <execution>
+#include <algorithm>
+
+namespace
+{
+qint64 textureBytes(const QOpenGLTexture& texture, int bytesPerTexel)
+{
+    if (!texture.isCreated())
+        return 0;
+    qint64 bytes = 0;
+    for (int level = 0; level < texture.mipLevels(); level++)
+    {
+        bytes += static_cast<qint64>(std::max(1, texture.width() >> level)) *
+                 std::max(1, texture.height() >> level) *
+                 std::max(1, texture.depth() >> level) * bytesPerTexel;
+    }
+    return bytes;
+}
+} // namespace
 
 Volume::Volume(QObject* parent)
     : QObject(parent), m_volumeTexture(QOpenGLTexture::Target3D),
+      m_maximumTexture(QOpenGLTexture::Target3D),
+      m_occupancyTexture(QOpenGLTexture::Target3D),
+      m_gradientTexture(QOpenGLTexture::Target3D),
       m_updateNeeded(false), m_dims{1.0, 1.0, 1.0}, m_spacing{1.0, 1.0, 1.0}
 {
 }
 
-void Volume::load(const QString& fileName)
+void Volume::load(const QString& fileName, VolumeData::LoadMode loadMode)
 {
-    VolumeLoader* volumeLoader = new VolumeLoader(fileName, this);
-    connect(volumeLoader, &VolumeLoader::volumeLoaded,
-            [this](const std::vector<unsigned short>& volumeData) {
+    TRACE_ZONE("Volume::load");
+    if (m_loader)
+    {
+        m_loader->requestInterruption();
+    }
+    VolumeLoader* volumeLoader = new VolumeLoader(fileName, loadMode, m_textureBudget, this);
+    m_loader = volumeLoader;
+    connect(volumeLoader, &VolumeLoader::volumeAllocated, this,
+            [this, volumeLoader](std::shared_ptr<const VolumeData> volumeData) {
+                if (volumeLoader != m_loader)
+                    return;
                 m_updateNeeded = true;
-                m_volumeData = volumeData;
-                emit volumeLoaded();
+                m_volumeData = std::move(volumeData);
+                m_dims = m_volumeData->dimensions();
+                m_pyramid.reset();
+                m_pyramidUploadNeeded = false;
+                m_emptySpaceGrid.reset();
+                m_occupancyUpdateNeeded = true;
+                m_gradients.reset();
+                m_gradientUploadNeeded = true;
+                m_loadedSlices = 0;
+                m_uploadedSlices = 0;
+                m_uploadedMipLevels = 1;
+                m_uploadedBytes = 0;
+                m_uploadNanoseconds = 0;
+                emit volumeUpdated();
+            });
+    connect(volumeLoader, &VolumeLoader::slicesLoaded, this,
+            [this, volumeLoader](int loadedSlices) {
+                if (volumeLoader != m_loader)
+                    return;
+                m_loadedSlices = loadedSlices;
+                emit volumeUpdated();
+            });
+    connect(volumeLoader, &VolumeLoader::volumeLoaded, this,
+            [this, volumeLoader]() {
+                if (volumeLoader == m_loader)
+                    emit volumeLoaded();
+            });
+    connect(volumeLoader, &VolumeLoader::pyramidBuilt, this,
+            [this, volumeLoader](std::shared_ptr<const VolumePyramid> pyramid) {
+                if (volumeLoader != m_loader)
+                    return;
+                m_pyramid = std::move(pyramid);
+                m_pyramidUploadNeeded = true;
+                emit volumeUpdated();
+            });
+    connect(volumeLoader, &VolumeLoader::emptySpaceGridBuilt, this,
+            [this, volumeLoader](std::shared_ptr<const EmptySpaceGrid> grid) {
+                if (volumeLoader != m_loader)
+                    return;
+                m_emptySpaceGrid = std::move(grid);
+                m_occupancyUpdateNeeded = true;
+                emit volumeUpdated();
+            });
+    connect(volumeLoader, &VolumeLoader::gradientsComputed, this,
+            [this, volumeLoader](std::shared_ptr<const GradientVolume> gradients) {
+                if (volumeLoader != m_loader)
+                    return;
+                m_gradients = std::move(gradients);
+                m_gradientUploadNeeded = true;
+                emit volumeUpdated();
             });
-    connect(volumeLoader, &VolumeLoader::dimensionsChanged,
-            [this](QVector3D dims) { m_dims = dims; });
     connect(volumeLoader, &VolumeLoader::loadingStartedOrStopped, this,
-            &Volume::loadingStartedOrStopped);
+            [this, volumeLoader](bool loadingInProgress) {
+                if (volumeLoader != m_loader)
+                    return;
+                m_loadingInProgress = loadingInProgress;
+                emit loadingStartedOrStopped(loadingInProgress);
+            });
+    connect(volumeLoader, &VolumeLoader::loadingProgressChanged, this,
+            [this, volumeLoader](qint64 bytesLoaded, qint64 bytesTotal) {
+                if (volumeLoader == m_loader)
+                    emit loadingProgressChanged(bytesLoaded, bytesTotal);
+            });
+    connect(volumeLoader, &VolumeLoader::finished, this,
+            [this, volumeLoader]() {
+                if (volumeLoader == m_loader)
+                    emit loaderFinished();
+            });
     connect(volumeLoader, &VolumeLoader::finished, volumeLoader,
             &VolumeLoader::deleteLater);
     connect(volumeLoader, &VolumeLoader::gridSpacingChanged, this,
-            [this](QVector3D spacing) { m_spacing = spacing; });
+            [this, volumeLoader](QVector3D spacing) {
+                if (volumeLoader == m_loader)
+                    m_spacing = spacing;
+            });
     connect(volumeLoader, &VolumeLoader::histogramCalculated, this,
-            &Volume::histogramCalculated);
-    connect(volumeLoader, &VolumeLoader::loadingStartedOrStopped, this,
-            [this](bool loadingInProgress) {
-                m_loadingInProgress = loadingInProgress;
+            [this, volumeLoader](std::vector<float> histogramData) {
+                if (volumeLoader == m_loader)
+                    emit histogramCalculated(std::move(histogramData));
             });
     volumeLoader->start();
 }
@@ -47,6 +138,40 @@ QMatrix4x4 Volume::modelMatrix() const
     return modelMatrix;
 }
 
+float Volume::loadedDepth() const
+{
+    if (!m_volumeData)
+        return 1.0f;
+    return static_cast<float>(m_loadedSlices) / m_volumeData->depth();
+}
+
+qint64 Volume::cpuBytes() const
+{
+    qint64 bytes = m_volumeData ? m_volumeData->byteCount() : 0;
+    if (m_pyramid)
+    {
+        for (const auto& level : m_pyramid->levels())
+            bytes += static_cast<qint64>(level.average.size() +
+                                         level.maximum.size()) *
+                     sizeof(unsigned short);
+    }
+    if (m_gradients)
+        bytes += static_cast<qint64>(m_gradients->texels().size());
+    // Minimum and maximum, plain and dilated.
+    if (m_emptySpaceGrid)
+        bytes += static_cast<qint64>(m_emptySpaceGrid->blockCount()) * 4 *
+                 sizeof(unsigned short);
+    return bytes;
+}
+
+qint64 Volume::gpuBytes() const
+{
+    return textureBytes(m_volumeTexture, 2) +
+           textureBytes(m_maximumTexture, 2) +
+           textureBytes(m_occupancyTexture, 2) +
+           textureBytes(m_gradientTexture, 4) + m_brickCache.gpuBytes();
+}
+
 QVector3D Volume::scaleFactor() const
 {
     QVector3D factor = m_dims * m_spacing;
@@ -54,116 +179,277 @@ QVector3D Volume::scaleFactor() const
     return factor;
 }
 
-VolumeLoader::VolumeLoader(const QString& fileName, QObject* parent)
-    : QThread{parent}, m_fileName{fileName}
+VolumeLoader::VolumeLoader(const QString& fileName,
+                           VolumeData::LoadMode loadMode, qint64 textureBudget,
+                           QObject* parent)
+    : QThread{parent}, m_fileName{fileName}, m_loadMode{loadMode},
+      m_textureBudget{textureBudget}
 {
 }
 void VolumeLoader::run()
 {
+    TRACE_THREAD_NAME("Volume loader");
+    TRACE_ZONE("VolumeLoader::run");
     loadIni();
     load();
 }
 
 void VolumeLoader::loadIni()
 {
-    QString fileName = m_fileName;
-    fileName.chop(3);
-    fileName.append("ini");
-
-    INIReader reader{fileName.toStdString()};
-    if (reader.ParseError() != 0)
-    {
-        qDebug() << "INI-file not loaded.";
-        emit gridSpacingChanged(UNIFORM_GRID_DIMENSIONS);
-    }
-    float x = reader.GetFloat("DatFile", "oldDat Spacing X", 1);
-    float y = reader.GetFloat("DatFile", "oldDat Spacing Y", 1);
-    float z = reader.GetFloat("DatFile", "oldDat Spacing Z", 1);
-    qDebug() << "X:" << x << "Y:" << y << "Z:" << z;
-    emit gridSpacingChanged(QVector3D(x, y, z));
+    TRACE_ZONE("VolumeLoader::loadIni");
+    emit gridSpacingChanged(VolumeData::gridSpacing(m_fileName));
 }
 
 void VolumeLoader::load()
 {
-    QFile file(m_fileName);
-
-    if (!file.open(QIODevice::ReadOnly))
+    TRACE_ZONE("VolumeLoader::load");
+    emit loadingStartedOrStopped(true);
+    auto volumeData = VolumeData::open(m_fileName, m_loadMode);
+    if (!volumeData)
     {
-        qDebug() << "Unable to open " << m_fileName << "!";
+        emit loadingStartedOrStopped(false);
         return;
     }
-    emit loadingStartedOrStopped(true);
-    QDataStream stream(&file);
-    stream.setByteOrder(QDataStream::LittleEndian);
-
-    unsigned short width = 0, height = 0, depth = 0;
-    stream >> width >> height >> depth;
+    // The texture storage is allocated up front, every finished slab is then
+    // uploaded into it while the following slab is being read.
+    emit volumeAllocated(volumeData);
 
-    qDebug() << "Width:" << width;
-    qDebug() << "Height:" << height;
-    qDebug() << "Depth:" << depth;
-
-    std::vector<unsigned short> volumeData;
-    int volumeSize = static_cast<int>(width) * static_cast<int>(height) *
-                     static_cast<int>(depth);
-    volumeData.resize(volumeSize);
-    if (stream.readRawData(reinterpret_cast<char*>(volumeData.data()),
-                           volumeSize * sizeof(unsigned short)) !=
-        volumeSize * sizeof(unsigned short))
+    const int slabSlices = static_cast<int>(
+        std::max<qint64>(1, SLAB_BYTES / volumeData->sliceByteCount()));
+    for (int slice = 0; slice < volumeData->depth(); slice += slabSlices)
     {
-        emit loadingStartedOrStopped(false);
-        return;
+        if (isInterruptionRequested())
+            return;
+        const int sliceCount =
+            std::min(slabSlices, volumeData->depth() - slice);
+        {
+            TRACE_ZONE("VolumeData::readSlices");
+            if (!volumeData->readSlices(slice, sliceCount))
+            {
+                emit loadingStartedOrStopped(false);
+                return;
+            }
+        }
+        emit slicesLoaded(slice + sliceCount);
+        emit loadingProgressChanged((slice + sliceCount) *
+                                        volumeData->sliceByteCount(),
+                                    volumeData->byteCount());
     }
-    std::array<std::atomic<unsigned long long>, 4096> histogramData{};
-    std::for_each(std::execution::par_unseq, volumeData.begin(),
-                  volumeData.end(), [&histogramData](auto& elem) {
-                      histogramData[elem]++;
-                      elem *= 16;
-                  });
-    emit volumeLoaded(volumeData);
-    emit dimensionsChanged(QVector3D(width, height, depth));
+    emit volumeLoaded();
     emit loadingStartedOrStopped(false);
-    unsigned long long maxCount =
-        *std::max_element(histogramData.begin(), histogramData.end());
-    std::vector<float> normalizedHistogramData(4096, 0);
-    std::transform(std::execution::par_unseq, histogramData.begin(),
-                   histogramData.end(), normalizedHistogramData.begin(),
-                   [maxCount](const auto& elem) {
-                       return static_cast<float>(elem) / maxCount;
-                   });
-    emit histogramCalculated(normalizedHistogramData);
+    // A loader replaced by a newer one stops before each of the stages
+    // below, which would otherwise compete with it for the cores.
+    if (isInterruptionRequested())
+        return;
+    emit histogramCalculated(volumeData->normalizedHistogram());
+    // Rendering uses level 0 alone until the coarser levels arrive.
+    if (isInterruptionRequested())
+        return;
+    {
+        TRACE_ZONE("VolumePyramid::build");
+        emit pyramidBuilt(VolumePyramid::build(*volumeData));
+    }
+    if (isInterruptionRequested())
+        return;
+    {
+        TRACE_ZONE("EmptySpaceGrid::build");
+        emit emptySpaceGridBuilt(EmptySpaceGrid::build(*volumeData));
+    }
+    // Packed gradients take twice the memory of the volume itself.
+    if (3 * volumeData->byteCount() <= m_textureBudget)
+    {
+        if (isInterruptionRequested())
+            return;
+        TRACE_ZONE("GradientVolume::build");
+        emit gradientsComputed(GradientVolume::build(*volumeData));
+    }
 }
 
 void Volume::bind()
 {
+    TRACE_ZONE("Volume::bind");
     if (m_updateNeeded)
     {
         initializeOpenGLFunctions();
+        allocateTexture();
+        m_updateNeeded = false;
+    }
+    if (m_uploadedSlices < m_loadedSlices)
+    {
+        uploadSlices();
+    }
+    if (m_pyramidUploadNeeded)
+    {
+        uploadPyramid();
+        m_pyramidUploadNeeded = false;
+    }
+    if (m_gradientUploadNeeded)
+    {
+        uploadGradients();
+        m_gradientUploadNeeded = false;
+    }
 
-        if (m_volumeTexture.isCreated())
-        {
-            m_volumeTexture.destroy();
-        }
+    if (m_volumeTexture.isCreated())
+    {
+        m_volumeTexture.bind();
+    }
+}
+
+void Volume::allocateTexture()
+{
+    TRACE_ZONE("Volume::allocateTexture");
+    if (m_volumeTexture.isCreated())
+    {
+        m_volumeTexture.destroy();
+    }
+    if (m_maximumTexture.isCreated())
+    {
+        m_maximumTexture.destroy();
+    }
+
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+    m_bricked = m_volumeData->byteCount() > m_textureBudget ||
+                std::max({m_volumeData->width(), m_volumeData->height(),
+                          m_volumeData->depth()}) > maxTextureSize;
+    if (m_bricked)
+    {
+        // The volume texture is only allocated once the pyramid provides a
+        // coarse copy that stands in for bricks that are not resident.
+        m_brickCache.allocate(m_volumeData);
+        return;
+    }
+    m_brickCache.reset();
+
+    m_volumeTexture.setBorderColor(0, 0, 0, 0);
+    m_volumeTexture.setWrapMode(QOpenGLTexture::ClampToBorder);
+    m_volumeTexture.setFormat(QOpenGLTexture::R16F);
+    // Levels are picked explicitly in the shader, blending between them
+    // would double the fetches for little gain.
+    m_volumeTexture.setMinificationFilter(
+        QOpenGLTexture::LinearMipMapNearest);
+    m_volumeTexture.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_volumeTexture.setAutoMipMapGenerationEnabled(false);
+    m_volumeTexture.setSize(m_dims.x(), m_dims.y(), m_dims.z());
+    m_volumeTexture.setMipLevels(
+        1 + VolumePyramid::levelCount(m_dims.x(), m_dims.y(), m_dims.z()));
+    // Uses immutable storage where available, so the slabs and the pyramid
+    // levels only ever need sub-image updates.
+    m_volumeTexture.allocateStorage();
+    m_volumeTexture.setMipMaxLevel(0);
+}
+
+void Volume::uploadSlices()
+{
+    TRACE_ZONE("Volume::uploadSlices");
+    if (m_bricked)
+    {
+        m_uploadedSlices = m_loadedSlices;
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const int sliceCount = m_loadedSlices - m_uploadedSlices;
+    const void* data = m_volumeData->voxels().data() +
+                       m_uploadedSlices * m_volumeData->sliceVoxelCount();
+    m_volumeTexture.setData(0, 0, m_uploadedSlices, m_dims.x(), m_dims.y(),
+                            sliceCount, QOpenGLTexture::Red,
+                            QOpenGLTexture::UInt16, data);
+    m_uploadedBytes += sliceCount * m_volumeData->sliceByteCount();
+    m_uploadNanoseconds += timer.nsecsElapsed();
+    m_uploadedSlices = m_loadedSlices;
+}
+
+void Volume::uploadPyramid()
+{
+    TRACE_ZONE("Volume::uploadPyramid");
+    const auto& levels = m_pyramid->levels();
+    if (levels.empty())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    if (m_bricked)
+    {
+        const auto& coarsest = levels.back();
         m_volumeTexture.setBorderColor(0, 0, 0, 0);
         m_volumeTexture.setWrapMode(QOpenGLTexture::ClampToBorder);
         m_volumeTexture.setFormat(QOpenGLTexture::R16F);
         m_volumeTexture.setMinificationFilter(QOpenGLTexture::Linear);
         m_volumeTexture.setMagnificationFilter(QOpenGLTexture::Linear);
         m_volumeTexture.setAutoMipMapGenerationEnabled(false);
-        m_volumeTexture.setSize(m_dims.x(), m_dims.y(), m_dims.z());
+        m_volumeTexture.setSize(coarsest.width, coarsest.height,
+                                coarsest.depth);
+        m_volumeTexture.setMipLevels(1);
         m_volumeTexture.allocateStorage();
+        m_volumeTexture.setData(0, 0, 0, coarsest.width, coarsest.height,
+                                coarsest.depth, QOpenGLTexture::Red,
+                                QOpenGLTexture::UInt16,
+                                coarsest.average.data());
+        m_uploadedBytes += static_cast<qint64>(coarsest.average.size()) *
+                           sizeof(unsigned short);
+        m_uploadNanoseconds += timer.nsecsElapsed();
+        return;
+    }
 
-        void* data = reinterpret_cast<void*>(m_volumeData.data());
-        m_volumeTexture.setData(0, 0, 0, m_dims.x(), m_dims.y(), m_dims.z(),
-                                QOpenGLTexture::Red, QOpenGLTexture::UInt16,
-                                data);
-        m_updateNeeded = false;
+    const auto& base = levels.front();
+    m_maximumTexture.setBorderColor(0, 0, 0, 0);
+    m_maximumTexture.setWrapMode(QOpenGLTexture::ClampToBorder);
+    m_maximumTexture.setFormat(QOpenGLTexture::R16F);
+    m_maximumTexture.setMinificationFilter(
+        QOpenGLTexture::LinearMipMapNearest);
+    m_maximumTexture.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_maximumTexture.setAutoMipMapGenerationEnabled(false);
+    m_maximumTexture.setSize(base.width, base.height, base.depth);
+    m_maximumTexture.setMipLevels(static_cast<int>(levels.size()));
+    m_maximumTexture.allocateStorage();
+
+    for (int i = 0; i < static_cast<int>(levels.size()); i++)
+    {
+        const auto& level = levels[i];
+        m_volumeTexture.setData(0, 0, 0, level.width, level.height,
+                                level.depth, i + 1, QOpenGLTexture::Red,
+                                QOpenGLTexture::UInt16, level.average.data());
+        m_maximumTexture.setData(0, 0, 0, level.width, level.height,
+                                 level.depth, i, QOpenGLTexture::Red,
+                                 QOpenGLTexture::UInt16, level.maximum.data());
+        m_uploadedBytes += static_cast<qint64>(level.average.size() +
+                                               level.maximum.size()) *
+                           sizeof(unsigned short);
     }
+    m_uploadNanoseconds += timer.nsecsElapsed();
+    m_uploadedMipLevels = 1 + static_cast<int>(levels.size());
+    m_volumeTexture.setMipMaxLevel(m_uploadedMipLevels - 1);
+}
 
-    if (m_volumeTexture.isCreated())
+void Volume::uploadGradients()
+{
+    TRACE_ZONE("Volume::uploadGradients");
+    if (m_gradientTexture.isCreated())
     {
-        m_volumeTexture.bind();
+        m_gradientTexture.destroy();
     }
+    if (!m_gradients || m_bricked)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    m_gradientTexture.setBorderColor(0, 0, 0, 0);
+    m_gradientTexture.setWrapMode(QOpenGLTexture::ClampToBorder);
+    m_gradientTexture.setFormat(QOpenGLTexture::RGBA8_UNorm);
+    m_gradientTexture.setMinificationFilter(
+        QOpenGLTexture::LinearMipMapNearest);
+    m_gradientTexture.setMagnificationFilter(QOpenGLTexture::Linear);
+    m_gradientTexture.setAutoMipMapGenerationEnabled(false);
+    m_gradientTexture.setSize(m_dims.x(), m_dims.y(), m_dims.z());
+    m_gradientTexture.setMipLevels(m_gradientTexture.maximumMipLevels());
+    m_gradientTexture.allocateStorage();
+    m_gradientTexture.setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+                              m_gradients->texels().data());
+    // Coarser levels shade the samples of the matching pyramid level.
+    m_gradientTexture.generateMipMaps();
+    m_uploadedBytes += static_cast<qint64>(m_gradients->texels().size());
+    m_uploadNanoseconds += timer.nsecsElapsed();
 }
 
 void Volume::release()
@@ -173,3 +459,118 @@ void Volume::release()
         m_volumeTexture.release();
     }
 }
+
+bool Volume::updateBricks()
+{
+    if (!m_bricked)
+        return false;
+    return m_brickCache.update(m_loadedSlices);
+}
+
+void Volume::bindBricks(int atlasUnit, int pageTableUnit)
+{
+    if (m_bricked)
+        m_brickCache.bind(atlasUnit, pageTableUnit);
+}
+
+void Volume::releaseBricks()
+{
+    if (m_bricked)
+        m_brickCache.release();
+}
+
+void Volume::bindMaximumPyramid()
+{
+    if (m_maximumTexture.isCreated())
+    {
+        m_maximumTexture.bind();
+    }
+}
+
+void Volume::releaseMaximumPyramid()
+{
+    if (m_maximumTexture.isCreated())
+    {
+        m_maximumTexture.release();
+    }
+}
+
+void Volume::updateOccupancy(const std::vector<float>& opacity,
+                             unsigned int opacityRevision)
+{
+    if (!m_occupancyUpdateNeeded && opacityRevision == m_occupancyRevision)
+        return;
+    m_occupancyUpdateNeeded = false;
+    m_occupancyRevision = opacityRevision;
+
+    if (!m_emptySpaceGrid)
+    {
+        if (m_occupancyTexture.isCreated())
+            m_occupancyTexture.destroy();
+        m_proxyGeometry.clear();
+        m_proxyGeometryRevision++;
+        return;
+    }
+    const auto occupancy =
+        m_emptySpaceGrid->occupancy(opacity, intensityScale());
+    // The dilated channel, as the proxy bounds the samples of every level.
+    m_proxyGeometry =
+        ProxyGeometry::build(occupancy, 1, *m_emptySpaceGrid, m_dims);
+    m_proxyGeometryRevision++;
+    if (!m_occupancyTexture.isCreated() ||
+        m_occupancyTexture.width() != m_emptySpaceGrid->width() ||
+        m_occupancyTexture.height() != m_emptySpaceGrid->height() ||
+        m_occupancyTexture.depth() != m_emptySpaceGrid->depth())
+    {
+        if (m_occupancyTexture.isCreated())
+            m_occupancyTexture.destroy();
+        m_occupancyTexture.setFormat(QOpenGLTexture::RG8U);
+        m_occupancyTexture.setMinificationFilter(QOpenGLTexture::Nearest);
+        m_occupancyTexture.setMagnificationFilter(QOpenGLTexture::Nearest);
+        m_occupancyTexture.setWrapMode(QOpenGLTexture::ClampToEdge);
+        m_occupancyTexture.setAutoMipMapGenerationEnabled(false);
+        m_occupancyTexture.setSize(m_emptySpaceGrid->width(),
+                                   m_emptySpaceGrid->height(),
+                                   m_emptySpaceGrid->depth());
+        m_occupancyTexture.allocateStorage();
+    }
+    m_occupancyTexture.setData(QOpenGLTexture::RG_Integer,
+                               QOpenGLTexture::UInt8, occupancy.data());
+}
+
+void Volume::bindOccupancy()
+{
+    if (m_occupancyTexture.isCreated())
+    {
+        m_occupancyTexture.bind();
+    }
+}
+
+void Volume::releaseOccupancy()
+{
+    if (m_occupancyTexture.isCreated())
+    {
+        m_occupancyTexture.release();
+    }
+}
+
+bool Volume::emptySpaceSkipping() const
+{
+    return m_emptySpaceGrid && m_occupancyTexture.isCreated();
+}
+
+void Volume::bindGradients()
+{
+    if (m_gradientTexture.isCreated())
+    {
+        m_gradientTexture.bind();
+    }
+}
+
+void Volume::releaseGradients()
+{
+    if (m_gradientTexture.isCreated())
+    {
+        m_gradientTexture.release();
+    }
+}
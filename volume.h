@@ -1,51 +1,159 @@
 #ifndef VOLUME_H
 #define VOLUME_H
 
+#include "brickcache.h"
+#include "emptyspacegrid.h"
+#include "gradientvolume.h"
+#include "volumedata.h"
+#include "volumepyramid.h"
+
 #include <QObject>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLTexture>
+#include <QPointer>
 #include <QThread>
 #include <QVector3D>
 #include <QVector>
 
+class VolumeLoader;
+
 class Volume : public QObject, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
   public:
     explicit Volume(QObject* parent = nullptr);
-    void load(const QString& filename);
+    void load(const QString& filename, VolumeData::LoadMode loadMode =
+                                           VolumeData::LoadMode::MemoryMapped);
     const QVector3D& getDimensions() const { return m_dims; };
     QMatrix4x4 modelMatrix() const;
 
     void bind();
     void release();
+    // Volumes larger than the texture budget, or than the largest 3D texture
+    // the driver supports, are paged through a BrickCache instead of being
+    // uploaded as a whole. Takes effect on the next load.
+    void setTextureBudget(qint64 bytes) { m_textureBudget = bytes; };
+    bool bricked() const { return m_bricked; };
+    // Streams in the bricks the raycaster requested during its last frame.
+    // Returns true while requested bricks are still missing.
+    bool updateBricks();
+    void bindBricks(int atlasUnit, int pageTableUnit);
+    void releaseBricks();
+    int brickSize() const { return BrickCache::BRICK_SIZE; };
+    // Rederives which blocks of the volume are visible when the opacity of
+    // the transfer function has changed since the last call.
+    void updateOccupancy(const std::vector<float>& opacity,
+                         unsigned int opacityRevision);
+    void bindOccupancy();
+    void releaseOccupancy();
+    // False until the empty space grid has been built and its occupancy
+    // uploaded.
+    bool emptySpaceSkipping() const;
+    int emptySpaceBlockSize() const { return EmptySpaceGrid::BLOCK_SIZE; };
+    // Triangles around the blocks visible at any level, rebuilt along with
+    // the occupancy. The revision changes whenever the mesh does.
+    const std::vector<QVector3D>& proxyGeometry() const
+    {
+        return m_proxyGeometry;
+    };
+    unsigned int proxyGeometryRevision() const
+    {
+        return m_proxyGeometryRevision;
+    };
+    // Binds the precomputed gradients, which are only available for volumes
+    // that leave room for them in the texture budget.
+    void bindGradients();
+    void releaseGradients();
+    bool precomputedGradients() const
+    {
+        return m_gradients && m_gradientTexture.isCreated();
+    };
+    // Binds the maximum-preserving pyramid. Its level i holds level i + 1 of
+    // the volume, as level 0 would only duplicate the volume texture.
+    void bindMaximumPyramid();
+    void releaseMaximumPyramid();
+    // Number of mip levels of the volume texture that may be sampled. Stays
+    // at 1 until the pyramid has been built and uploaded.
+    int mipLevels() const { return m_uploadedMipLevels; };
     QVector3D scaleFactor() const;
+    float intensityScale() const { return VolumeData::INTENSITY_SCALE; };
+    // Fraction of the volume along z, in texture coordinates, that has been
+    // loaded so far. Samples beyond it are undefined and must be skipped.
+    float loadedDepth() const;
     bool loadingInProgress() const {return m_loadingInProgress;};
+    // Memory held for the current volume: the voxels, pyramid, gradients and
+    // empty space grid on the CPU, and their textures on the GPU.
+    qint64 cpuBytes() const;
+    qint64 gpuBytes() const;
+    // Texture data uploaded since the current volume started loading, and
+    // the time spent in the calls uploading it. The calls return once the
+    // driver has taken a copy, so this is a lower bound of the transfer time.
+    qint64 uploadedBytes() const { return m_uploadedBytes; };
+    qint64 uploadNanoseconds() const { return m_uploadNanoseconds; };
   signals:
     void volumeLoaded();
+    // The loader has delivered all it builds from the file, the pyramid,
+    // empty space grid and gradients included, or has given up on it.
+    void loaderFinished();
+    void volumeUpdated();
     void loadingStartedOrStopped(bool started);
+    void loadingProgressChanged(qint64 bytesLoaded, qint64 bytesTotal);
     void histogramCalculated(std::vector<float> histogramData);
 
   private:
-    std::vector<unsigned short> m_volumeData;
+    constexpr static qint64 DEFAULT_TEXTURE_BUDGET =
+        2ll * 1024 * 1024 * 1024;
+    void allocateTexture();
+    void uploadSlices();
+    void uploadPyramid();
+    void uploadGradients();
+
+    QPointer<VolumeLoader> m_loader;
+    std::shared_ptr<const VolumeData> m_volumeData;
+    std::shared_ptr<const VolumePyramid> m_pyramid;
+    std::shared_ptr<const EmptySpaceGrid> m_emptySpaceGrid;
+    std::shared_ptr<const GradientVolume> m_gradients;
     QVector3D m_dims;
     QVector3D m_spacing;
     QOpenGLTexture m_volumeTexture;
+    QOpenGLTexture m_maximumTexture;
+    QOpenGLTexture m_occupancyTexture;
+    QOpenGLTexture m_gradientTexture;
+    bool m_gradientUploadNeeded{false};
+    bool m_occupancyUpdateNeeded{false};
+    unsigned int m_occupancyRevision{0};
+    std::vector<QVector3D> m_proxyGeometry;
+    unsigned int m_proxyGeometryRevision{0};
+    BrickCache m_brickCache;
+    qint64 m_textureBudget{DEFAULT_TEXTURE_BUDGET};
+    bool m_bricked{false};
     bool m_updateNeeded;
+    bool m_pyramidUploadNeeded{false};
+    int m_loadedSlices{0};
+    int m_uploadedSlices{0};
+    int m_uploadedMipLevels{1};
     bool m_loadingInProgress{false};
+    qint64 m_uploadedBytes{0};
+    qint64 m_uploadNanoseconds{0};
 };
 
 class VolumeLoader : public QThread
 {
     Q_OBJECT
   public:
-    VolumeLoader(const QString& fileName, QObject* parent);
+    VolumeLoader(const QString& fileName, VolumeData::LoadMode loadMode,
+                 qint64 textureBudget, QObject* parent);
     void run() override;
 
   signals:
-    void volumeLoaded(const std::vector<unsigned short>& m_volumeData);
-    void dimensionsChanged(QVector3D dims);
+    void volumeAllocated(std::shared_ptr<const VolumeData> volumeData);
+    void slicesLoaded(int loadedSlices);
+    void volumeLoaded();
+    void pyramidBuilt(std::shared_ptr<const VolumePyramid> pyramid);
+    void emptySpaceGridBuilt(std::shared_ptr<const EmptySpaceGrid> grid);
+    void gradientsComputed(std::shared_ptr<const GradientVolume> gradients);
     void loadingStartedOrStopped(bool started);
+    void loadingProgressChanged(qint64 bytesLoaded, qint64 bytesTotal);
     void gridSpacingChanged(QVector3D dims);
     void histogramCalculated(std::vector<float> histogramData);
 
@@ -53,7 +161,11 @@ class VolumeLoader : public QThread
     void loadIni();
     void load();
     QString m_fileName;
-    constexpr static QVector3D UNIFORM_GRID_DIMENSIONS{1, 1, 1};
+    VolumeData::LoadMode m_loadMode;
+    qint64 m_textureBudget;
+    // Slabs are sized in bytes rather than slices so that progress and
+    // uploads stay evenly paced for thin and wide volumes alike.
+    constexpr static qint64 SLAB_BYTES = 16 * 1024 * 1024;
 };
 
 #endif // VOLUME_H
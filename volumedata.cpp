@@ -0,0 +1,175 @@
+#include "volumedata.h"
+
+#include "tracer.h"
+#include "vendor/inireader/INIReader.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QSysInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <execution>
+
+namespace
+{
+constexpr qint64 HEADER_SIZE = 3 * sizeof(unsigned short);
+}
+
+std::shared_ptr<VolumeData> VolumeData::open(const QString& fileName,
+                                             LoadMode mode)
+{
+    std::shared_ptr<VolumeData> volumeData{new VolumeData{}};
+    volumeData->m_file = std::make_unique<QFile>(fileName);
+    if (!volumeData->m_file->open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Unable to open " << fileName << "!";
+        return nullptr;
+    }
+    if (!volumeData->readHeader(*volumeData->m_file))
+        return nullptr;
+
+    if (mode == LoadMode::MemoryMapped && volumeData->map())
+        return volumeData;
+    volumeData->allocate();
+    return volumeData;
+}
+
+std::shared_ptr<const VolumeData> VolumeData::fromFile(const QString& fileName,
+                                                       LoadMode mode)
+{
+    auto volumeData = open(fileName, mode);
+    if (!volumeData || !volumeData->readSlices(0, volumeData->depth()))
+        return nullptr;
+    return volumeData;
+}
+
+QVector3D VolumeData::gridSpacing(const QString& fileName)
+{
+    QString iniFileName = fileName;
+    iniFileName.chop(3);
+    iniFileName.append("ini");
+
+    INIReader reader{iniFileName.toStdString()};
+    if (reader.ParseError() != 0)
+    {
+        qDebug() << "INI-file not loaded.";
+        return QVector3D(1, 1, 1);
+    }
+    float x = reader.GetFloat("DatFile", "oldDat Spacing X", 1);
+    float y = reader.GetFloat("DatFile", "oldDat Spacing Y", 1);
+    float z = reader.GetFloat("DatFile", "oldDat Spacing Z", 1);
+    qDebug() << "X:" << x << "Y:" << y << "Z:" << z;
+    return QVector3D(x, y, z);
+}
+
+bool VolumeData::readHeader(QFile& file)
+{
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream >> m_width >> m_height >> m_depth;
+
+    qDebug() << "Width:" << m_width;
+    qDebug() << "Height:" << m_height;
+    qDebug() << "Depth:" << m_depth;
+
+    if (stream.status() != QDataStream::Ok || voxelCount() == 0)
+    {
+        qDebug() << "Invalid header in" << file.fileName();
+        return false;
+    }
+    if (file.size() < HEADER_SIZE + byteCount())
+    {
+        qDebug() << "Expected" << HEADER_SIZE + byteCount()
+                 << "bytes, but" << file.fileName() << "holds only"
+                 << file.size();
+        return false;
+    }
+    return true;
+}
+
+bool VolumeData::map()
+{
+    // The mapped samples are handed out as they are, so they have to be in
+    // host byte order already.
+    if constexpr (QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+        return false;
+
+    // The mapping lives as long as the file object stays open.
+    uchar* mapped = m_file->map(HEADER_SIZE, byteCount());
+    if (!mapped)
+    {
+        qDebug() << "Unable to map" << m_file->fileName()
+                 << ", falling back to streaming";
+        return false;
+    }
+    m_voxels = std::span<const unsigned short>{
+        reinterpret_cast<const unsigned short*>(mapped),
+        static_cast<std::size_t>(voxelCount())};
+    m_loadMode = LoadMode::MemoryMapped;
+    return true;
+}
+
+void VolumeData::allocate()
+{
+    m_buffer.resize(voxelCount());
+    m_voxels = m_buffer;
+    m_loadMode = LoadMode::Stream;
+}
+
+bool VolumeData::readSlices(int firstSlice, int sliceCount)
+{
+    if (firstSlice < 0 || sliceCount < 0 || firstSlice + sliceCount > m_depth)
+        return false;
+    const qint64 firstVoxel = firstSlice * sliceVoxelCount();
+    const qint64 voxels = sliceCount * sliceVoxelCount();
+
+    if (m_loadMode == LoadMode::MemoryMapped)
+    {
+        // Fault the pages in here, on the loading thread, rather than in the
+        // texture upload on the GUI thread.
+        constexpr qint64 PAGE_VOXELS = 4096 / sizeof(unsigned short);
+        volatile unsigned short sink = 0;
+        for (qint64 i = firstVoxel; i < firstVoxel + voxels; i += PAGE_VOXELS)
+        {
+            sink = m_voxels[i];
+        }
+        return true;
+    }
+
+    const qint64 bytes = voxels * static_cast<qint64>(sizeof(unsigned short));
+    if (!m_file->seek(HEADER_SIZE + firstVoxel * sizeof(unsigned short)) ||
+        m_file->read(reinterpret_cast<char*>(m_buffer.data() + firstVoxel),
+                     bytes) != bytes)
+    {
+        qDebug() << "Unable to read voxels from" << m_file->fileName();
+        return false;
+    }
+    if constexpr (QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+    {
+        auto first = m_buffer.begin() + firstVoxel;
+        std::for_each(std::execution::par_unseq, first, first + voxels,
+                      [](auto& elem) { elem = qFromLittleEndian(elem); });
+    }
+    return true;
+}
+
+std::vector<float> VolumeData::normalizedHistogram() const
+{
+    TRACE_ZONE("VolumeData::normalizedHistogram");
+    std::array<std::atomic<unsigned long long>, HISTOGRAM_BINS> histogramData{};
+    std::for_each(std::execution::par_unseq, m_voxels.begin(), m_voxels.end(),
+                  [&histogramData](auto elem) {
+                      histogramData[std::min<int>(elem, HISTOGRAM_BINS - 1)]++;
+                  });
+    unsigned long long maxCount =
+        *std::max_element(histogramData.begin(), histogramData.end());
+    std::vector<float> normalizedHistogramData(HISTOGRAM_BINS, 0);
+    std::transform(std::execution::par_unseq, histogramData.begin(),
+                   histogramData.end(), normalizedHistogramData.begin(),
+                   [maxCount](const auto& elem) {
+                       return static_cast<float>(elem) / maxCount;
+                   });
+    return normalizedHistogramData;
+}
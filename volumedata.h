@@ -0,0 +1,89 @@
+#ifndef VOLUMEDATA_H
+#define VOLUMEDATA_H
+
+#include <QFile>
+#include <QString>
+#include <QVector3D>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Voxels of a .dat volume: a 6-byte little-endian header holding width,
+// height and depth, followed by 12-bit samples stored as unsigned shorts.
+// The samples are kept exactly as they are stored in the file, either in a
+// read-only memory mapping of the file or in a heap buffer filled from a
+// stream. Consumers only ever see a span, so the mapped path never copies.
+//
+// open() only validates the header and reserves the storage; the z-slices are
+// then brought in with readSlices(), which lets a loader publish the volume
+// slab by slab. Slices that have not been read yet must not be accessed.
+class VolumeData
+{
+  public:
+    enum class LoadMode
+    {
+        Stream,
+        MemoryMapped
+    };
+
+    constexpr static int HISTOGRAM_BINS = 4096;
+    // Maps the stored 12-bit range onto the full range of a normalized
+    // 16-bit texture fetch.
+    constexpr static float INTENSITY_SCALE = 16.0f;
+
+    VolumeData(const VolumeData&) = delete;
+    VolumeData& operator=(const VolumeData&) = delete;
+
+    static std::shared_ptr<VolumeData> open(const QString& fileName,
+                                            LoadMode mode);
+    static std::shared_ptr<const VolumeData> fromFile(const QString& fileName,
+                                                      LoadMode mode);
+    bool readSlices(int firstSlice, int sliceCount);
+    // The grid spacing from the .ini file next to a .dat file, or a uniform
+    // spacing if there is none.
+    static QVector3D gridSpacing(const QString& fileName);
+
+    std::span<const unsigned short> voxels() const { return m_voxels; };
+    unsigned short width() const { return m_width; };
+    unsigned short height() const { return m_height; };
+    unsigned short depth() const { return m_depth; };
+    QVector3D dimensions() const
+    {
+        return QVector3D(m_width, m_height, m_depth);
+    };
+    qint64 voxelCount() const
+    {
+        return static_cast<qint64>(m_width) * m_height * m_depth;
+    };
+    qint64 byteCount() const
+    {
+        return voxelCount() * static_cast<qint64>(sizeof(unsigned short));
+    };
+    qint64 sliceVoxelCount() const
+    {
+        return static_cast<qint64>(m_width) * m_height;
+    };
+    qint64 sliceByteCount() const
+    {
+        return sliceVoxelCount() * static_cast<qint64>(sizeof(unsigned short));
+    };
+    LoadMode loadMode() const { return m_loadMode; };
+
+    std::vector<float> normalizedHistogram() const;
+
+  private:
+    VolumeData() = default;
+    bool readHeader(QFile& file);
+    bool map();
+    void allocate();
+
+    std::unique_ptr<QFile> m_file;
+    std::vector<unsigned short> m_buffer;
+    std::span<const unsigned short> m_voxels;
+    unsigned short m_width{0};
+    unsigned short m_height{0};
+    unsigned short m_depth{0};
+    LoadMode m_loadMode{LoadMode::Stream};
+};
+
+#endif // VOLUMEDATA_H
@@ -0,0 +1,104 @@
+#include "volumepyramid.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+std::shared_ptr<const VolumePyramid> VolumePyramid::build(const VolumeData& volume)
+{
+    auto pyramid = std::make_shared<VolumePyramid>();
+    const int count =
+        levelCount(volume.width(), volume.height(), volume.depth());
+    pyramid->m_levels.reserve(count);
+
+    const unsigned short* average = volume.voxels().data();
+    const unsigned short* maximum = volume.voxels().data();
+    int width = volume.width();
+    int height = volume.height();
+    int depth = volume.depth();
+    for (int i = 0; i < count; i++)
+    {
+        pyramid->m_levels.push_back(
+            downsample(average, maximum, width, height, depth));
+        const Level& level = pyramid->m_levels.back();
+        average = level.average.data();
+        maximum = level.maximum.data();
+        width = level.width;
+        height = level.height;
+        depth = level.depth;
+    }
+    return pyramid;
+}
+
+int VolumePyramid::levelCount(int width, int height, int depth)
+{
+    int count = 0;
+    while (std::max({width, height, depth}) > MIN_SIZE)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        depth = std::max(1, depth / 2);
+        count++;
+    }
+    return count;
+}
+
+VolumePyramid::Level VolumePyramid::downsample(const unsigned short* average,
+                                               const unsigned short* maximum,
+                                               int width, int height, int depth)
+{
+    Level level{std::max(1, width / 2), std::max(1, height / 2),
+                std::max(1, depth / 2)};
+    const std::size_t voxelCount =
+        static_cast<std::size_t>(level.width) * level.height * level.depth;
+    level.average.resize(voxelCount);
+    level.maximum.resize(voxelCount);
+
+    // The last block along an odd dimension also takes in the leftover
+    // voxel, so no maximum is lost to the rounding down of the level size.
+    auto blockEnd = [](int i, int levelSize, int size) {
+        return i == levelSize - 1 ? size : std::min(2 * i + 2, size);
+    };
+
+    std::vector<int> slices(level.depth);
+    std::iota(slices.begin(), slices.end(), 0);
+    std::for_each(
+        std::execution::par, slices.begin(), slices.end(), [&](int z) {
+            const int z1 = blockEnd(z, level.depth, depth);
+            for (int y = 0; y < level.height; y++)
+            {
+                const int y1 = blockEnd(y, level.height, height);
+                for (int x = 0; x < level.width; x++)
+                {
+                    const int x1 = blockEnd(x, level.width, width);
+                    unsigned int sum = 0;
+                    unsigned int count = 0;
+                    unsigned short blockMaximum = 0;
+                    for (int k = 2 * z; k < z1; k++)
+                    {
+                        for (int j = 2 * y; j < y1; j++)
+                        {
+                            const std::size_t row =
+                                (static_cast<std::size_t>(k) * height + j) *
+                                width;
+                            for (int i = 2 * x; i < x1; i++)
+                            {
+                                sum += average[row + i];
+                                blockMaximum =
+                                    std::max(blockMaximum, maximum[row + i]);
+                                count++;
+                            }
+                        }
+                    }
+                    const std::size_t index =
+                        (static_cast<std::size_t>(z) * level.height + y) *
+                            level.width +
+                        x;
+                    level.average[index] =
+                        static_cast<unsigned short>((sum + count / 2) / count);
+                    level.maximum[index] = blockMaximum;
+                }
+            }
+        });
+    return level;
+}
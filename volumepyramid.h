@@ -0,0 +1,44 @@
+#ifndef VOLUMEPYRAMID_H
+#define VOLUMEPYRAMID_H
+
+#include "volumedata.h"
+
+#include <memory>
+#include <vector>
+
+// Successive 2x2x2 downsamples of a volume, built once after loading. Every
+// level is kept twice: averaged, for direct volume rendering, and with the
+// maximum of each block, for maximum intensity projection where averaging
+// would dim small bright features. Level sizes follow the OpenGL mipmap rule
+// (halved and rounded down) so the levels fit straight into the mip chain of
+// the volume texture. Level 0 is the volume itself and is not stored here.
+class VolumePyramid
+{
+  public:
+    struct Level
+    {
+        int width;
+        int height;
+        int depth;
+        std::vector<unsigned short> average;
+        std::vector<unsigned short> maximum;
+    };
+
+    // Downsampling stops once the largest dimension is at most this size.
+    constexpr static int MIN_SIZE = 32;
+
+    static std::shared_ptr<const VolumePyramid> build(const VolumeData& volume);
+    // Number of levels below level 0 that a volume of the given size gets.
+    static int levelCount(int width, int height, int depth);
+
+    const std::vector<Level>& levels() const { return m_levels; };
+
+  private:
+    static Level downsample(const unsigned short* average,
+                            const unsigned short* maximum, int width,
+                            int height, int depth);
+
+    std::vector<Level> m_levels;
+};
+
+#endif // VOLUMEPYRAMID_H